@@ -0,0 +1,40 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "async_page_fetch.h"
+
+namespace badgerdb {
+
+bool PageFetch::await_ready() {
+  // Never blocks: a page being read in or latched by someone else suspends
+  // the coroutine, and an I/O thread waits for it instead.
+  return reader_->bufMgr_->readPageIfResident(*file_, page_number_, page_,
+                                              mode_);
+}
+
+void PageFetch::await_suspend(const std::coroutine_handle<> handle) {
+  // The coroutine may be resumed, and this object destroyed, as soon as the
+  // scheduler runs the handle, so nothing touches it after that.
+  reader_->io_->post([this, handle]() {
+    try {
+      reader_->bufMgr_->readPage(*file_, page_number_, page_, mode_);
+    } catch (...) {
+      error_ = std::current_exception();
+    }
+    reader_->scheduler_->schedule(handle);
+  });
+}
+
+Page *PageFetch::await_resume() {
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+  return page_;
+}
+
+}  // namespace badgerdb
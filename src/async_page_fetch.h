@@ -0,0 +1,134 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+
+#include "buffer.h"
+#include "executor.h"
+#include "file.h"
+#include "page_latch.h"
+
+namespace badgerdb {
+
+class AsyncPageReader;
+
+/**
+ * @brief Awaitable returned by AsyncPageReader::fetch().
+ *
+ * co_await yields the pinned page.  If the page is resident and its latch
+ * is free the awaiting coroutine does not suspend.  Otherwise it suspends
+ * while an I/O thread reads the page through the buffer manager or waits for
+ * the latch, and is then resumed on the scheduler, possibly on another
+ * thread.  Errors of the read, such as
+ * BufferExceededException, are rethrown from co_await.
+ */
+class PageFetch {
+ public:
+  bool await_ready();
+
+  void await_suspend(const std::coroutine_handle<> handle);
+
+  Page *await_resume();
+
+ private:
+  friend class AsyncPageReader;
+
+  PageFetch(AsyncPageReader *reader, File *file, const PageId page_number,
+            const LatchMode mode)
+      : reader_(reader),
+        file_(file),
+        page_number_(page_number),
+        mode_(mode),
+        page_(NULL) {}
+
+  /**
+   * Reader that created the fetch.
+   */
+  AsyncPageReader *reader_;
+
+  /**
+   * File holding the page.
+   */
+  File *file_;
+
+  /**
+   * Number of the page fetched.
+   */
+  PageId page_number_;
+
+  /**
+   * Latch taken on the page's frame.
+   */
+  LatchMode mode_;
+
+  /**
+   * The pinned page, once fetched.
+   */
+  Page *page_;
+
+  /**
+   * Error raised by a read on an I/O thread.
+   */
+  std::exception_ptr error_;
+};
+
+/**
+ * @brief Coroutine-friendly front end to BufMgr::readPage().
+ *
+ * Buffer pool hits are served on the calling thread.  Misses are handed to
+ * an I/O executor, whose threads block on the disk read, while the
+ * coroutine's thread is free to run other coroutines; the coroutine is
+ * resumed on the scheduler executor once its page is in the pool.  Pages are
+ * released with BufMgr::unPinPage() as usual.
+ *
+ * All methods are threadsafe.
+ */
+class AsyncPageReader {
+ public:
+  /**
+   * Constructs a reader.
+   *
+   * @param bufMgr     Buffer manager to read pages through.
+   * @param io         Executor performing reads that miss the pool.
+   * @param scheduler  Executor resuming coroutines after a miss.
+   */
+  AsyncPageReader(BufMgr *bufMgr, Executor *io, Executor *scheduler)
+      : bufMgr_(bufMgr), io_(io), scheduler_(scheduler) {}
+
+  /**
+   * Returns an awaitable pinning page <page_number> of <file> and latching
+   * it in <mode>.  <file> must outlive the co_await.
+   */
+  PageFetch fetch(File &file, const PageId page_number,
+                  const LatchMode mode = LatchMode::NONE) {
+    return PageFetch(this, &file, page_number, mode);
+  }
+
+ private:
+  friend class PageFetch;
+
+  /**
+   * Buffer manager to read pages through.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * Executor performing reads that miss the pool.
+   */
+  Executor *io_;
+
+  /**
+   * Executor resuming coroutines after a miss.
+   */
+  Executor *scheduler_;
+};
+
+}  // namespace badgerdb
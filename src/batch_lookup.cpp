@@ -0,0 +1,191 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "batch_lookup.h"
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Reads of the pages of one group that missed the pool, shared with the I/O
+ * threads.
+ */
+struct Completions {
+  std::mutex mutex;
+  std::condition_variable ready;
+  /**
+   * Chunks whose reads have finished, in the order they finished.
+   */
+  std::vector<std::size_t> finished;
+  /**
+   * Whether each read succeeded; a failed read leaves none of its pages
+   * pinned.
+   */
+  std::vector<bool> succeeded;
+  /**
+   * First error raised by a read.
+   */
+  std::exception_ptr error;
+};
+
+}  // namespace
+
+BatchLookup::BatchLookup(BufMgr *bufMgr, Executor *io,
+                         const std::size_t group_size)
+    : bufMgr_(bufMgr), io_(io), group_size_(group_size), hits_(0), misses_(0) {
+  assert(bufMgr_ != NULL);
+  assert(group_size_ > 0);
+}
+
+void BatchLookup::run(
+    File &file, const std::vector<PageId> &page_numbers,
+    const std::function<void(std::size_t, const Page &)> &fn) {
+  for (std::size_t begin = 0; begin < page_numbers.size();
+       begin += group_size_) {
+    const std::size_t end = std::min(begin + group_size_, page_numbers.size());
+    runGroup(file, page_numbers, begin, end, fn);
+  }
+}
+
+void BatchLookup::runGroup(
+    File &file, const std::vector<PageId> &page_numbers,
+    const std::size_t begin, const std::size_t end,
+    const std::function<void(std::size_t, const Page &)> &fn) {
+  const std::size_t count = end - begin;
+  std::vector<Page *> pages(count);
+  const std::size_t resident = bufMgr_->readPagesIfResident(
+      file, &page_numbers[begin], count, pages.data());
+  hits_ += resident;
+  misses_ += count - resident;
+
+  // The missed pages are read with BufMgr::readPages(), so their frames are
+  // reserved and published under one acquisition of the pool lock per call.
+  std::vector<std::size_t> missed;
+  std::vector<PageId> missed_numbers;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (pages[i] == NULL) {
+      missed.push_back(i);
+      missed_numbers.push_back(page_numbers[begin + i]);
+    }
+  }
+  std::vector<Page *> missed_pages(missed.size());
+  // With an executor, the misses are split among its threads so that their
+  // reads overlap.
+  const std::size_t threads = io_ == NULL ? 1 : io_->num_threads();
+  const std::size_t chunk_size =
+      std::max<std::size_t>(1, (missed.size() + threads - 1) / threads);
+  const std::size_t chunks = (missed.size() + chunk_size - 1) / chunk_size;
+  Completions completions;
+  completions.succeeded.assign(chunks, false);
+  if (io_ != NULL) {
+    for (std::size_t k = 0; k < chunks; ++k) {
+      const std::size_t first = k * chunk_size;
+      const std::size_t last = std::min(first + chunk_size, missed.size());
+      BufMgr *bufMgr = bufMgr_;
+      File *f = &file;
+      const PageId *numbers = &missed_numbers[first];
+      Page **out = &missed_pages[first];
+      Completions *c = &completions;
+      io_->post([bufMgr, f, numbers, out, c, k, first, last]() {
+        std::exception_ptr error;
+        try {
+          bufMgr->readPages(*f, numbers, last - first, out);
+        } catch (...) {
+          error = std::current_exception();
+        }
+        // Notified under the lock: once the group has seen the last chunk
+        // finish it returns and <c> is gone.
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (error && !c->error) {
+          c->error = error;
+        }
+        c->succeeded[k] = !error;
+        c->finished.push_back(k);
+        c->ready.notify_one();
+      });
+    }
+  }
+
+  // Pages are always released, even once <fn> has failed, so the group
+  // leaves nothing pinned behind.
+  std::exception_ptr error;
+  auto process = [&](const std::size_t i, Page *page) {
+    const PageId page_number = page_numbers[begin + i];
+    if (!error) {
+      try {
+        fn(begin + i, *page);
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+    bufMgr_->unPinPage(file, page_number, false);
+  };
+  auto process_chunk = [&](const std::size_t k) {
+    const std::size_t last = std::min((k + 1) * chunk_size, missed.size());
+    for (std::size_t m = k * chunk_size; m < last; ++m) {
+      process(missed[m], missed_pages[m]);
+    }
+  };
+
+  // Hits are processed while the misses are read.
+  for (std::size_t i = 0; i < count; ++i) {
+    if (pages[i] != NULL) {
+      process(i, pages[i]);
+    }
+  }
+  if (missed.empty()) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return;
+  }
+
+  if (io_ != NULL) {
+    // Each chunk is processed as soon as its read finishes, while the reads
+    // of the other chunks are still in flight.
+    std::unique_lock<std::mutex> lock(completions.mutex);
+    for (std::size_t handled = 0; handled < chunks; ++handled) {
+      completions.ready.wait(lock, [&completions, handled]() {
+        return completions.finished.size() > handled;
+      });
+      const std::size_t k = completions.finished[handled];
+      if (!completions.succeeded[k]) {
+        if (!error) {
+          error = completions.error;
+        }
+        continue;
+      }
+      lock.unlock();
+      process_chunk(k);
+      lock.lock();
+    }
+  } else if (!error) {
+    try {
+      bufMgr_->readPages(file, missed_numbers.data(), missed_numbers.size(),
+                         missed_pages.data());
+    } catch (...) {
+      error = std::current_exception();
+    }
+    if (!error) {
+      process_chunk(0);
+    }
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,111 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "buffer.h"
+#include "executor.h"
+#include "file.h"
+#include "page.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Runs many point lookups of one file together, hiding their memory
+ * and disk latency behind each other.
+ *
+ * The pages are processed in groups.  For each group the buffer pool's hash
+ * table is probed for all pages at once with prefetching, and the pages that
+ * miss are read together with BufMgr::readPages(), which reserves and
+ * publishes their frames under one acquisition of the pool lock each.  With
+ * an I/O executor the misses are split into one read task per executor
+ * thread, the pages that hit are processed while those reads are in flight,
+ * and the pages of each task are processed as soon as it finishes.  Each
+ * page stays pinned until it has been processed.
+ *
+ * @warning This class is not threadsafe; use one instance per thread.
+ */
+class BatchLookup {
+ public:
+  /**
+   * Number of pages per group unless given otherwise.
+   */
+  static const std::size_t DEFAULT_GROUP_SIZE = 16;
+
+  /**
+   * Constructs a batch lookup executor.
+   *
+   * @param bufMgr      Buffer manager to read pages through.
+   * @param io          Executor reading pages that miss the pool; if NULL
+   *                    they are read on the calling thread after the hits
+   *                    of their group.
+   * @param group_size  Number of pages looked up together.  Up to this many
+   *                    pages are pinned at a time, so it must be well below
+   *                    the number of buffer frames.
+   */
+  BatchLookup(BufMgr *bufMgr, Executor *io,
+              const std::size_t group_size = DEFAULT_GROUP_SIZE);
+
+  /**
+   * Calls <fn>(i, page) on the calling thread for every page number i of
+   * <page_numbers>, in no particular order.  If <fn> or a read throws, the
+   * remaining pages of the current group are still released, no further
+   * group is started and the first exception is rethrown.
+   */
+  void run(File &file, const std::vector<PageId> &page_numbers,
+           const std::function<void(std::size_t, const Page &)> &fn);
+
+  /**
+   * Returns the number of lookups served from the buffer pool so far.
+   */
+  std::size_t hits() const { return hits_; }
+
+  /**
+   * Returns the number of lookups that had to read their page so far.
+   */
+  std::size_t misses() const { return misses_; }
+
+ private:
+  /**
+   * Looks up page_numbers[begin, end).
+   */
+  void runGroup(File &file, const std::vector<PageId> &page_numbers,
+                const std::size_t begin, const std::size_t end,
+                const std::function<void(std::size_t, const Page &)> &fn);
+
+  /**
+   * Buffer manager to read pages through.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * Executor reading pages that miss the pool, or NULL.
+   */
+  Executor *io_;
+
+  /**
+   * Number of pages looked up together.
+   */
+  std::size_t group_size_;
+
+  /**
+   * Number of lookups served from the buffer pool.
+   */
+  std::size_t hits_;
+
+  /**
+   * Number of lookups that had to read their page.
+   */
+  std::size_t misses_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,85 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "batch_scanner.h"
+
+#include <cassert>
+
+namespace badgerdb {
+
+BatchScanner::BatchScanner(BufMgr *bufMgr, File *file,
+                           const std::size_t max_pages)
+    : bufMgr_(bufMgr),
+      file_(file),
+      max_pages_(max_pages),
+      next_page_(FileIterator(file).page_number()),
+      current_page_(NULL),
+      resume_slot_(Page::INVALID_SLOT) {
+  assert(bufMgr_ != NULL);
+  assert(max_pages_ > 0);
+}
+
+BatchScanner::~BatchScanner() { close(); }
+
+bool BatchScanner::next(RecordBatch &batch) {
+  releasePinned();
+  batch.clear();
+  while (!batch.full()) {
+    if (current_page_ == NULL) {
+      const PageId page_number = next_page_;
+      if (page_number == Page::INVALID_NUMBER) {
+        break;
+      }
+      if (pinned_.size() >= max_pages_) {
+        if (!batch.empty()) {
+          break;
+        }
+        // The pages pinned so far back no view; trade them for the next.
+        releasePinned();
+      }
+      bufMgr_->readPage(*file_, page_number, current_page_);
+      pinned_.push_back(page_number);
+      next_page_ = current_page_->next_page_number();
+      resume_slot_ = Page::INVALID_SLOT;
+    }
+    resume_slot_ = current_page_->appendRecordViews(resume_slot_, batch);
+    if (resume_slot_ == Page::INVALID_SLOT) {
+      // Page exhausted; its pin is kept until the batch is released.
+      current_page_ = NULL;
+    }
+  }
+  return !batch.empty();
+}
+
+bool BatchScanner::next(RecordBatch &batch, const Predicate &predicate) {
+  if (scratch_.capacity() != batch.capacity()) {
+    scratch_ = RecordBatch(batch.capacity());
+  }
+  batch.clear();
+  while (batch.empty() && next(scratch_)) {
+    predicate.filter(scratch_, batch, filter_scratch_);
+  }
+  return !batch.empty();
+}
+
+void BatchScanner::close() {
+  current_page_ = NULL;
+  releasePinned();
+  next_page_ = Page::INVALID_NUMBER;
+}
+
+void BatchScanner::releasePinned() {
+  // The page the scan resumes on is always the last one pinned.
+  const std::size_t keep = current_page_ != NULL ? 1 : 0;
+  for (std::size_t i = 0; i + keep < pinned_.size(); ++i) {
+    bufMgr_->unPinPage(*file_, pinned_[i], false /* dirty */);
+  }
+  pinned_.erase(pinned_.begin(), pinned_.end() - keep);
+}
+
+}  // namespace badgerdb
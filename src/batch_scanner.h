@@ -0,0 +1,145 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "file_iterator.h"
+#include "page.h"
+#include "predicate.h"
+#include "record_batch.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Scans the records of a file in batches of views into pinned pages.
+ *
+ * Each call to next() fills a RecordBatch with views of up to its capacity
+ * records, walking the used page list of the file and pinning every page the
+ * batch touches through the buffer manager.  The list is followed through the
+ * headers of the pinned pages, so every page is read once, through the
+ * buffer manager.  Pages backing a batch stay pinned
+ * until the following call to next() or until the scanner is closed, so the
+ * buffer pool must have at least as many free frames as pages one batch can
+ * span.  A scanner constructed with a page limit ends a batch early rather
+ * than pin more pages than that.
+ *
+ * @warning This class is not threadsafe.
+ */
+class BatchScanner {
+ public:
+  /**
+   * Page limit of a scanner that pins every page its batches span.
+   */
+  static const std::size_t UNLIMITED_PAGES = SIZE_MAX;
+
+  /**
+   * Constructs a scanner positioned at the first record of the file.
+   *
+   * @param bufMgr     Buffer manager used to pin pages.
+   * @param file       File to scan.
+   * @param max_pages  Maximum number of pages pinned at once; at least 1.
+   */
+  BatchScanner(BufMgr *bufMgr, File *file,
+               const std::size_t max_pages = UNLIMITED_PAGES);
+
+  /**
+   * Unpins any pages still held by the scanner.
+   */
+  ~BatchScanner();
+
+  BatchScanner(const BatchScanner &) = delete;
+  BatchScanner &operator=(const BatchScanner &) = delete;
+
+  /**
+   * Releases the pages backing the previous batch and fills <batch> with the
+   * next records of the file.
+   *
+   * @param batch Batch to fill; cleared first.
+   * @return  False if the scan is exhausted and <batch> is empty.
+   */
+  bool next(RecordBatch &batch);
+
+  /**
+   * Like next(), but only returns records matching <predicate>.  The
+   * predicate is evaluated on the page bytes, so records that do not match
+   * are never copied.  Keeps scanning until at least one record matches or
+   * the file is exhausted.
+   *
+   * @param batch     Batch to fill with matching records; cleared first.
+   * @param predicate Filter to apply.
+   * @return  False if the scan is exhausted and <batch> is empty.
+   */
+  bool next(RecordBatch &batch, const Predicate &predicate);
+
+  /**
+   * Unpins all pages held by the scanner and ends the scan.
+   */
+  void close();
+
+ private:
+  /**
+   * Unpins the pages backing the previous batch, except the page the scan
+   * will resume on.
+   */
+  void releasePinned();
+
+  /**
+   * Buffer manager pages are pinned through.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * File being scanned.
+   */
+  File *file_;
+
+  /**
+   * Maximum number of pages pinned at once.
+   */
+  std::size_t max_pages_;
+
+  /**
+   * Page the scan moves to once the current page is exhausted, taken from
+   * the pinned page's header; Page::INVALID_NUMBER at the end of the file.
+   */
+  PageId next_page_;
+
+  /**
+   * Page the scan is currently on; pinned if not NULL.
+   */
+  Page *current_page_;
+
+  /**
+   * Slot on the current page to resume after.
+   */
+  SlotId resume_slot_;
+
+  /**
+   * Unfiltered records read by the predicate variant of next().
+   */
+  RecordBatch scratch_;
+
+  /**
+   * Buffers the predicate variant of next() evaluates predicates in.
+   */
+  FilterScratch filter_scratch_;
+
+  /**
+   * Pages pinned on behalf of the last batch.
+   */
+  std::vector<PageId> pinned_;
+};
+
+}  // namespace badgerdb
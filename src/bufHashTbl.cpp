@@ -19,7 +19,7 @@
 
 namespace badgerdb {
 
-int BufHashTbl::hash(const File& file, const PageId pageNo) {
+int BufHashTbl::hash(const File& file, const PageId pageNo) const {
   auto hash =
       std::hash<std::string>{}(file.filename()) ^ std::hash<PageId>{}(pageNo);
   return hash % HTSIZE;
@@ -53,17 +53,27 @@ void BufHashTbl::insert(const File& file, const PageId pageNo,
 
 void BufHashTbl::lookup(const File& file, const PageId pageNo,
                         FrameId& frameNo) {
-  int index = hash(file, pageNo);
-  std::shared_ptr<hashBucket> tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo) {
-      frameNo = tmpBuc->frameNo;  // return frameNo by reference
-      return;
+  if (!find(file, pageNo, frameNo)) {
+    throw HashNotFoundException(file.filename(), pageNo);
+  }
+}
+
+bool BufHashTbl::find(const File& file, const PageId pageNo,
+                      FrameId& frameNo) const {
+  for (const hashBucket* bucket = ht[hash(file, pageNo)].get(); bucket != NULL;
+       bucket = bucket->next.get()) {
+    if (bucket->file == file && bucket->pageNo == pageNo) {
+      frameNo = bucket->frameNo;  // return frameNo by reference
+      return true;
     }
-    tmpBuc = tmpBuc->next;
   }
+  return false;
+}
 
-  throw HashNotFoundException(file.filename(), pageNo);
+void BufHashTbl::prefetch(const File& file, const PageId pageNo) {
+  // Only the slot's address is computed; loading the slot here would stall
+  // on the very miss the prefetch is meant to hide.
+  __builtin_prefetch(&ht[hash(file, pageNo)]);
 }
 
 void BufHashTbl::remove(const File& file, const PageId pageNo) {
@@ -62,7 +62,7 @@ class BufHashTbl {
    * @param pageNo  Page number in the file
    * @return  			Hash value.
    */
-  int hash(const File& file, const PageId pageNo);
+  int hash(const File& file, const PageId pageNo) const;
 
  public:
   /**
@@ -95,6 +95,28 @@ class BufHashTbl {
    */
   void lookup(const File& file, const PageId pageNo, FrameId& frameNo);
 
+  /**
+   * Like lookup(), but reports a missing entry by its return value instead of
+   * an exception, which is much cheaper on paths where misses are common.
+   *
+   * @param file  	File object
+   * @param pageNo	Page number in the file
+   * @param frameNo Frame number reference; set only if the entry is found
+   * @return True if the page entry was found
+   */
+  bool find(const File& file, const PageId pageNo, FrameId& frameNo) const;
+
+  /**
+   * Starts loading the table slot that (file, pageNo) hashes to into the
+   * CPU cache, so that a find() issued a little later does not stall on it.
+   * Only the slot's address is computed, so the call itself never waits for
+   * memory.  Has no other effect.
+   *
+   * @param file  	File object
+   * @param pageNo	Page number in the file
+   */
+  void prefetch(const File& file, const PageId pageNo);
+
   /**
    * Delete entry (file,pageNo) from hash table.
    *
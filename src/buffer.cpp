@@ -8,32 +8,55 @@
 
 #include "buffer.h"
 
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <utility>
 
 #include "exceptions/bad_buffer_exception.h"
 #include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/file_not_found_exception.h"
 #include "exceptions/hash_not_found_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_page_exception.h"
 
 namespace badgerdb {
 
 constexpr int HASHTABLE_SZ(int bufs) { return ((int)(bufs * 1.2) & -2) + 1; }
 
+
 //----------------------------------------
 // Constructor of the class BufMgr
 //----------------------------------------
 
-BufMgr::BufMgr(std::uint32_t bufs)
+BufMgr::BufMgr(std::uint32_t bufs, SsdCache* ssdCache, CompressedCache* compressedCache)
     : numBufs(bufs),
       hashTable(HASHTABLE_SZ(bufs)),
       bufDescTable(bufs),
+      freeFrames(bufs),
+      frameLatches(new FrameLatch[bufs]),
+      incomingSwips(bufs),
+      outgoingSwips(bufs),
+      ssdCache(ssdCache),
+      compressedCache(compressedCache),
+      accessCounter(0),
       bufPool(bufs) {
   for (FrameId i = 0; i < bufs; i++) {
     bufDescTable[i].frameNo = i;
     bufDescTable[i].valid = false;
+    bufPool[i].pool_ = this;
+  }
+
+  // every frame starts out free; push in reverse so frame 0 is used first
+  for (FrameId i = bufs; i > 0; i--) {
+    freeFrames.push(i - 1);
   }
 
   clockHand = bufs - 1;
@@ -50,47 +73,118 @@ void BufMgr::advanceClock() {
 /**
  * Allocate space in the buffer manager to place a frame
  * @param frame to be placed in the buffer manager
+ * @param lock holds the pool lock; released while a victim is written back
  */
-void BufMgr::allocBuf(FrameId& frame) {
+void BufMgr::allocBuf(FrameId& frame, std::unique_lock<std::mutex>& lock) {
 
 // find free frame using clock algorithm
-    bool isAllocated = false;
-    uint32_t num_frames_pinned = 0;
+    uint32_t num_frames_checked = 0;
 
-    while(!isAllocated) {
+    while(true) {
+        // frames that were never used or have been emptied need no eviction; checked on every round since
+        // other threads may free frames while a victim is written back
+        if (freeFrames.pop(frame)) {
+            bufDescTable[frame].clear();
+            return;
+        }
         // increment clock and number of frames checked every iteration
         advanceClock();
-        // check if we have searched all the buffer frames, throw exception if we have not gotten an allocated frame
-        if (num_frames_pinned >= numBufs) {
+        // two full sweeps clear every refbit, so a frame must have been found by then unless all are pinned
+        if (num_frames_checked++ >= 2 * numBufs) {
             throw BufferExceededException();
         }
-        // check if the current page is valid
-        if (bufDescTable[clockHand].valid) {
-            if (!bufDescTable[clockHand].refbit) {
-                if (bufDescTable[clockHand].pinCnt == 0) {
-                    isAllocated = true;
-                    // check if the frame chosen for allocation is dirty
-                    if (bufDescTable[clockHand].dirty) {
-                        bufDescTable[clockHand].file.writePage(bufPool[clockHand]); // here
-                    }
-                    hashTable.remove(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo);
-                    bufDescTable[clockHand].Set(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo); // set up frame
-                    frame = bufDescTable[clockHand].frameNo; // returned frame number
-                    bufDescTable[clockHand].clear();
-                } else {
-                    num_frames_pinned += 1;
-                }
-            } else {
-                bufDescTable[clockHand].refbit = false;
+        // invalid frames are on the free list
+        if (!bufDescTable[clockHand].valid) {
+            continue;
+        }
+        if (bufDescTable[clockHand].refbit) {
+            bufDescTable[clockHand].refbit = false;
+            continue;
+        }
+        if (bufDescTable[clockHand].pinCnt != 0) {
+            continue;
+        }
+        const FrameId victim = clockHand;
+        if (bufDescTable[victim].dirty || ssdCache != NULL || compressedCache != NULL) {
+            // the lock is released meanwhile; skip the frame if it was used in the meantime
+            if (!writeBackVictim(victim, lock)) {
+                continue;
             }
+        } else if (!tryUnswizzleFrame(victim)) {
+            // a page holding a swip to the frame is latched
+            continue;
         }
-        else { // if page is invalid, set up buffer frame and use it
-            isAllocated = true;
-            frame = bufDescTable[clockHand].frameNo; // returned frame number
-            bufDescTable[clockHand].clear();
+        hashTable.remove(bufDescTable[victim].file, bufDescTable[victim].pageNo);
+        frame = victim; // returned frame number
+        bufDescTable[victim].clear();
+        frameLatches[victim].retire();
+        return;
+    }
+
+}
+
+/**
+ * Writes back the page of a victim frame if it is dirty and adds it to the lower tiers, with the pool lock
+ * released. A copy of the page is written, taken while the frame is unpinned and so not being changed; the
+ * frame keeps a pin meanwhile so that nobody else evicts it.
+ *
+ * @param frameId unpinned frame chosen by the clock
+ * @param lock holds the pool lock
+ * @return true if the frame can be evicted now
+ */
+bool BufMgr::writeBackVictim(const FrameId frameId, std::unique_lock<std::mutex>& lock) {
+    BufDesc& desc = bufDescTable[frameId];
+    if (!tryUnswizzleFrame(frameId)) {
+        return false;
+    }
+    File file = desc.file;
+    const PageId pageNo = desc.pageNo;
+    const bool dirty = desc.dirty;
+    const Page copy = bufPool[frameId];
+    desc.pinCnt++;
+    desc.dirty = false;
+    desc.writing = true;
+    lock.unlock();
+
+    try {
+        if (dirty) {
+            std::lock_guard<std::shared_mutex> io(ioMutex(file));
+            file.writePage(copy);
         }
+    } catch (...) {
+        lock.lock();
+        desc.pinCnt--;
+        desc.dirty = true;
+        desc.writing = false;
+        writeBackDone.notify_all();
+        throw;
     }
+    const bool compressed = compressedCache != NULL && compressedCache->write(file, copy);
+    const bool ssd = ssdCache != NULL && ssdCache->write(file, copy);
 
+    lock.lock();
+    desc.pinCnt--;
+    desc.writing = false;
+    writeBackDone.notify_all();
+    if (dirty) {
+        bufStats.diskwrites++;
+    }
+    if (compressed) {
+        bufStats.compressedwrites++;
+    }
+    if (ssd) {
+        bufStats.ssdwrites++;
+    }
+    if (desc.dirty) {
+        // changed while it was written; the copies just added may be stale already
+        invalidateCopies(file, pageNo);
+        return false;
+    }
+    if (desc.pinCnt != 0 || desc.refbit) {
+        return false;
+    }
+    // swips may have been swizzled while the lock was released
+    return tryUnswizzleFrame(frameId);
 }
 
 /**
@@ -104,35 +198,650 @@ void BufMgr::allocBuf(FrameId& frame) {
  * Returns the pointer to the page being retrieved
  */
 void BufMgr::readPage(File& file, const PageId pageNo, Page*& page) {
+    readPage(file, pageNo, page, LatchMode::NONE);
+}
+
+/**
+ * Pins the given page like readPage(file, pageNo, page), then latches its frame in the given mode.
+ * The page is read and the latch taken after the pool lock is released, so waiting for either only blocks
+ * this thread.
+ *
+ * @param file to be allocated in the buffer manager
+ * @param pageNo is the page number that will be allocated
+ * @param page that will be allocated
+ * @param mode latch to take on the frame
+ */
+void BufMgr::readPage(File& file, const PageId pageNo, Page*& page, const LatchMode mode) {
 
     FrameId frameId; // fetch the current frame Id
-    bool isThrown = false; // default value is false, made true if exception is thrown
+    {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        frameId = pinPage(file, pageNo, lock);
+    }
+    latchFrame(frameId, mode);
 
-    // wrapping the page-fetching process inside a try-catch block to deal with the case when the page is not found
+    // return pointer to the page being retrieved
+    page = &bufPool[frameId];
+}
+
+/**
+ * Pins and latches a page if it is already in the buffer pool and its latch is free, without reading from disk
+ * or waiting for the latch.
+ *
+ * @param file file holding the page
+ * @param pageNo page number in the file
+ * @param page pointer to the page, set only if it is resident
+ * @param mode latch to take on the frame
+ * @return true if the page was resident and has been pinned and latched
+ */
+bool BufMgr::readPageIfResident(File& file, const PageId pageNo, Page*& page, const LatchMode mode) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    FrameId frameId;
+    // a page still being read in counts as not resident
+    if (!hashTable.find(file, pageNo, frameId) || bufDescTable[frameId].loading) {
+        return false;
+    }
+    // trying a latch never blocks, so it is safe under the pool lock
+    if (!tryLatchFrame(frameId, mode)) {
+        return false;
+    }
+    bufStats.accesses++;
+    pinFrame(frameId);
+    bufDescTable[frameId].lastUsed = ++accessCounter;
+    page = &bufPool[frameId];
+    return true;
+}
+
+std::size_t BufMgr::readPagesIfResident(File& file, const PageId* pageNos, const std::size_t count, Page** pages, const LatchMode mode) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    std::size_t hits = 0;
+    // start loading all hash table slots before the first lookup waits for one
+    for (std::size_t i = 0; i < count; i++) {
+        hashTable.prefetch(file, pageNos[i]);
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        FrameId frameId;
+        // a page still being read in, or whose latch is taken, counts as not resident
+        if (!hashTable.find(file, pageNos[i], frameId) || bufDescTable[frameId].loading
+            || !tryLatchFrame(frameId, mode)) {
+            pages[i] = NULL;
+            continue;
+        }
+        bufStats.accesses++;
+        pinFrame(frameId);
+        bufDescTable[frameId].lastUsed = ++accessCounter;
+        pages[i] = &bufPool[frameId];
+        hits++;
+    }
+    return hits;
+}
+
+/**
+ * Pins a batch of pages. Frames for all missing pages are reserved and latched exclusively under one
+ * acquisition of the pool lock, the pages are read with the lock released, and they are published under a
+ * second acquisition. Pages another thread is reading are waited for afterwards.
+ *
+ * @param file file holding the pages
+ * @param pageNos page numbers to read
+ * @param count number of entries in pageNos and pages
+ * @param pages set to the pinned pages
+ */
+void BufMgr::readPages(File& file, const PageId* pageNos, const std::size_t count, Page** pages) {
+    // index of the page and frame for every page this call reads, and pages other threads are reading
+    std::vector<std::pair<std::size_t, FrameId>> loads;
+    std::vector<std::size_t> waits;
+    std::exception_ptr error;
+    std::fill(pages, pages + count, (Page*)NULL);
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    for (std::size_t i = 0; i < count; i++) {
+        hashTable.prefetch(file, pageNos[i]);
+    }
+    for (std::size_t i = 0; i < count && !error; i++) {
+        bufStats.accesses++;
+        FrameId frameId;
+        if (!hashTable.find(file, pageNos[i], frameId)) {
+            try {
+                allocBuf(frameId, lock);
+            } catch (...) {
+                error = std::current_exception();
+                break;
+            }
+            FrameId residentId;
+            if (!hashTable.find(file, pageNos[i], residentId)) {
+                bufDescTable[frameId].Set(file, pageNos[i]);
+                bufDescTable[frameId].loading = true;
+                bufDescTable[frameId].lastUsed = ++accessCounter;
+                hashTable.insert(file, pageNos[i], frameId);
+                const bool latched = frameLatches[frameId].tryLockExclusive();
+                assert(latched);
+                (void)latched;
+                loads.emplace_back(i, frameId);
+                pages[i] = &bufPool[frameId];
+                continue;
+            }
+            // another thread brought the page in while allocBuf released the lock
+            freeFrames.push(frameId);
+            frameId = residentId;
+        }
+        pinFrame(frameId);
+        bufDescTable[frameId].lastUsed = ++accessCounter;
+        pages[i] = &bufPool[frameId];
+        // a page repeated in the batch may be one we are about to read ourselves
+        if (bufDescTable[frameId].loading &&
+            std::find_if(loads.begin(), loads.end(), [frameId](const std::pair<std::size_t, FrameId>& load) {
+                return load.second == frameId;
+            }) == loads.end()) {
+            waits.push_back(i);
+        }
+    }
+    lock.unlock();
+
+    // the frames are latched exclusively, so the pages are read straight into them; pages in neither
+    // lower tier are read from the file together
+    std::vector<PageSource> sources(loads.size(), PageSource::FILE);
+    std::vector<PageId> fileNumbers;
+    std::vector<Page*> filePages;
+    for (std::size_t l = 0; l < loads.size(); l++) {
+        const PageId pageNo = pageNos[loads[l].first];
+        Page* frame = &bufPool[loads[l].second];
+        if (compressedCache != NULL && compressedCache->read(file, pageNo, frame)) {
+            sources[l] = PageSource::COMPRESSED_CACHE;
+        } else if (ssdCache != NULL && ssdCache->read(file, pageNo, frame)) {
+            sources[l] = PageSource::SSD_CACHE;
+        } else {
+            fileNumbers.push_back(pageNo);
+            filePages.push_back(frame);
+        }
+    }
+    std::exception_ptr fileError;
     try {
-        // fetch pointer to page we're trying to read
-        hashTable.lookup(file, pageNo, frameId); // here
-    } catch (HashNotFoundException const&) {
+        std::shared_lock<std::shared_mutex> io(ioMutex(file));
+        file.preadPages(fileNumbers.data(), fileNumbers.size(), filePages.data());
+    } catch (...) {
+        fileError = std::current_exception();
+    }
+
+    lock.lock();
+    for (std::size_t l = 0; l < loads.size(); l++) {
+        BufDesc& desc = bufDescTable[loads[l].second];
+        desc.loading = false;
+        if (fileError && sources[l] == PageSource::FILE) {
+            hashTable.remove(file, desc.pageNo);
+            desc.failed = true;
+            if (!error) {
+                error = fileError;
+            }
+        } else {
+            countMissingPage(sources[l]);
+        }
+        frameLatches[loads[l].second].unlockExclusive();
+    }
+    // wait for pages other threads are reading only once our own latches are released, so that two batches
+    // never wait for each other
+    if (!waits.empty()) {
+        lock.unlock();
+        for (const std::size_t i : waits) {
+            const FrameId frameId = pages[i] - bufPool.data();
+            frameLatches[frameId].lockShared();
+            frameLatches[frameId].unlockShared();
+        }
+        lock.lock();
+    }
+    for (const std::size_t i : waits) {
+        const FrameId frameId = pages[i] - bufPool.data();
+        if (bufDescTable[frameId].failed && !error) {
+            // the other thread's read failed; try it ourselves
+            releaseFailedPin(frameId);
+            pages[i] = NULL;
+            try {
+                pages[i] = &bufPool[pinPage(file, pageNos[i], lock)];
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (!error) {
+        return;
+    }
+    // release everything pinned above before reporting the error
+    for (std::size_t i = 0; i < count; i++) {
+        if (pages[i] == NULL) {
+            continue;
+        }
+        const FrameId frameId = pages[i] - bufPool.data();
+        if (bufDescTable[frameId].failed) {
+            releaseFailedPin(frameId);
+        } else {
+            bufDescTable[frameId].pinCnt--;
+        }
+        pages[i] = NULL;
+    }
+    std::rethrow_exception(error);
+}
+
+/**
+ * Pins a page, reading it into a newly allocated frame if it is not resident.
+ * The frame is entered in the hash table and latched exclusively before the pool lock is released for the
+ * read, so threads asking for the same page meanwhile pin the frame and wait on its latch.
+ *
+ * @param file file holding the page
+ * @param pageNo page number in the file
+ * @param lock holds the pool lock; released while waiting for or reading the page
+ * @return frame holding the page
+ */
+FrameId BufMgr::pinPage(File& file, const PageId pageNo, std::unique_lock<std::mutex>& lock) {
+
+    FrameId frameId; // fetch the current frame Id
+    bufStats.accesses++;
+
+    while (true) {
+        if (hashTable.find(file, pageNo, frameId)) {
+            pinFrame(frameId);
+            bufDescTable[frameId].lastUsed = ++accessCounter;
+            if (!bufDescTable[frameId].loading) {
+                return frameId;
+            }
+            // another thread is reading the page in and holds the latch until it is done; our pin keeps
+            // the frame from being reused meanwhile
+            lock.unlock();
+            frameLatches[frameId].lockShared();
+            frameLatches[frameId].unlockShared();
+            lock.lock();
+            if (!bufDescTable[frameId].failed) {
+                return frameId;
+            }
+            // the read failed; try it ourselves
+            releaseFailedPin(frameId);
+            continue;
+        }
 
         // new frame is allocated from the buffer pool for reading page not present
-        allocBuf(frameId);
-        Page pageTemp = file.readPage(pageNo);
+        allocBuf(frameId, lock);
+        FrameId residentId;
+        if (!hashTable.find(file, pageNo, residentId)) {
+            break;
+        }
+        // another thread brought the page in while allocBuf released the lock
+        freeFrames.push(frameId);
+    }
+
+    BufDesc& desc = bufDescTable[frameId];
+    desc.Set(file, pageNo);
+    desc.loading = true;
+    desc.lastUsed = ++accessCounter;
+    hashTable.insert(file, pageNo, frameId);
+    // nobody holds or waits for the latch of a newly allocated frame, so this cannot fail
+    const bool latched = frameLatches[frameId].tryLockExclusive();
+    assert(latched);
+    (void)latched;
+    lock.unlock();
+
+    PageSource source;
+    try {
+        Page pageTemp{Page::Uninitialized()};
+        source = readMissingPage(file, pageNo, pageTemp);
         bufPool[frameId] = pageTemp;
-        bufDescTable[frameId].Set(file, pageNo);
-        hashTable.insert(file, pageNo, frameId); // here
-        isThrown = true; // change isThrown to true
+    } catch (...) {
+        lock.lock();
+        hashTable.remove(file, pageNo);
+        desc.loading = false;
+        desc.failed = true;
+        frameLatches[frameId].unlockExclusive();
+        releaseFailedPin(frameId);
+        throw;
     }
 
-    if(!isThrown) {
-        // increase pin count by 1 and change refbit to true if this requested page is already present in the buffer pool
+    lock.lock();
+    countMissingPage(source);
+    desc.loading = false;
+    // releasing a latch never blocks, so it is safe under the pool lock
+    frameLatches[frameId].unlockExclusive();
+    return frameId;
+}
+
+/**
+ * Reads a page missing from the pool from the compressed cache, the SSD cache or its file, in that order.
+ * Runs without the pool lock; the caches are threadsafe and file reads only exclude writes to the same file.
+ *
+ * @param file file holding the page
+ * @param pageNo page number in the file
+ * @param page set to the contents of the page
+ * @return tier the page was read from
+ */
+BufMgr::PageSource BufMgr::readMissingPage(File& file, const PageId pageNo, Page& page) {
+    if (compressedCache != NULL && compressedCache->read(file, pageNo, &page)) {
+        return PageSource::COMPRESSED_CACHE;
+    }
+    if (ssdCache != NULL && ssdCache->read(file, pageNo, &page)) {
+        return PageSource::SSD_CACHE;
+    }
+    // reads of the same file may overlap; only writes need the file to themselves
+    std::shared_lock<std::shared_mutex> io(ioMutex(file));
+    page = file.preadPage(pageNo);
+    return PageSource::FILE;
+}
+
+/**
+ * Counts the hits and misses of the tiers for a page read by readMissingPage.
+ *
+ * @param source tier the page was read from
+ */
+void BufMgr::countMissingPage(const PageSource source) {
+    if (compressedCache != NULL) {
+        if (source == PageSource::COMPRESSED_CACHE) {
+            bufStats.compressedhits++;
+            return;
+        }
+        bufStats.compressedmisses++;
+    }
+    if (ssdCache != NULL) {
+        if (source == PageSource::SSD_CACHE) {
+            bufStats.ssdhits++;
+            return;
+        }
+        bufStats.ssdmisses++;
+    }
+    bufStats.diskreads++;
+}
+
+/**
+ * Drops a pin on a frame whose page could not be read. The last pin frees the frame.
+ *
+ * @param frameId frame whose read failed
+ */
+void BufMgr::releaseFailedPin(const FrameId frameId) {
+    if (--bufDescTable[frameId].pinCnt == 0) {
+        bufDescTable[frameId].clear();
+        frameLatches[frameId].retire();
+        freeFrames.push(frameId);
+    }
+}
+
+/**
+ * Waits until no page of the file is being written back by allocBuf, so that the frames of the file can be
+ * flushed or dropped.
+ *
+ * @param file file whose frames are about to be flushed or dropped
+ * @param lock holds the pool lock
+ */
+void BufMgr::waitForWriteBacks(File& file, std::unique_lock<std::mutex>& lock) {
+    writeBackDone.wait(lock, [this, &file]() {
+        for (FrameId index = 0; index < numBufs; index++) {
+            if (bufDescTable[index].writing && file == bufDescTable[index].file) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+/**
+ * Returns the mutex serializing I/O on a file.
+ *
+ * @param file file about to be read or written
+ */
+std::shared_mutex& BufMgr::ioMutex(const File& file) {
+    return ioMutexes[std::hash<std::string>()(file.filename()) % IO_MUTEXES];
+}
+
+/**
+ * Sets the next page number of a resident page after the file changed it on disk, so that scans following the
+ * used list through pinned pages see the change. A page being read in may have missed the change, so it is
+ * waited for first.
+ *
+ * @param file file holding the page
+ * @param pageNo page whose link changed, or Page::INVALID_NUMBER for none
+ * @param next new next page number
+ * @param lock holds the pool lock; released while waiting for the page
+ */
+void BufMgr::relinkFrame(File& file, const PageId pageNo, const PageId next, std::unique_lock<std::mutex>& lock) {
+    FrameId frameId;
+    if (pageNo == Page::INVALID_NUMBER || !hashTable.find(file, pageNo, frameId)) {
+        return;
+    }
+    if (bufDescTable[frameId].loading) {
+        // our pin keeps the frame from being reused while we wait
         bufDescTable[frameId].pinCnt++;
-        bufDescTable[frameId].refbit = true;
+        lock.unlock();
+        frameLatches[frameId].lockShared();
+        frameLatches[frameId].unlockShared();
+        lock.lock();
+        if (bufDescTable[frameId].failed) {
+            releaseFailedPin(frameId);
+            return;
+        }
+        bufDescTable[frameId].pinCnt--;
     }
+    bufPool[frameId].header_.next_page_number = next;
+}
 
-    // return pointer to the page being retrieved
+/**
+ * Drops the copies of a page from the lower tiers, before it changes or goes away.
+ *
+ * @param file file holding the page
+ * @param pageNo page number in the file
+ */
+void BufMgr::invalidateCopies(File& file, const PageId pageNo) {
+    if (compressedCache != NULL) {
+        compressedCache->invalidate(file, pageNo);
+    }
+    if (ssdCache != NULL) {
+        ssdCache->invalidate(file, pageNo);
+    }
+}
+
+/**
+ * Drops the copies of all pages of a file from the lower tiers.
+ *
+ * @param file file whose pages are dropped
+ */
+void BufMgr::invalidateFileCopies(File& file) {
+    if (compressedCache != NULL) {
+        compressedCache->invalidateFile(file);
+    }
+    if (ssdCache != NULL) {
+        ssdCache->invalidateFile(file);
+    }
+}
+
+/**
+ * Adds a pin to a frame that already holds a page. The caller must hold the pool lock.
+ *
+ * @param frameId frame to pin
+ */
+void BufMgr::pinFrame(const FrameId frameId) {
+    // increase pin count by 1 and change refbit to true if this requested page is already present in the buffer pool
+    bufDescTable[frameId].pinCnt++;
+    bufDescTable[frameId].refbit = true;
+    bufDescTable[frameId].hits++;
+}
+
+/**
+ * Takes the latch of a pinned frame in the given mode. The pin keeps the frame from being reused while we
+ * wait for the latch, so the pool lock must not be held.
+ *
+ * @param frameId frame to latch
+ * @param mode latch to take
+ */
+void BufMgr::latchFrame(const FrameId frameId, const LatchMode mode) {
+    if (mode == LatchMode::SHARED) {
+        frameLatches[frameId].lockShared();
+    } else if (mode == LatchMode::EXCLUSIVE) {
+        frameLatches[frameId].lockExclusive();
+    }
+}
+
+/**
+ * Takes the latch of a frame in the given mode if that is possible without waiting.
+ *
+ * @param frameId frame to latch
+ * @param mode latch to take
+ * @return true if the latch was taken
+ */
+bool BufMgr::tryLatchFrame(const FrameId frameId, const LatchMode mode) {
+    if (mode == LatchMode::SHARED) {
+        return frameLatches[frameId].tryLockShared();
+    } else if (mode == LatchMode::EXCLUSIVE) {
+        return frameLatches[frameId].tryLockExclusive();
+    }
+    return true;
+}
+
+/**
+ * Pins and latches the page a swip refers to. A swizzled swip leads straight to its frame; otherwise the
+ * page is looked up as in readPage and the swip is swizzled to its frame.
+ *
+ * @param file file holding the referenced page
+ * @param owner pinned page holding the swip
+ * @param swip swip inside owner
+ * @param page pointer to the referenced page, returned via this reference
+ * @param mode latch to take on the referenced frame
+ */
+void BufMgr::fixSwip(File& file, Page* owner, Swip& swip, Page*& page, const LatchMode mode) {
+    FrameId frameId;
+    {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        // swips only change under the pool lock, so this read is stable
+        if (swip.isSwizzled()) {
+            frameId = swip.frame();
+            pinFrame(frameId);
+            bufDescTable[frameId].lastUsed = ++accessCounter;
+            bufStats.accesses++;
+        } else {
+            frameId = pinPage(file, swip.page_number(), lock);
+            // another thread may have swizzled the swip while the page was read
+            if (!swip.isSwizzled()) {
+                const FrameId ownerFrame = owner - bufPool.data();
+                swip.swizzle(frameId);
+                incomingSwips[frameId].emplace_back(ownerFrame, &swip);
+                outgoingSwips[ownerFrame].emplace_back(frameId, &swip);
+            }
+        }
+    }
+    latchFrame(frameId, mode);
     page = &bufPool[frameId];
 }
 
+/**
+ * Returns the number of the page a swip refers to.
+ *
+ * @param swip swip to decode
+ */
+PageId BufMgr::swipPageNumber(const Swip& swip) const {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return swip.isSwizzled() ? bufDescTable[swip.frame()].pageNo : swip.page_number();
+}
+
+/**
+ * Restores the page number of a swizzled swip and removes it from the swip lists. The caller is the thread
+ * changing the page holding the swip, so the swip is rewritten without taking that page's latch.
+ *
+ * @param owner pinned page holding the swip
+ * @param swip swip to forget
+ */
+void BufMgr::forgetSwip(const Page* owner, Swip* swip) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    std::vector<std::pair<FrameId, Swip*>>& outgoing = outgoingSwips[owner - bufPool.data()];
+    for (const std::pair<FrameId, Swip*>& ref : outgoing) {
+        if (ref.second == swip) {
+            swip->unswizzle(bufDescTable[ref.first].pageNo);
+            eraseSwip(incomingSwips[ref.first], swip);
+            eraseSwip(outgoing, swip);
+            return;
+        }
+    }
+}
+
+/**
+ * Restores the page numbers of all swips that refer to a frame or are stored in its page, before the
+ * frame gives up its page or the page is written. The page holding the swips is latched exclusively while
+ * they are rewritten, so that threads holding its latch never see them change and optimistic readers see
+ * its version move on. Busy latches are skipped rather than waited for. The caller must hold the pool lock.
+ *
+ * @param frameId frame whose swips are unswizzled
+ * @return true if no swip of the frame is left swizzled
+ */
+bool BufMgr::tryUnswizzleFrame(const FrameId frameId) {
+    // swips held by the frame's own page
+    std::vector<std::pair<FrameId, Swip*>>& outgoing = outgoingSwips[frameId];
+    if (!outgoing.empty()) {
+        if (!frameLatches[frameId].tryLockExclusive()) {
+            return false;
+        }
+        for (const std::pair<FrameId, Swip*>& ref : outgoing) {
+            ref.second->unswizzle(bufDescTable[ref.first].pageNo);
+            eraseSwip(incomingSwips[ref.first], ref.second);
+        }
+        outgoing.clear();
+        frameLatches[frameId].unlockExclusive();
+    }
+    // swips in other pages referring to the frame, one owner page at a time
+    std::vector<std::pair<FrameId, Swip*>>& incoming = incomingSwips[frameId];
+    std::size_t busy = 0;
+    while (incoming.size() > busy) {
+        const FrameId owner = incoming[busy].first;
+        if (!frameLatches[owner].tryLockExclusive()) {
+            // keep the swips of busy owners at the front
+            for (std::size_t i = busy; i < incoming.size(); i++) {
+                if (incoming[i].first == owner) {
+                    std::swap(incoming[i], incoming[busy++]);
+                }
+            }
+            continue;
+        }
+        for (std::size_t i = busy; i < incoming.size();) {
+            if (incoming[i].first == owner) {
+                incoming[i].second->unswizzle(bufDescTable[frameId].pageNo);
+                eraseSwip(outgoingSwips[owner], incoming[i].second);
+                incoming[i] = incoming.back();
+                incoming.pop_back();
+            } else {
+                i++;
+            }
+        }
+        frameLatches[owner].unlockExclusive();
+    }
+    return incoming.empty();
+}
+
+/**
+ * Restores the page numbers of all swips of a frame like tryUnswizzleFrame, waiting for the latches of the
+ * pages holding them with the pool lock released. Both frames are pinned meanwhile so that neither is reused.
+ *
+ * @param frameId frame whose swips are unswizzled
+ * @param lock holds the pool lock
+ */
+void BufMgr::unswizzleFrame(const FrameId frameId, std::unique_lock<std::mutex>& lock) {
+    while (!tryUnswizzleFrame(frameId)) {
+        const FrameId owner = outgoingSwips[frameId].empty() ? incomingSwips[frameId].front().first : frameId;
+        bufDescTable[frameId].pinCnt++;
+        bufDescTable[owner].pinCnt++;
+        lock.unlock();
+        frameLatches[owner].lockExclusive();
+        frameLatches[owner].unlockExclusive();
+        lock.lock();
+        bufDescTable[owner].pinCnt--;
+        bufDescTable[frameId].pinCnt--;
+    }
+}
+
+/**
+ * Removes a swip from a frame's list of swips.
+ *
+ * @param swips list to remove from
+ * @param swip swip to remove
+ */
+void BufMgr::eraseSwip(std::vector<std::pair<FrameId, Swip*>>& swips, const Swip* swip) {
+    for (std::size_t i = 0; i < swips.size(); i++) {
+        if (swips[i].second == swip) {
+            swips[i] = swips.back();
+            swips.pop_back();
+            return;
+        }
+    }
+}
+
 /**
  * Unpin a page from memory since it is no longer required for it to remain in memory.
  *
@@ -142,7 +851,21 @@ void BufMgr::readPage(File& file, const PageId pageNo, Page*& page) {
  * @throws PageNotPinnedException thrown if the page's pin count is already 0
  */
 void BufMgr::unPinPage(File& file, const PageId pageNo, const bool dirty) {
+    unPinPage(file, pageNo, dirty, LatchMode::NONE);
+}
 
+/**
+ * Releases the latch taken by readPage in the given mode, then unpins the page.
+ *
+ * @param file to be accessed in the buffer manager
+ * @param pageNo is the page number of the page we're trying to unpin
+ * @param dirty  if we have to marked the unpinned page as dirty, we set this to true; false otherwise
+ * @param mode latch held on the frame
+ * @throws PageNotPinnedException thrown if the page's pin count is already 0
+ */
+void BufMgr::unPinPage(File& file, const PageId pageNo, const bool dirty, const LatchMode mode) {
+
+    std::lock_guard<std::mutex> lock(poolMutex);
     FrameId frameId; // fetch the current frame Id
     bool isThrown = false;// default value is false, made true if exception is thrown
 
@@ -163,13 +886,77 @@ void BufMgr::unPinPage(File& file, const PageId pageNo, const bool dirty) {
         }
         // ...Otherwise, decrease the page's pin count by 1 and check if dirty bit should be set to true
         else {
+            // releasing a latch never blocks, so it is safe under the pool lock
+            if (mode == LatchMode::SHARED) {
+                frameLatches[frameId].unlockShared();
+            } else if (mode == LatchMode::EXCLUSIVE) {
+                frameLatches[frameId].unlockExclusive();
+            }
             bufDescTable[frameId].pinCnt--;
-            if(dirty)
+            if(dirty) {
+                // copies in the lower tiers are about to become stale
+                if (!bufDescTable[frameId].dirty) {
+                    invalidateCopies(file, pageNo);
+                }
                 bufDescTable[frameId].dirty = true;
+            }
         }
     }
 }
 
+/**
+ * Pins the page under a shared latch, so no writer is active, and records its frame and version.
+ *
+ * @param file file holding the page
+ * @param pageNo page number in the file
+ * @return handle for optimistic reads of the page
+ */
+PageHandle BufMgr::readHandle(File& file, const PageId pageNo) {
+    Page* page;
+    readPage(file, pageNo, page, LatchMode::SHARED);
+    const FrameId frameId = page - bufPool.data();
+    const PageHandle handle = {frameId, frameLatches[frameId].version()};
+    unPinPage(file, pageNo, false, LatchMode::SHARED);
+    return handle;
+}
+
+/**
+ * Returns the page in the frame of a handle without pinning or latching it.
+ *
+ * @param handle handle returned by readHandle
+ */
+const Page* BufMgr::optimisticPage(const PageHandle& handle) const {
+    return &bufPool[handle.frame];
+}
+
+/**
+ * Checks that the frame of a handle still holds the same, unmodified page.
+ *
+ * @param handle handle returned by readHandle
+ */
+bool BufMgr::validate(const PageHandle& handle) const {
+    return handle.frame < numBufs && frameLatches[handle.frame].validate(handle.version);
+}
+
+/**
+ * Returns the version of the frame holding a pinned page.
+ *
+ * @param page pointer returned by readPage or allocPage
+ */
+std::uint64_t BufMgr::pageVersion(const Page* page) const {
+    return frameLatches[page - bufPool.data()].version();
+}
+
+/**
+ * Checks that a pinned page has not been latched exclusively since its version was read.
+ *
+ * @param page pointer returned by readPage or allocPage
+ * @param version value returned by pageVersion
+ */
+bool BufMgr::validatePage(const Page* page, const std::uint64_t version) const {
+    return frameLatches[page - bufPool.data()].validate(version);
+}
+
 /**
  * Allocate a page within the buffer manager
  * @param file to be allocated in the buffer manager
@@ -179,22 +966,42 @@ void BufMgr::unPinPage(File& file, const PageId pageNo, const bool dirty) {
  * Returns pageNo and page by updating the pointers
  */
 void BufMgr::allocPage(File& file, PageId& pageNo, Page*& page) {
+    // allocate the new page and then get the page number from it; the pool lock is not needed for that
+    Page newPage{Page::Uninitialized()};
+    PageId previous;
+    {
+        std::lock_guard<std::shared_mutex> io(ioMutex(file));
+        newPage = file.allocatePage(&previous); // here
+    }
 
+    std::unique_lock<std::mutex> lock(poolMutex);
     // create frameId store frame number returned from allocation in buffer
     FrameId frameNo;
-    allocBuf(frameNo) ;// I think this is how I'm supposed to do this...
-
-    // allocate the new page and then get the page number from it
-    Page newPage = file.allocatePage(); // here
+    try {
+        allocBuf(frameNo, lock);
+    } catch (...) {
+        // give the page back so that the file is left as it was
+        lock.unlock();
+        std::lock_guard<std::shared_mutex> io(ioMutex(file));
+        file.deletePage(newPage.page_number());
+        throw;
+    }
+    bufStats.accesses++;
+    bufStats.diskreads++;
     // pageNo = newPage.page_number(); // here
 
     // add the page in the proper buffer frame and set the page pointer to this new page in the buffer
+    frameLatches[frameNo].beginRewrite();
     bufPool[frameNo] = newPage;
+    frameLatches[frameNo].endRewrite();
     page = &bufPool[frameNo];
     pageNo = bufPool[frameNo].page_number();
+    // a reused page number may still have old copies in the lower tiers
+    invalidateCopies(file, pageNo);
 
     // call set function to set up new frame in buffer
     bufDescTable[frameNo].Set(file, pageNo);
+    bufDescTable[frameNo].lastUsed = ++accessCounter;
 
     //finally insert into hashtable, catching any exceptions
 //    try {
@@ -203,17 +1010,20 @@ void BufMgr::allocPage(File& file, PageId& pageNo, Page*& page) {
 //        // do nothing if insufficient space
 //    }
     hashTable.insert(file, pageNo, frameNo); // here
+    relinkFrame(file, previous, pageNo, lock);
 }
 
 /**
  * Scans buffer and removes pages belonging to the given file from hashtable and BufDesc.
- * If page is dirty, write the page back.
+ * If page is dirty, write the page back. The emptied frames are put on the free list.
  *
  * @param file file to be flushed
  * @throws PagePinnedException if some page of the file is pinned.
  * @throws BadBufferException if an invalid page belonging to the file is encountered.
  */
 void BufMgr::flushFile(File& file) {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    waitForWriteBacks(file, lock);
     for (FrameId index = 0; index < numBufs; index++) {
         // first check that page belongs to the given file
         if (file == bufDescTable[index].file){
@@ -225,42 +1035,360 @@ void BufMgr::flushFile(File& file) {
                 throw PagePinnedException(file.filename(), bufDescTable[index].pageNo, index); // here
             }
 
-            if (bufDescTable[index].dirty){
-                // if dirty, write page back and set dirty bit to false
-                bufDescTable[index].file.writePage(bufPool[index]); // here
-                bufDescTable[index].dirty = false;
-                // then remove page from hashtable and bufDescTable
+            // write the page back if dirty, then remove it from the hashtable and the bufdesctable
+            const PageId pageNo = bufDescTable[index].pageNo;
+            if (!flushFrame(index, lock)) {
+                // pinned again while it was written
+                throw PagePinnedException(file.filename(), pageNo, index);
             }
+        }
+    }
+}
 
-            //finally remove page from hashtable and the bufdesctable
-            hashTable.remove(file, bufDescTable[index].pageNo); // here
+/**
+ * Writes back the page of an unpinned frame if it is dirty, with the pool lock released while the page is
+ * written, and puts the frame on the free list. As in writeBackVictim, a copy of the page is written and the
+ * frame keeps a pin and its writing flag meanwhile.
+ *
+ * @param frameId unpinned frame holding a valid page
+ * @param lock holds the pool lock
+ * @return false if the frame was pinned or dirtied while the lock was released; it is kept then
+ */
+bool BufMgr::flushFrame(const FrameId frameId, std::unique_lock<std::mutex>& lock) {
+    BufDesc& desc = bufDescTable[frameId];
+    unswizzleFrame(frameId, lock);
+    if (desc.pinCnt != 0) {
+        // pinned while the lock was released to unswizzle
+        return false;
+    }
+    if (desc.dirty) {
+        File file = desc.file;
+        const Page copy = bufPool[frameId];
+        desc.pinCnt++;
+        desc.dirty = false;
+        desc.writing = true;
+        lock.unlock();
+
+        try {
+            std::lock_guard<std::shared_mutex> io(ioMutex(file));
+            file.writePage(copy);
+        } catch (...) {
+            lock.lock();
+            desc.pinCnt--;
+            desc.dirty = true;
+            desc.writing = false;
+            writeBackDone.notify_all();
+            throw;
+        }
+
+        lock.lock();
+        desc.pinCnt--;
+        desc.writing = false;
+        writeBackDone.notify_all();
+        bufStats.diskwrites++;
+        if (desc.dirty || desc.pinCnt != 0) {
+            return false;
+        }
+        // swips may have been swizzled while the lock was released
+        unswizzleFrame(frameId, lock);
+        if (desc.dirty || desc.pinCnt != 0) {
+            return false;
+        }
+    }
+    hashTable.remove(desc.file, desc.pageNo);
+    desc.clear();
+    frameLatches[frameId].retire();
+    freeFrames.push(frameId);
+    return true;
+}
+
+/**
+ * Flushes all pages of the given file, then moves its used pages to the front of the file and truncates the rest.
+ *
+ * @param file file to compact
+ * @return old and new page number of every page that was moved
+ * @throws PagePinnedException if some page of the file is pinned; nothing is flushed or moved then.
+ */
+std::map<PageId, PageId> BufMgr::compactFile(File& file) {
+    {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        waitForWriteBacks(file, lock);
+        // check every frame first so that the file is left untouched on error
+        for (FrameId index = 0; index < numBufs; index++) {
+            if (bufDescTable[index].valid && file == bufDescTable[index].file
+                && bufDescTable[index].pinCnt >= 1) {
+                throw PagePinnedException(file.filename(), bufDescTable[index].pageNo, index);
+            }
+        }
+        for (FrameId index = 0; index < numBufs; index++) {
+            if (bufDescTable[index].valid && file == bufDescTable[index].file) {
+                const PageId pageNo = bufDescTable[index].pageNo;
+                if (!flushFrame(index, lock)) {
+                    throw PagePinnedException(file.filename(), pageNo, index);
+                }
+            }
+        }
+        // moved pages change numbers, so copies in the lower tiers are useless
+        invalidateFileCopies(file);
+    }
+    // the file is not in use while it is compacted, so no page of it is read in meanwhile
+    std::lock_guard<std::shared_mutex> io(ioMutex(file));
+    return file.compact();
+}
+
+/**
+ * Scans buffer and removes pages belonging to the given file from hashtable and BufDesc.
+ * Dirty pages are discarded without being written back, and the frames are put on the free list.
+ *
+ * @param file file whose pages are to be discarded
+ * @throws PagePinnedException if some page of the file is pinned; nothing is discarded then.
+ */
+void BufMgr::invalidateFile(File& file) {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    waitForWriteBacks(file, lock);
+    // check every frame first so that the pool is left untouched on error
+    for (FrameId index = 0; index < numBufs; index++) {
+        if (bufDescTable[index].valid && file == bufDescTable[index].file
+            && bufDescTable[index].pinCnt >= 1) {
+            throw PagePinnedException(file.filename(), bufDescTable[index].pageNo, index);
+        }
+    }
+    for (FrameId index = 0; index < numBufs; index++) {
+        if (bufDescTable[index].valid && file == bufDescTable[index].file) {
+            unswizzleFrame(index, lock);
+            if (bufDescTable[index].pinCnt >= 1) {
+                // pinned while the lock was released to unswizzle
+                throw PagePinnedException(file.filename(), bufDescTable[index].pageNo, index);
+            }
+            if (bufDescTable[index].dirty) {
+                bufStats.discards++;
+            }
+            hashTable.remove(file, bufDescTable[index].pageNo);
             bufDescTable[index].clear();
+            frameLatches[index].retire();
+            freeFrames.push(index);
         }
     }
+    invalidateFileCopies(file);
 }
 
 /**
  * Deletes a particular page from file.
- * If page is allocated a frame in the buffer pool, also frees the frame and removes entry from hashtable
+ * If page is allocated a frame in the buffer pool, also frees the frame, removes entry from hashtable
+ * and puts the frame on the free list
  *
  * @param file file that the page is found in
  * @param PageNo page number of the page to be deleted
  */
 void BufMgr::disposePage(File& file, const PageId PageNo) {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    waitForWriteBacks(file, lock);
     FrameId frameId; // stores frame ID from lookup call
-    try{
-        hashTable.lookup(file, PageNo, frameId); // here
-        // page is in the buffer pool, now free and remove
-        bufDescTable[frameId].clear();
-        hashTable.remove(file, PageNo); // here
-    } catch(HashNotFoundException const&){ //  page to be deleted is not allocated a frame in the buffer pool
-        // no need to throw exception if the hash is not found
+    const bool resident = hashTable.find(file, PageNo, frameId);
+    if (resident) {
+        // a pinned frame is in use, or still being loaded by another thread
+        if (bufDescTable[frameId].pinCnt > 0) {
+            throw PagePinnedException(file.filename(), PageNo, frameId);
+        }
+        unswizzleFrame(frameId, lock);
+        if (bufDescTable[frameId].pinCnt > 0) {
+            throw PagePinnedException(file.filename(), PageNo, frameId);
+        }
+        // while the page is deleted, threads asking for it wait on the latch as for a page being read in;
+        // the frame is then marked failed, so that they retry against the file and find the page gone
+        const bool latched = frameLatches[frameId].tryLockExclusive();
+        assert(latched);
+        bufDescTable[frameId].pinCnt++;
+        bufDescTable[frameId].loading = true;
+    }
+    invalidateCopies(file, PageNo);
+    lock.unlock();
+
+    // delete page from file
+    PageId previous;
+    PageId next;
+    std::exception_ptr error;
+    try {
+        std::lock_guard<std::shared_mutex> io(ioMutex(file));
+        file.deletePage(PageNo, &previous, &next); // here
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    lock.lock();
+    if (resident) {
+        // now free the frame and remove it from the hashtable
+        bufDescTable[frameId].loading = false;
+        if (error) {
+            // the page is still in the file, so the frame stays valid
+            bufDescTable[frameId].pinCnt--;
+            frameLatches[frameId].unlockExclusive();
+        } else {
+            hashTable.remove(file, PageNo); // here
+            bufDescTable[frameId].failed = true;
+            frameLatches[frameId].unlockExclusive();
+            releaseFailedPin(frameId);
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    relinkFrame(file, previous, next, lock);
+}
+
+/**
+ * Returns the names of the files with pages in valid frames.
+ */
+std::set<std::string> BufMgr::cachedFiles() const {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    std::set<std::string> files;
+    for (FrameId index = 0; index < numBufs; index++) {
+        if (bufDescTable[index].valid) {
+            files.insert(bufDescTable[index].file.filename());
+        }
+    }
+    return files;
+}
+
+/**
+ * Writes the pages held by valid frames to a file, hottest first.
+ *
+ * @param path name of the dump file
+ */
+void BufMgr::dumpResidentPages(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    std::vector<const BufDesc*> resident;
+    for (FrameId index = 0; index < numBufs; index++) {
+        if (bufDescTable[index].valid) {
+            resident.push_back(&bufDescTable[index]);
+        }
+    }
+    std::sort(resident.begin(), resident.end(), [](const BufDesc* a, const BufDesc* b) {
+        if (a->hits != b->hits) {
+            return a->hits > b->hits;
+        }
+        return a->lastUsed > b->lastUsed;
+    });
+
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    for (const BufDesc* desc : resident) {
+        out << desc->pageNo << ' ' << desc->file.filename() << '\n';
+    }
+}
+
+/**
+ * Loads the pages listed in a dump into free frames.
+ *
+ * @param path name of the dump file
+ * @param batch_size number of pages read per batch
+ * @return number of pages loaded
+ * @throws FileNotFoundException if the dump file does not exist
+ */
+std::size_t BufMgr::loadResidentPages(const std::string& path, const std::size_t batch_size) {
+    std::ifstream in(path);
+    if (!in) {
+        throw FileNotFoundException(path);
+    }
+
+    // keep only as many of the hottest pages as there are free frames
+    std::size_t free;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        free = freeFrames.size();
+    }
+    std::vector<std::pair<std::string, PageId>> wanted;
+    PageId pageNo;
+    std::string name;
+    while (wanted.size() < free && in >> pageNo && in.get() == ' ' &&
+           std::getline(in, name)) {
+        wanted.emplace_back(name, pageNo);
+    }
+    std::sort(wanted.begin(), wanted.end());
+
+    // split the sorted list into per-file batches
+    struct Batch {
+        std::size_t file;
+        std::vector<PageId> pages;
+    };
+    std::vector<File> files;
+    std::vector<Batch> batches;
+    for (std::size_t i = 0; i < wanted.size();) {
+        std::size_t end = i;
+        while (end < wanted.size() && wanted[end].first == wanted[i].first) {
+            end++;
+        }
+        try {
+            files.push_back(File::open(wanted[i].first));
+        } catch (FileNotFoundException const&) {
+            // the file is gone; skip its pages
+            i = end;
+            continue;
+        }
+        for (; i < end; i += batch_size) {
+            Batch batch = {files.size() - 1, std::vector<PageId>()};
+            for (std::size_t j = i; j < std::min(end, i + batch_size); j++) {
+                batch.pages.push_back(wanted[j].second);
+            }
+            batches.push_back(std::move(batch));
+        }
+    }
+
+    // read batch k + 1 in the background while batch k is installed; pages are read with pread under a shared
+    // hold of the file's I/O mutex, and without the pool lock
+    auto readBatch = [this, &files, &batches](const std::size_t k) {
+        File& file = files[batches[k].file];
+        std::vector<Page> pages;
+        pages.reserve(batches[k].pages.size());
+        std::shared_lock<std::shared_mutex> io(ioMutex(file));
+        for (const PageId pageNo : batches[k].pages) {
+            try {
+                pages.push_back(file.preadPage(pageNo));
+            } catch (InvalidPageException const&) {
+                pages.emplace_back(); // no longer in use
+            }
+        }
+        return pages;
+    };
+    std::size_t loaded = 0;
+    std::future<std::vector<Page>> next;
+    if (!batches.empty()) {
+        next = std::async(std::launch::async, readBatch, 0);
+    }
+    for (std::size_t k = 0; k < batches.size(); k++) {
+        std::vector<Page> pages = next.get();
+        if (k + 1 < batches.size()) {
+            next = std::async(std::launch::async, readBatch, k + 1);
+        }
+        File& file = files[batches[k].file];
+        std::lock_guard<std::mutex> lock(poolMutex);
+        for (std::size_t j = 0; j < pages.size(); j++) {
+            FrameId frameNo;
+            if (pages[j].page_number() != batches[k].pages[j]) {
+                continue; // no longer in use
+            }
+            if (hashTable.find(file, batches[k].pages[j], frameNo)) {
+                continue; // already resident
+            }
+            if (!freeFrames.pop(frameNo)) {
+                continue; // pool filled up since the dump was read
+            }
+            frameLatches[frameNo].beginRewrite();
+            bufPool[frameNo] = pages[j];
+            frameLatches[frameNo].endRewrite();
+            bufDescTable[frameNo].Set(file, batches[k].pages[j]);
+            bufDescTable[frameNo].pinCnt = 0;
+            bufDescTable[frameNo].refbit = false;
+            bufDescTable[frameNo].hits = 0;
+            hashTable.insert(file, batches[k].pages[j], frameNo);
+            bufStats.diskreads++;
+            loaded++;
+        }
     }
-    // lastly delete page from file
-    file.deletePage(PageNo); // here
+    return loaded;
 }
 
 void BufMgr::printSelf(void) {
+  std::lock_guard<std::mutex> lock(poolMutex);
   int validFrames = 0;
 
   for (FrameId i = 0; i < numBufs; i++) {
@@ -8,11 +8,26 @@
 
 #pragma once
 
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "bufHashTbl.h"
+#include "compressed_cache.h"
 #include "file.h"
+#include "free_frame_list.h"
+#include "page_latch.h"
+#include "ssd_cache.h"
+#include "swip.h"
 
 namespace badgerdb {
 
@@ -68,6 +83,34 @@ class BufDesc {
    */
   bool refbit;
 
+  /**
+   * Number of times the page has been pinned since it was brought in
+   */
+  std::uint32_t hits;
+
+  /**
+   * Value of the buffer manager's access counter when the page was last pinned
+   */
+  std::uint64_t lastUsed;
+
+  /**
+   * True while the page is being read into the frame; the reading thread
+   * holds the frame's latch exclusively until it is done
+   */
+  bool loading;
+
+  /**
+   * True if reading the page into the frame failed; the frame is freed once
+   * the threads that waited for the read have dropped their pins
+   */
+  bool failed;
+
+  /**
+   * True while the page is being written back or added to the lower tiers
+   * before the frame is reused
+   */
+  bool writing;
+
   /**
    * Initialize buffer frame for a new user
    */
@@ -78,6 +121,11 @@ class BufDesc {
     dirty = false;
     refbit = false;
     valid = false;
+    hits = 0;
+    lastUsed = 0;
+    loading = false;
+    failed = false;
+    writing = false;
   }
 
   /**
@@ -95,6 +143,10 @@ class BufDesc {
     dirty = false;
     valid = true;
     refbit = true;
+    hits = 1;
+    loading = false;
+    failed = false;
+    writing = false;
   }
 
   void Print() {
@@ -111,6 +163,24 @@ class BufDesc {
   }
 };
 
+/**
+ * @brief Reference to a resident page for optimistic reads.
+ *
+ * Valid as long as the page stays in its frame and is not latched
+ * exclusively; BufMgr::validate() tells whether that still holds.
+ */
+struct PageHandle {
+  /**
+   * Frame holding the page when the handle was made
+   */
+  FrameId frame;
+
+  /**
+   * Version of the frame when the handle was made
+   */
+  std::uint64_t version;
+};
+
 /**
  * @brief Class to maintain statistics of buffer usage
  */
@@ -130,10 +200,49 @@ struct BufStats {
    */
   int diskwrites;
 
+  /**
+   * Number of dirty pages discarded without being written back
+   */
+  int discards;
+
+  /**
+   * Number of pages not in the pool that were found in the SSD cache
+   */
+  int ssdhits;
+
+  /**
+   * Number of pages not in the pool that were not in the SSD cache either
+   */
+  int ssdmisses;
+
+  /**
+   * Number of evicted pages written to the SSD cache
+   */
+  int ssdwrites;
+
+  /**
+   * Number of pages not in the pool that were found in the compressed cache
+   */
+  int compressedhits;
+
+  /**
+   * Number of pages not in the pool that were not in the compressed cache
+   */
+  int compressedmisses;
+
+  /**
+   * Number of evicted pages added to the compressed cache
+   */
+  int compressedwrites;
+
   /**
    * Clear all values
    */
-  void clear() { accesses = diskreads = diskwrites = 0; }
+  void clear() {
+    accesses = diskreads = diskwrites = discards = 0;
+    ssdhits = ssdmisses = ssdwrites = 0;
+    compressedhits = compressedmisses = compressedwrites = 0;
+  }
 
   /**
    * Constructor of BufStats class
@@ -144,6 +253,17 @@ struct BufStats {
 /**
  * @brief The central class which manages the buffer pool including frame
  * allocation and deallocation to pages in the file
+ *
+ * All methods may be called from several threads at once.  Pins keep a page
+ * in its frame but do not order accesses to the page itself; callers that
+ * share pages between threads latch them through the LatchMode overloads of
+ * readPage() and unPinPage().  Statistics returned by getBufStats() are only
+ * consistent while no other thread uses the pool.
+ *
+ * An optional CompressedCache and an optional SsdCache form lower tiers below
+ * the pool: frames evicted to make room are added to both, and pages missing
+ * from the pool are looked up in the compressed cache, then in the SSD cache,
+ * before they are read from their file.
  */
 class BufMgr {
  private:
@@ -168,25 +288,225 @@ class BufMgr {
    */
   std::vector<BufDesc> bufDescTable;
 
+  /**
+   * Frames known to hold no page, handed out by allocBuf() before the clock
+   * is consulted
+   */
+  FreeFrameList freeFrames;
+
+  /**
+   * Latch of every frame, indexed by frame number
+   */
+  std::unique_ptr<FrameLatch[]> frameLatches;
+
+  /**
+   * For every frame, the swizzled swips referring to it, with the frames
+   * whose pages hold them
+   */
+  std::vector<std::vector<std::pair<FrameId, Swip*>>> incomingSwips;
+
+  /**
+   * For every frame, the swizzled swips its page holds, with the frames they
+   * refer to
+   */
+  std::vector<std::vector<std::pair<FrameId, Swip*>>> outgoingSwips;
+
+  /**
+   * Protects the frame descriptors, the hash table, the clock, the swip
+   * lists and the statistics; held only while they are updated, never while
+   * waiting for a frame latch or for a page to be read or written back
+   */
+  mutable std::mutex poolMutex;
+
+  /**
+   * Signalled under poolMutex whenever a frame stops being written back
+   */
+  std::condition_variable writeBackDone;
+
+  /**
+   * Number of mutexes in ioMutexes
+   */
+  static const std::size_t IO_MUTEXES = 16;
+
+  /**
+   * Order I/O on the files cached in the pool, since a File may only be used
+   * by one thread at a time: pages missing from the pool are read with
+   * File::preadPage() under a shared hold, everything else holds the mutex
+   * ioMutex() picks for the file exclusively.  Taken after poolMutex if both
+   * are held.
+   */
+  std::shared_mutex ioMutexes[IO_MUTEXES];
+
   /**
    * Maintains Buffer pool usage statistics
    */
   BufStats bufStats;
 
+  /**
+   * Second-level cache below the pool, or NULL
+   */
+  SsdCache* ssdCache;
+
+  /**
+   * Compressed in-memory cache below the pool, or NULL
+   */
+  CompressedCache* compressedCache;
+
+  /**
+   * Counts page pins; stamps frames to tell how recently they were used
+   */
+  std::uint64_t accessCounter;
+
   /**
    * Advance clock to next frame in the buffer pool
    */
   void advanceClock();
 
   /**
-   * Allocate a free frame.
+   * Allocate a free frame, taking it from the free list if possible and
+   * running the clock algorithm otherwise.  <lock> must hold poolMutex; it
+   * is released while a victim is written back or added to the lower tiers,
+   * so the pool may have changed when this returns.
    *
    * @param frame   	Frame reference, frame ID of allocated frame returned
    * via this variable
+   * @param lock  	Lock holding poolMutex
    * @throws BufferExceededException If no such buffer is found which can be
    * allocated
    */
-  void allocBuf(FrameId& frame);
+  void allocBuf(FrameId& frame, std::unique_lock<std::mutex>& lock);
+
+  /**
+   * Writes back the page of an unpinned victim frame if it is dirty and adds
+   * it to the lower tiers, without holding poolMutex meanwhile; the frame
+   * stays pinned so that nobody else evicts it.  Must be called with <lock>
+   * holding poolMutex.
+   *
+   * @return True if the frame may be evicted: it was not pinned, referenced
+   * or changed while the lock was released
+   */
+  bool writeBackVictim(const FrameId frame, std::unique_lock<std::mutex>& lock);
+
+  /**
+   * Writes back the page of an unpinned frame if it is dirty, without
+   * holding poolMutex meanwhile as writeBackVictim() does, then frees the
+   * frame.  Must be called with <lock> holding poolMutex.
+   *
+   * @return False if the frame was pinned or changed while the lock was
+   * released; it is kept then
+   */
+  bool flushFrame(const FrameId frame, std::unique_lock<std::mutex>& lock);
+
+  /**
+   * Pins the given page, reading it into a new frame if it is not resident.
+   * <lock> must hold poolMutex; it is released while the page is read, with
+   * the frame already in the hash table and latched exclusively, so that
+   * other threads asking for the page wait on the frame's latch.
+   *
+   * @return Frame holding the page
+   */
+  FrameId pinPage(File& file, const PageId pageNo,
+                  std::unique_lock<std::mutex>& lock);
+
+  /**
+   * Tier a page missing from the pool was read from
+   */
+  enum class PageSource { COMPRESSED_CACHE, SSD_CACHE, FILE };
+
+  /**
+   * Reads a page that is not in the pool into <page> from the first tier
+   * holding it.  Must be called without poolMutex held.
+   *
+   * @return Tier the page was found in
+   */
+  PageSource readMissingPage(File& file, const PageId pageNo, Page& page);
+
+  /**
+   * Counts a read of a page missing from the pool in the statistics.  Must
+   * be called with poolMutex held.
+   */
+  void countMissingPage(const PageSource source);
+
+  /**
+   * Drops a pin on a frame whose page could not be read, freeing the frame
+   * with the last one.  Must be called with poolMutex held.
+   */
+  void releaseFailedPin(const FrameId frame);
+
+  /**
+   * Waits until no page of <file> is being written back by allocBuf().
+   * <lock> must hold poolMutex.
+   */
+  void waitForWriteBacks(File& file, std::unique_lock<std::mutex>& lock);
+
+  /**
+   * Returns the mutex serializing I/O on <file>.
+   */
+  std::shared_mutex& ioMutex(const File& file);
+
+  /**
+   * Makes the resident copy of page <pageNo> link to page <next>, after the
+   * file relinked it on disk.  Must be called with poolMutex held.
+   */
+  void relinkFrame(File& file, const PageId pageNo, const PageId next,
+                   std::unique_lock<std::mutex>& lock);
+
+  /**
+   * Drops the copies of a page from the lower tiers.  Must be called with
+   * poolMutex held.
+   */
+  void invalidateCopies(File& file, const PageId pageNo);
+
+  /**
+   * Drops the copies of all pages of a file from the lower tiers.  Must be
+   * called with poolMutex held.
+   */
+  void invalidateFileCopies(File& file);
+
+  /**
+   * Adds a pin to a frame holding a page.  Must be called with poolMutex held.
+   */
+  void pinFrame(const FrameId frame);
+
+  /**
+   * Takes the latch of a pinned frame in <mode>.  Must be called without
+   * poolMutex held.
+   */
+  void latchFrame(const FrameId frame, const LatchMode mode);
+
+  /**
+   * Takes the latch of a frame in <mode> if that is possible without
+   * waiting.  Never blocks, so it may be called with poolMutex held.
+   *
+   * @return True if the latch was taken
+   */
+  bool tryLatchFrame(const FrameId frame, const LatchMode mode);
+
+  /**
+   * Restores the page numbers of all swizzled swips referring to the frame or
+   * held by its page.  Called before a frame gives up its page or the page is
+   * written, with poolMutex held.  Each page holding swips is latched
+   * exclusively while they are rewritten, so latch holders never see them
+   * change and optimistic readers see a new version.  Never waits for a
+   * latch.
+   *
+   * @return True if no swip is left swizzled; false if the page holding one
+   * of them was latched
+   */
+  bool tryUnswizzleFrame(const FrameId frame);
+
+  /**
+   * Like tryUnswizzleFrame(), but waits for busy latches with <lock>
+   * released, keeping the frame pinned meanwhile.  The caller must not hold
+   * the latch of a page holding one of the swips.
+   */
+  void unswizzleFrame(const FrameId frame, std::unique_lock<std::mutex>& lock);
+
+  /**
+   * Removes <swip> from <swips>.
+   */
+  static void eraseSwip(std::vector<std::pair<FrameId, Swip*>>& swips,
+                        const Swip* swip);
 
  public:
   /**
@@ -196,8 +516,15 @@ class BufMgr {
 
   /**
    * Constructor of BufMgr class
+   *
+   * @param bufs  	Number of frames in the buffer pool
+   * @param ssdCache  Second-level cache to keep evicted pages in, or NULL.
+   * Must outlive the buffer manager and must not be shared with another one.
+   * @param compressedCache  Compressed cache to keep evicted pages in, or
+   * NULL; the same requirements apply.
    */
-  BufMgr(std::uint32_t bufs);
+  BufMgr(std::uint32_t bufs, SsdCache* ssdCache = NULL,
+         CompressedCache* compressedCache = NULL);
 
   /**
    * Reads the given page from the file into a frame and returns the pointer to
@@ -212,6 +539,70 @@ class BufMgr {
    */
   void readPage(File& file, const PageId pageNo, Page*& page);
 
+  /**
+   * Reads the given page like readPage(file, pageNo, page) and latches its
+   * frame in <mode>.  Any number of SHARED holders may read the page at
+   * once; an EXCLUSIVE holder waits for them to leave and is then alone on
+   * the page.  The latch must be released by passing the same mode to
+   * unPinPage().
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file to be read
+   * @param page  	Reference to page pointer
+   * @param mode  	Latch to take on the page's frame
+   */
+  void readPage(File& file, const PageId pageNo, Page*& page,
+                const LatchMode mode);
+
+  /**
+   * Pins and latches the given page like readPage() if it is resident and
+   * its latch can be taken right away, and returns false without blocking
+   * on I/O or on the latch otherwise.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file to be read
+   * @param page  	Reference to page pointer. Set only if the page is
+   * resident.
+   * @param mode  	Latch to take on the page's frame
+   * @return True if the page was resident and has been pinned
+   */
+  bool readPageIfResident(File& file, const PageId pageNo, Page*& page,
+                          const LatchMode mode = LatchMode::NONE);
+
+  /**
+   * Calls readPageIfResident() for <count> pages of <file> under a single
+   * acquisition of the pool lock.  The hash table slots of all pages are
+   * prefetched before any is looked up, so the cache misses of the lookups
+   * overlap instead of following each other.
+   *
+   * @param file   	File object
+   * @param pageNos Page numbers to read
+   * @param count  	Number of entries in <pageNos> and <pages>
+   * @param pages  	Set to the pinned page for every resident page and to
+   * NULL for every other one
+   * @param mode  	Latch to take on the frames of the resident pages
+   * @return Number of pages that were resident and have been pinned
+   */
+  std::size_t readPagesIfResident(File& file, const PageId* pageNos,
+                                  const std::size_t count, Page** pages,
+                                  const LatchMode mode = LatchMode::NONE);
+
+  /**
+   * Calls readPage() for <count> pages of <file> with fewer acquisitions of
+   * the pool lock: frames for all missing pages are reserved under one
+   * acquisition, the pages are read with the lock released and published
+   * under another.  Page numbers may repeat; each occurrence is pinned.  If
+   * a page cannot be read, every page pinned by the call is unpinned again
+   * before the first error is rethrown.
+   *
+   * @param file   	File object
+   * @param pageNos Page numbers to read
+   * @param count  	Number of entries in <pageNos> and <pages>
+   * @param pages  	Set to the pinned pages
+   */
+  void readPages(File& file, const PageId* pageNos, const std::size_t count,
+                 Page** pages);
+
   /**
    * Unpin a page from memory since it is no longer required for it to remain in
    * memory.
@@ -224,6 +615,121 @@ class BufMgr {
    */
   void unPinPage(File& file, const PageId pageNo, const bool dirty);
 
+  /**
+   * Releases the latch taken in <mode> by readPage() and unpins the page.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number
+   * @param dirty		True if the page to be unpinned needs to be
+   * marked dirty
+   * @param mode  	Latch held on the page's frame
+   * @throws  PageNotPinnedException If the page is not already pinned
+   */
+  void unPinPage(File& file, const PageId pageNo, const bool dirty,
+                 const LatchMode mode);
+
+  /**
+   * Pins the page that <swip> refers to and latches it in <mode>, like
+   * readPage().  The first time, the page is found through the hash table
+   * and <swip> is swizzled to point at its frame; later calls follow the
+   * swip to the frame directly.  The swip is unswizzled again when either
+   * page leaves the pool or <owner> is written back.  Swizzling does not make
+   * <owner> dirty.
+   *
+   * @param file   	File holding the referenced page
+   * @param owner  	Pinned page holding <swip>
+   * @param swip  	Swip stored inside <owner>
+   * @param page  	Reference to page pointer. Used to return the page.
+   * @param mode  	Latch to take on the referenced page's frame
+   */
+  void fixSwip(File& file, Page* owner, Swip& swip, Page*& page,
+               const LatchMode mode = LatchMode::NONE);
+
+  /**
+   * Returns the number of the page <swip> refers to, whether it is swizzled
+   * or not.
+   */
+  PageId swipPageNumber(const Swip& swip) const;
+
+  /**
+   * Returns the number of the page held by <frame>, which a swizzled swip
+   * stored in a pinned page refers to, so that accessors copying values out
+   * of that page can restore page numbers in place of frame references.
+   * Takes no lock: the frame keeps its page until the swip is unswizzled,
+   * which needs the exclusive latch of the page holding the swip.
+   *
+   * @param frame  	Frame a swizzled swip refers to
+   */
+  PageId swizzledPageNumber(const FrameId frame) const {
+    return bufDescTable[frame].pageNo;
+  }
+
+  /**
+   * Restores the page number of <swip>, stored in the pinned page <owner>,
+   * and forgets that it was swizzled.  Must be called before the bytes of a
+   * swizzled swip are overwritten or given up, e.g. when the record holding
+   * it is updated or deleted, by the thread changing <owner>.
+   *
+   * @param owner  	Pinned page holding <swip>
+   * @param swip  	Swizzled swip
+   */
+  void forgetSwip(const Page* owner, Swip* swip);
+
+  /**
+   * Returns a handle for reading the given page optimistically: without
+   * pinning or latching it, and without writing any memory shared with other
+   * threads.  A read follows the pattern
+   *
+   *   const Page* page = bufMgr->optimisticPage(handle);
+   *   ... read from page ...
+   *   if (!bufMgr->validate(handle)) ... discard what was read and restart
+   *
+   * and may see torn data before validation, so it must not trust what it
+   * read (e.g. follow offsets) until validate() succeeds.  Once validation
+   * fails, a fresh handle is needed.  Validating the parent's handle after
+   * reading a child's page number and taking the child's handle gives
+   * optimistic lock coupling for index traversals.  Only changes made under
+   * an EXCLUSIVE latch are detected.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file
+   */
+  PageHandle readHandle(File& file, const PageId pageNo);
+
+  /**
+   * Returns the page the frame of <handle> holds, without pinning it.
+   *
+   * @param handle  Handle returned by readHandle()
+   */
+  const Page* optimisticPage(const PageHandle& handle) const;
+
+  /**
+   * Returns true if the frame of <handle> still holds the page it was made
+   * for and no writer changed it since.  Only reads shared memory.
+   *
+   * @param handle  Handle returned by readHandle()
+   */
+  bool validate(const PageHandle& handle) const;
+
+  /**
+   * Returns the version of the frame holding <page>, which must be pinned.
+   * Together with validatePage() this allows reading a pinned page without
+   * latching it: read the version, read the page, then validate; the read
+   * saw a consistent page if validation succeeds.
+   *
+   * @param page  	Page pointer returned by readPage() or allocPage()
+   */
+  std::uint64_t pageVersion(const Page* page) const;
+
+  /**
+   * Returns true if no EXCLUSIVE latch was held on the frame of <page> since
+   * pageVersion() returned <version>.
+   *
+   * @param page  	Page pointer returned by readPage() or allocPage()
+   * @param version  Value returned by pageVersion()
+   */
+  bool validatePage(const Page* page, const std::uint64_t version) const;
+
   /**
    * Allocates a new, empty page in the file and returns the Page object.
    * The newly allocated page is also assigned a frame in the buffer pool.
@@ -237,7 +743,8 @@ class BufMgr {
   void allocPage(File& file, PageId& pageNo, Page*& page);
 
   /**
-   * Writes out all dirty pages of the file to disk.
+   * Writes out all dirty pages of the file to disk and puts their frames on
+   * the free list.
    * All the frames assigned to the file need to be unpinned from buffer pool
    * before this function can be successfully called. Otherwise Error returned.
    *
@@ -250,15 +757,92 @@ class BufMgr {
   void flushFile(File& file);
 
   /**
-   * Delete page from file and also from buffer pool if present.
+   * Removes all pages of the file from the buffer pool and the lower tiers
+   * without writing dirty pages back, and puts their frames on the free list.
+   * Meant for files that are about to be deleted, whose contents no longer
+   * matter.
+   *
+   * @param file   	File object
+   * @throws  PagePinnedException If any page of the file is pinned in the
+   * buffer pool; no frame is discarded in that case
+   */
+  void invalidateFile(File& file);
+
+  /**
+   * Writes back and evicts all pages of the file like flushFile(), then
+   * compacts it with File::compact().  The pool lock is not held while the
+   * file is rewritten, so other files stay usable throughout.
+   *
+   * This is offline compaction: the whole file is rewritten in one call,
+   * not a bounded number of pages at a time, and the file must not be in
+   * use while it runs.  Pages change numbers, so RecordIds held elsewhere
+   * are only valid again once they are forwarded with the returned map.
+   *
+   * @param file   	File object
+   * @return Forwarding map from the old to the new number of every page
+   * that was moved
+   * @throws  PagePinnedException If any page of the file is pinned in the
+   * buffer pool; nothing is written or moved in that case
+   */
+  std::map<PageId, PageId> compactFile(File& file);
+
+  /**
+   * Delete page from file and also from buffer pool if present, putting its
+   * frame on the free list.
    * Since the page is entirely deleted from file, its unnecessary to see if the
    * page is dirty.
    *
    * @param file   	File object
    * @param PageNo  Page number
+   * @throws  PagePinnedException If the page is pinned in the buffer pool;
+   * nothing is deleted in that case
    */
   void disposePage(File& file, const PageId PageNo);
 
+  /**
+   * Returns the names of the files that have pages in the pool.
+   */
+  std::set<std::string> cachedFiles() const;
+
+  /**
+   * Writes the (file, page) pairs of all valid frames to <path>, hottest first:
+   * pages pinned more often come first, ties going to the more recently used.
+   * Each line holds a page number, a space and the file name.
+   *
+   * @param path   	Name of the dump file; replaced if it exists
+   */
+  void dumpResidentPages(const std::string& path) const;
+
+  /**
+   * Reads a dump written by dumpResidentPages() and brings the listed pages
+   * into free frames, hottest first, without evicting anything.  Pages of
+   * each file are read in ascending order in batches of <batch_size>; the
+   * next batch is read on a background thread while the current one is
+   * installed.  Batches are read with File::preadPage() under a shared hold
+   * of the file's I/O mutex, and poolMutex is taken only to install each
+   * one.  Pages of files that no longer exist, and pages that are no
+   * longer in use, are skipped.  Loaded pages are unpinned and clean.
+   *
+   * Must not run concurrently with other accesses to the listed files.
+   *
+   * @param path   	Name of the dump file
+   * @param batch_size	Number of pages read per batch
+   * @return Number of pages loaded
+   * @throws FileNotFoundException If the dump file does not exist
+   */
+  std::size_t loadResidentPages(const std::string& path,
+                                const std::size_t batch_size = 64);
+
+  /**
+   * Returns the number of frames in the buffer pool.
+   */
+  std::uint32_t numFrames() const { return numBufs; }
+
+  /**
+   * Returns the number of frames on the free list.
+   */
+  std::uint32_t numFreeFrames() const { return freeFrames.size(); }
+
   /**
    * Print member variable values.
    */
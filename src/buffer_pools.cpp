@@ -0,0 +1,106 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "buffer_pools.h"
+
+#include "exceptions/file_cached_exception.h"
+#include "exceptions/pool_exists_exception.h"
+#include "exceptions/pool_not_found_exception.h"
+
+namespace badgerdb {
+
+const char BufferPools::DEFAULT_POOL[] = "default";
+
+BufferPools::BufferPools(const std::uint32_t default_frames) {
+  addPool(DEFAULT_POOL, default_frames);
+}
+
+BufMgr *BufferPools::addPool(const std::string &name,
+                             const std::uint32_t frames, SsdCache *ssdCache,
+                             CompressedCache *compressedCache) {
+  if (pools_.count(name) > 0) {
+    throw PoolExistsException(name);
+  }
+  std::unique_ptr<BufMgr> &pool = pools_[name];
+  pool.reset(new BufMgr(frames, ssdCache, compressedCache));
+  return pool.get();
+}
+
+void BufferPools::assignFile(const std::string &filename,
+                             const std::string &pool) {
+  this->pool(pool);
+  const std::map<std::string, std::string> files = files_;
+  files_[filename] = pool;
+  checkCachedFiles(files, prefixes_);
+}
+
+void BufferPools::assignPrefix(const std::string &prefix,
+                               const std::string &pool) {
+  this->pool(pool);
+  const std::map<std::string, std::string> prefixes = prefixes_;
+  prefixes_[prefix] = pool;
+  checkCachedFiles(files_, prefixes);
+}
+
+void BufferPools::checkCachedFiles(
+    const std::map<std::string, std::string> &files,
+    const std::map<std::string, std::string> &prefixes) {
+  for (const auto &pool : pools_) {
+    for (const std::string &filename : pool.second->cachedFiles()) {
+      if (poolName(filename) != pool.first) {
+        files_ = files;
+        prefixes_ = prefixes;
+        throw FileCachedException(filename, pool.first);
+      }
+    }
+  }
+}
+
+BufMgr *BufferPools::pool(const std::string &name) const {
+  const std::map<std::string, std::unique_ptr<BufMgr>>::const_iterator it =
+      pools_.find(name);
+  if (it == pools_.end()) {
+    throw PoolNotFoundException(name);
+  }
+  return it->second.get();
+}
+
+const std::string &BufferPools::poolName(const std::string &filename) const {
+  const std::map<std::string, std::string>::const_iterator file =
+      files_.find(filename);
+  if (file != files_.end()) {
+    return file->second;
+  }
+  // Prefixes of <filename> sort before it, the longest one last, so walking
+  // back from it finds the longest one first.
+  std::map<std::string, std::string>::const_iterator it =
+      prefixes_.upper_bound(filename);
+  while (it != prefixes_.begin()) {
+    --it;
+    if (filename.compare(0, it->first.size(), it->first) == 0) {
+      return it->second;
+    }
+  }
+  return pools_.find(DEFAULT_POOL)->first;
+}
+
+std::vector<std::string> BufferPools::names() const {
+  std::vector<std::string> names;
+  for (const auto &pool : pools_) {
+    names.push_back(pool.first);
+  }
+  return names;
+}
+
+void BufferPools::clearBufStats() {
+  for (const auto &pool : pools_) {
+    pool.second->clearBufStats();
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,142 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "compressed_cache.h"
+#include "file.h"
+#include "ssd_cache.h"
+
+namespace badgerdb {
+
+/**
+ * @brief A set of named buffer pools, each caching the files assigned to it.
+ *
+ * Every pool is a BufMgr of its own, with its own frames, lower tiers and
+ * statistics, so a file assigned to a pool is never evicted to make room for
+ * the pages of a file in another one.  Files are assigned by exact name or by
+ * name prefix; the longest matching prefix wins, and files matching nothing
+ * go to the default pool.
+ *
+ * A file must stay in one pool while any of its pages are cached, so an
+ * assignment that would move a cached file is refused; flush the file from
+ * its pool first.  Pools and assignments are set up before the pools are
+ * shared between threads; the pools themselves are threadsafe.
+ */
+class BufferPools {
+ public:
+  /**
+   * Name of the pool that files not assigned elsewhere use.
+   */
+  static const char DEFAULT_POOL[];
+
+  /**
+   * Constructs the default pool.
+   *
+   * @param default_frames  Number of frames in the default pool.
+   */
+  explicit BufferPools(const std::uint32_t default_frames);
+
+  BufferPools(const BufferPools &) = delete;
+  BufferPools &operator=(const BufferPools &) = delete;
+
+  /**
+   * Adds a pool named <name>.
+   *
+   * @param name             Name of the pool.
+   * @param frames           Number of frames in the pool.
+   * @param ssdCache         SSD cache below the pool, or NULL.
+   * @param compressedCache  Compressed cache below the pool, or NULL.
+   * @return  The new pool.
+   * @throws  PoolExistsException  If there is a pool named <name> already.
+   */
+  BufMgr *addPool(const std::string &name, const std::uint32_t frames,
+                  SsdCache *ssdCache = NULL,
+                  CompressedCache *compressedCache = NULL);
+
+  /**
+   * Assigns the file named <filename> to pool <pool>.
+   *
+   * @throws  PoolNotFoundException  If there is no pool named <pool>.
+   * @throws  FileCachedException  If the file has pages cached in the pool
+   *                               it is assigned to now; the assignment is
+   *                               left unchanged in that case.
+   */
+  void assignFile(const std::string &filename, const std::string &pool);
+
+  /**
+   * Assigns all files whose names start with <prefix> to pool <pool>.
+   *
+   * @throws  PoolNotFoundException  If there is no pool named <pool>.
+   * @throws  FileCachedException  If a file that would change pools has
+   *                               pages cached in its current one; the
+   *                               assignment is left unchanged in that case.
+   */
+  void assignPrefix(const std::string &prefix, const std::string &pool);
+
+  /**
+   * Returns the pool named <name>.
+   *
+   * @throws  PoolNotFoundException  If there is no such pool.
+   */
+  BufMgr *pool(const std::string &name) const;
+
+  /**
+   * Returns the name of the pool caching the file named <filename>.
+   */
+  const std::string &poolName(const std::string &filename) const;
+
+  /**
+   * Returns the pool caching <file>.
+   */
+  BufMgr *poolFor(const File &file) const {
+    return pool(poolName(file.filename()));
+  }
+
+  /**
+   * Returns the names of all pools, in order.
+   */
+  std::vector<std::string> names() const;
+
+  /**
+   * Clears the statistics of all pools.
+   */
+  void clearBufStats();
+
+ private:
+  /**
+   * Throws FileCachedException, after restoring the assignments <files> and
+   * <prefixes>, if a pool caches a file that is now assigned elsewhere.
+   */
+  void checkCachedFiles(const std::map<std::string, std::string> &files,
+                        const std::map<std::string, std::string> &prefixes);
+
+  /**
+   * Pools by name.
+   */
+  std::map<std::string, std::unique_ptr<BufMgr>> pools_;
+
+  /**
+   * Pool of every file assigned by exact name.
+   */
+  std::map<std::string, std::string> files_;
+
+  /**
+   * Pool of every file name prefix.
+   */
+  std::map<std::string, std::string> prefixes_;
+};
+
+}  // namespace badgerdb
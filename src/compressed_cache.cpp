@@ -0,0 +1,84 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "compressed_cache.h"
+
+#include <cstring>
+
+#include "page_compressor.h"
+
+namespace badgerdb {
+
+bool CompressedCache::read(const File &file, const PageId page_number,
+                           Page *page) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::map<Key, Entry>::iterator it =
+      index_.find(Key(file.filename(), page_number));
+  if (it == index_.end()) {
+    return false;
+  }
+  const std::string &data = it->second.data;
+  if (!PageCompressor::decompress(data.data() + sizeof(page->header_),
+                                  data.size() - sizeof(page->header_),
+                                  &page->data_[0], Page::DATA_SIZE)) {
+    erase(it);
+    return false;
+  }
+  std::memcpy(&page->header_, data.data(), sizeof(page->header_));
+  lru_.splice(lru_.begin(), lru_, it->second.position);
+  return true;
+}
+
+bool CompressedCache::write(const File &file, const Page &page) {
+  Key key(file.filename(), page.page_number());
+  std::string data(reinterpret_cast<const char *>(&page.header_),
+                   sizeof(page.header_));
+  PageCompressor::compress(page.data_.data(), Page::DATA_SIZE, &data);
+  if (data.size() > MAX_COMPRESSED_SIZE || data.size() > budget_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (index_.count(key) > 0) {
+    return false;
+  }
+  while (bytes_ + data.size() > budget_) {
+    erase(index_.find(lru_.back()));
+  }
+  bytes_ += data.size();
+  lru_.push_front(key);
+  Entry &entry = index_[std::move(key)];
+  entry.data = std::move(data);
+  entry.position = lru_.begin();
+  return true;
+}
+
+void CompressedCache::invalidate(const File &file, const PageId page_number) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::map<Key, Entry>::iterator it =
+      index_.find(Key(file.filename(), page_number));
+  if (it != index_.end()) {
+    erase(it);
+  }
+}
+
+void CompressedCache::invalidateFile(const File &file) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<Key, Entry>::iterator it =
+      index_.lower_bound(Key(file.filename(), 0));
+  while (it != index_.end() && it->first.first == file.filename()) {
+    erase(it++);
+  }
+}
+
+void CompressedCache::erase(const std::map<Key, Entry>::iterator it) {
+  bytes_ -= it->second.data.size();
+  lru_.erase(it->second.position);
+  index_.erase(it);
+}
+
+}  // namespace badgerdb
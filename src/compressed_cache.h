@@ -0,0 +1,163 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Page cache in memory that keeps pages compressed, meant as a tier
+ * between the buffer pool and disk.
+ *
+ * Pages are compressed with PageCompressor and kept within a budget of
+ * compressed bytes; when it is exhausted, the least recently used pages are
+ * dropped.  Pages that do not shrink to MAX_COMPRESSED_SIZE are not kept,
+ * since they would cost almost as much memory as a frame.
+ *
+ * Like SsdCache, the tier holds clean copies of pages that BufMgr
+ * invalidates when it changes them.
+ *
+ * All methods are threadsafe.  Pages are compressed before the cache's lock
+ * is taken, so threads demoting pages compress them in parallel.
+ */
+class CompressedCache {
+ public:
+  /**
+   * Largest compressed size of a page that is kept, in bytes.
+   */
+  static const std::size_t MAX_COMPRESSED_SIZE = Page::SIZE / 2;
+
+  /**
+   * Constructs an empty cache.
+   *
+   * @param budget  Number of compressed bytes the cache may hold.
+   */
+  explicit CompressedCache(const std::size_t budget)
+      : budget_(budget), bytes_(0) {}
+
+  CompressedCache(const CompressedCache &) = delete;
+  CompressedCache &operator=(const CompressedCache &) = delete;
+
+  /**
+   * Decompresses page <page_number> of <file> into <page> if it is cached.
+   *
+   * @return  True on a hit.
+   */
+  bool read(const File &file, const PageId page_number, Page *page);
+
+  /**
+   * Compresses and keeps <page> of <file> unless it is cached already or
+   * does not compress well enough.
+   *
+   * @return  True if the page was added.
+   */
+  bool write(const File &file, const Page &page);
+
+  /**
+   * Forgets page <page_number> of <file>, if cached.
+   */
+  void invalidate(const File &file, const PageId page_number);
+
+  /**
+   * Forgets all pages of <file>.
+   */
+  void invalidateFile(const File &file);
+
+  /**
+   * Returns the number of compressed bytes the cache may hold.
+   */
+  std::size_t budget() const { return budget_; }
+
+  /**
+   * Returns the number of compressed bytes held.
+   */
+  std::size_t bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+  }
+
+  /**
+   * Returns the number of pages cached.
+   */
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+  }
+
+  /**
+   * Returns the number of uncompressed bytes held per compressed byte.
+   */
+  double ratio() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_ == 0 ? 0.0 : double(index_.size() * Page::SIZE) / bytes_;
+  }
+
+ private:
+  /**
+   * File name and page number of a cached page.
+   */
+  typedef std::pair<std::string, PageId> Key;
+
+  /**
+   * A cached page.
+   */
+  struct Entry {
+    /**
+     * Page header followed by the compressed page data.
+     */
+    std::string data;
+
+    /**
+     * Position of the page in lru_.
+     */
+    std::list<Key>::iterator position;
+  };
+
+  /**
+   * Forgets the page at <it>.  Must be called with mutex_ held.
+   */
+  void erase(const std::map<Key, Entry>::iterator it);
+
+  /**
+   * Protects bytes_, index_ and lru_.
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * Number of compressed bytes the cache may hold.
+   */
+  std::size_t budget_;
+
+  /**
+   * Number of compressed bytes held.
+   */
+  std::size_t bytes_;
+
+  /**
+   * Cached pages.
+   */
+  std::map<Key, Entry> index_;
+
+  /**
+   * Cached pages, most recently used first.
+   */
+  std::list<Key> lru_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,24 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "file_cached_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+FileCachedException::FileCachedException(const std::string &filename,
+                                         const std::string &pool)
+    : BadgerDbException(""), filename_(filename), pool_(pool) {
+  std::stringstream ss;
+  ss << "File " << filename_ << " has pages cached in buffer pool " << pool_;
+  message_.assign(ss.str());
+}
+
+}  // namespace badgerdb
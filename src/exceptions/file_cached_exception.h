@@ -0,0 +1,53 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a file would be assigned to another
+ *        buffer pool while pages of it are cached in its current one.
+ */
+class FileCachedException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a file cached exception for the given file and pool.
+   *
+   * @param filename  Name of file that has pages cached.
+   * @param pool      Name of pool caching them.
+   */
+  FileCachedException(const std::string &filename, const std::string &pool);
+
+  /**
+   * Returns the name of the file that caused this exception.
+   */
+  virtual const std::string &filename() const { return filename_; }
+
+  /**
+   * Returns the name of the pool caching the file.
+   */
+  virtual const std::string &pool() const { return pool_; }
+
+ protected:
+  /**
+   * Name of file that caused this exception.
+   */
+  const std::string filename_;
+
+  /**
+   * Name of pool caching the file.
+   */
+  const std::string pool_;
+};
+
+}  // namespace badgerdb
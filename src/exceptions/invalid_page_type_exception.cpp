@@ -0,0 +1,25 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "invalid_page_type_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+InvalidPageTypeException::InvalidPageTypeException(
+    const PageId page_num, const std::uint16_t page_type)
+    : BadgerDbException(""), page_number_(page_num), page_type_(page_type) {
+  std::stringstream ss;
+  ss << "Page format does not support the requested access."
+     << " Page: " << page_number_ << " Type: " << page_type_;
+  message_.assign(ss.str());
+}
+
+}  // namespace badgerdb
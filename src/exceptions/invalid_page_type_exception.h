@@ -0,0 +1,56 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page is accessed through an
+ *        interface that does not match the page's format.
+ */
+class InvalidPageTypeException : public BadgerDbException {
+ public:
+  /**
+   * Constructs an invalid page type exception for the given page.
+   *
+   * @param page_num   Number of page with the unexpected format.
+   * @param page_type  Page type stored in the page header.
+   */
+  InvalidPageTypeException(const PageId page_num,
+                           const std::uint16_t page_type);
+
+  /**
+   * Returns the page number of the page which caused this exception.
+   */
+  virtual PageId page_number() const { return page_number_; }
+
+  /**
+   * Returns the page type stored in the header of the page.
+   */
+  virtual std::uint16_t page_type() const { return page_type_; }
+
+ protected:
+  /**
+   * Page number of the page which caused this exception.
+   */
+  const PageId page_number_;
+
+  /**
+   * Page type stored in the header of the page.
+   */
+  const std::uint16_t page_type_;
+};
+
+}  // namespace badgerdb
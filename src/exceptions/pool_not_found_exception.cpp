@@ -0,0 +1,23 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "pool_not_found_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+PoolNotFoundException::PoolNotFoundException(const std::string &name)
+    : BadgerDbException(""), name_(name) {
+  std::stringstream ss;
+  ss << "Buffer pool not found: " << name_;
+  message_.assign(ss.str());
+}
+
+}  // namespace badgerdb
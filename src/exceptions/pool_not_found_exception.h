@@ -0,0 +1,42 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a buffer pool is requested by a
+ *        name that no pool has.
+ */
+class PoolNotFoundException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a pool not found exception for the given pool name.
+   *
+   * @param name  Name of pool that doesn't exist.
+   */
+  explicit PoolNotFoundException(const std::string &name);
+
+  /**
+   * Returns the name of the pool that caused this exception.
+   */
+  virtual const std::string &name() const { return name_; }
+
+ protected:
+  /**
+   * Name of pool that caused this exception.
+   */
+  const std::string name_;
+};
+
+}  // namespace badgerdb
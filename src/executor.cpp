@@ -0,0 +1,58 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "executor.h"
+
+#include <cassert>
+#include <utility>
+
+namespace badgerdb {
+
+Executor::Executor(const std::size_t num_threads) : stopping_(false) {
+  assert(num_threads > 0);
+  for (std::size_t i = 0; i < num_threads; ++i) {
+    workers_.emplace_back(&Executor::work, this);
+  }
+}
+
+Executor::~Executor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  ready_.notify_all();
+  for (std::thread &worker : workers_) {
+    worker.join();
+  }
+}
+
+void Executor::post(std::function<void()> task) {
+  // Notify under the lock: once the task is queued, it may complete and let
+  // the owner destroy the executor as soon as the lock is released.
+  std::lock_guard<std::mutex> lock(mutex_);
+  tasks_.push_back(std::move(task));
+  ready_.notify_one();
+}
+
+void Executor::work() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,94 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+ * @brief Fixed-size thread pool running queued tasks in FIFO order.
+ *
+ * Used both for blocking I/O, so that the threads running request
+ * coroutines never wait on disk, and as the scheduler those coroutines are
+ * resumed on.  All methods are threadsafe.
+ */
+class Executor {
+ public:
+  /**
+   * Starts <num_threads> worker threads.
+   */
+  explicit Executor(const std::size_t num_threads);
+
+  /**
+   * Runs all queued tasks, including ones they post, then stops the
+   * workers.
+   */
+  ~Executor();
+
+  Executor(const Executor &) = delete;
+  Executor &operator=(const Executor &) = delete;
+
+  /**
+   * Queues <task> to run on a worker thread.
+   */
+  void post(std::function<void()> task);
+
+  /**
+   * Queues the resumption of the suspended coroutine <handle>.
+   */
+  void schedule(const std::coroutine_handle<> handle) {
+    post([handle]() { handle.resume(); });
+  }
+
+  /**
+   * Returns the number of worker threads.
+   */
+  std::size_t num_threads() const { return workers_.size(); }
+
+ private:
+  /**
+   * Body of each worker thread.
+   */
+  void work();
+
+  /**
+   * Protects tasks_ and stopping_.
+   */
+  std::mutex mutex_;
+
+  /**
+   * Signalled when a task is queued or the executor stops.
+   */
+  std::condition_variable ready_;
+
+  /**
+   * Tasks not yet started.
+   */
+  std::deque<std::function<void()>> tasks_;
+
+  /**
+   * Set by the destructor; workers exit once the queue is empty.
+   */
+  bool stopping_;
+
+  /**
+   * Worker threads.
+   */
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,243 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "external_sort.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+
+#include "batch_scanner.h"
+#include "record_writer.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * @brief Sequential reader over one sorted run.
+ *
+ * Reads one record per batch so that every reader pins at most one page of
+ * its run; the current record stays valid until advance() is called.
+ */
+class RunReader {
+ public:
+  RunReader(BufMgr *bufMgr, const File &file)
+      : file_(file), scanner_(bufMgr, &file_), batch_(1) {
+    advance();
+  }
+
+  void advance() { valid_ = scanner_.next(batch_); }
+
+  bool valid() const { return valid_; }
+
+  const RecordView &current() const { return batch_[0]; }
+
+  void close() { scanner_.close(); }
+
+ private:
+  File file_;
+  BatchScanner scanner_;
+  RecordBatch batch_;
+  bool valid_;
+};
+
+/**
+ * @brief Loser tree selecting the smallest current record among k runs.
+ *
+ * Internal node i (1 <= i < k) stores the run that lost the match played
+ * there; node 0 stores the overall winner.  Leaf j is the virtual node k + j.
+ * Replacing the winner's record replays only the matches on its leaf-to-root
+ * path, costing log2(k) comparisons.
+ */
+class LoserTree {
+ public:
+  LoserTree(std::vector<std::unique_ptr<RunReader>> &runs,
+            const ExternalSort::Less &less)
+      : runs_(runs), less_(less), tree_(runs.size()) {
+    if (!runs_.empty()) {
+      tree_[0] = build(1);
+    }
+  }
+
+  /**
+   * Returns the run holding the smallest record, or an exhausted run if all
+   * runs are exhausted.
+   */
+  std::size_t winner() const { return tree_[0]; }
+
+  /**
+   * Advances the winning run and restores the tree.
+   */
+  void advanceWinner() {
+    std::size_t winner = tree_[0];
+    runs_[winner]->advance();
+    for (std::size_t node = (winner + tree_.size()) / 2; node > 0; node /= 2) {
+      if (beats(tree_[node], winner)) {
+        std::swap(tree_[node], winner);
+      }
+    }
+    tree_[0] = winner;
+  }
+
+ private:
+  /**
+   * Plays the matches below <node>, returning the winner.
+   */
+  std::size_t build(const std::size_t node) {
+    if (node >= tree_.size()) {
+      return node - tree_.size();
+    }
+    const std::size_t left = build(2 * node);
+    const std::size_t right = build(2 * node + 1);
+    if (beats(left, right)) {
+      tree_[node] = right;
+      return left;
+    }
+    tree_[node] = left;
+    return right;
+  }
+
+  /**
+   * Returns true if run <a> wins against run <b>.  Exhausted runs always
+   * lose; ties go to the lower run to keep the merge stable.
+   */
+  bool beats(const std::size_t a, const std::size_t b) const {
+    if (!runs_[a]->valid()) {
+      return false;
+    }
+    if (!runs_[b]->valid()) {
+      return true;
+    }
+    const RecordView &ra = runs_[a]->current();
+    const RecordView &rb = runs_[b]->current();
+    if (less_(ra, rb)) {
+      return true;
+    }
+    return !less_(rb, ra) && a < b;
+  }
+
+  std::vector<std::unique_ptr<RunReader>> &runs_;
+  const ExternalSort::Less &less_;
+  std::vector<std::size_t> tree_;
+};
+
+}  // namespace
+
+bool ExternalSort::bytewiseLess(const RecordView &a, const RecordView &b) {
+  const int cmp = std::memcmp(a.data, b.data, std::min(a.length, b.length));
+  return cmp < 0 || (cmp == 0 && a.length < b.length);
+}
+
+ExternalSort::ExternalSort(BufMgr *bufMgr, TempFileManager *temp_files,
+                           const double memory_fraction, const Less &less)
+    : bufMgr_(bufMgr),
+      temp_files_(temp_files),
+      less_(less),
+      num_runs_(0),
+      num_merge_passes_(0) {
+  assert(bufMgr_ != NULL && temp_files_ != NULL);
+  assert(memory_fraction > 0 && memory_fraction <= 1);
+  const std::size_t frames = std::max<std::size_t>(
+      2, static_cast<std::size_t>(bufMgr_->numFrames() * memory_fraction));
+  run_bytes_ = std::max(std::size_t(Page::DATA_SIZE), frames * Page::SIZE);
+  // The input scan and each run reader pin pages next to the page of the
+  // run or output writer.
+  scan_pages_ = frames - 1;
+  fan_in_ = std::max<std::size_t>(2, frames - 1);
+}
+
+void ExternalSort::sort(File &input, File &output) {
+  num_runs_ = 0;
+  num_merge_passes_ = 0;
+
+  // Run generation.  The arena never grows past its reserved size, so views
+  // into it stay valid until the run is written.
+  std::vector<File> runs;
+  std::vector<char> arena;
+  arena.reserve(run_bytes_);
+  std::vector<RecordView> records;
+  {
+    BatchScanner scanner(bufMgr_, &input, scan_pages_);
+    RecordBatch batch;
+    while (scanner.next(batch)) {
+      for (const RecordView &view : batch) {
+        if (arena.size() + view.length > run_bytes_) {
+          runs.push_back(temp_files_->create());
+          writeRun(records, runs.back());
+          arena.clear();
+          records.clear();
+        }
+        const std::size_t offset = arena.size();
+        arena.insert(arena.end(), view.data, view.data + view.length);
+        records.push_back({view.rid, arena.data() + offset, view.length});
+      }
+    }
+  }
+
+  if (runs.empty()) {
+    // Everything fit in memory; no merge needed.
+    num_runs_ = records.empty() ? 0 : 1;
+    writeRun(records, output);
+    return;
+  }
+  if (!records.empty()) {
+    runs.push_back(temp_files_->create());
+    writeRun(records, runs.back());
+  }
+  num_runs_ = runs.size();
+
+  while (runs.size() > fan_in_) {
+    std::vector<File> merged;
+    for (std::size_t i = 0; i < runs.size(); i += fan_in_) {
+      std::vector<File> group(
+          runs.begin() + i, runs.begin() + std::min(runs.size(), i + fan_in_));
+      merged.push_back(temp_files_->create());
+      mergeRuns(group, merged.back());
+    }
+    runs.swap(merged);
+    ++num_merge_passes_;
+  }
+  mergeRuns(runs, output);
+  ++num_merge_passes_;
+}
+
+void ExternalSort::writeRun(std::vector<RecordView> &records, File &output) {
+  std::sort(records.begin(), records.end(), less_);
+  RecordWriter writer(bufMgr_, &output);
+  for (const RecordView &record : records) {
+    writer.append(record.data, record.length);
+  }
+}
+
+void ExternalSort::mergeRuns(std::vector<File> &runs, File &output) {
+  std::vector<std::unique_ptr<RunReader>> readers;
+  for (const File &run : runs) {
+    readers.emplace_back(new RunReader(bufMgr_, run));
+  }
+  {
+    RecordWriter writer(bufMgr_, &output);
+    LoserTree tree(readers, less_);
+    while (readers[tree.winner()]->valid()) {
+      const RecordView &record = readers[tree.winner()]->current();
+      writer.append(record.data, record.length);
+      tree.advanceWinner();
+    }
+  }
+  for (std::unique_ptr<RunReader> &reader : readers) {
+    reader->close();
+  }
+  readers.clear();
+  // The runs are not needed any more, so their pages need not be written.
+  for (File &run : runs) {
+    temp_files_->drop(run);
+  }
+}
+
+}  // namespace badgerdb
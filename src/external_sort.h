@@ -0,0 +1,131 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "record_batch.h"
+#include "temp_file_manager.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Sorts the records of a file that may be larger than memory.
+ *
+ * Records are read with batch scans, pinning no more pages than the
+ * configured share of the buffer pool, and collected in memory until that
+ * share is used.  Each full memory load is
+ * sorted and spilled as a run to a temporary file through the buffer manager.
+ * Runs are then combined with a k-way merge driven by a loser tree; if there
+ * are more runs than the pool can read at once, intermediate merge passes
+ * reduce their number first.  The output is written as packed pages.
+ *
+ * @warning This class is not threadsafe.
+ */
+class ExternalSort {
+ public:
+  /**
+   * Strict weak ordering of records.
+   */
+  typedef std::function<bool(const RecordView &a, const RecordView &b)> Less;
+
+  /**
+   * Orders records by their bytes, shorter records first on a common prefix.
+   */
+  static bool bytewiseLess(const RecordView &a, const RecordView &b);
+
+  /**
+   * Constructs a sort operator.
+   *
+   * @param bufMgr          Buffer manager for all page accesses.
+   * @param temp_files      Manager creating the temporary run files.
+   * @param memory_fraction Share of the buffer pool used for run generation
+   *                        and merge input, between 0 and 1.
+   * @param less            Order to sort records in.
+   */
+  ExternalSort(BufMgr *bufMgr, TempFileManager *temp_files,
+               const double memory_fraction = 0.5,
+               const Less &less = bytewiseLess);
+
+  /**
+   * Writes the records of <input> to <output> in sorted order.  <output>
+   * should be empty.  Temporary files are dropped before returning.
+   *
+   * @param input   File to sort.
+   * @param output  File receiving the sorted records.
+   */
+  void sort(File &input, File &output);
+
+  /**
+   * Returns the number of runs generated by the last sort.
+   */
+  std::size_t num_runs() const { return num_runs_; }
+
+  /**
+   * Returns the number of merge passes performed by the last sort.
+   */
+  std::size_t num_merge_passes() const { return num_merge_passes_; }
+
+ private:
+  /**
+   * Sorts one memory load and writes it to <output>.
+   */
+  void writeRun(std::vector<RecordView> &records, File &output);
+
+  /**
+   * Merges the given runs into <output> and drops the run files.
+   */
+  void mergeRuns(std::vector<File> &runs, File &output);
+
+  /**
+   * Buffer manager for all page accesses.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * Manager creating the temporary run files.
+   */
+  TempFileManager *temp_files_;
+
+  /**
+   * Bytes of record data collected per run.
+   */
+  std::size_t run_bytes_;
+
+  /**
+   * Maximum number of input pages pinned at once during run generation.
+   */
+  std::size_t scan_pages_;
+
+  /**
+   * Maximum number of runs merged at once.
+   */
+  std::size_t fan_in_;
+
+  /**
+   * Record order.
+   */
+  Less less_;
+
+  /**
+   * Number of runs generated by the last sort.
+   */
+  std::size_t num_runs_;
+
+  /**
+   * Number of merge passes performed by the last sort.
+   */
+  std::size_t num_merge_passes_;
+};
+
+}  // namespace badgerdb
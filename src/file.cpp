@@ -8,6 +8,12 @@
 
 #include "file.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <fstream>
@@ -20,21 +26,71 @@
 #include "exceptions/file_open_exception.h"
 #include "exceptions/invalid_page_exception.h"
 #include "file_iterator.h"
+#include "overflow_page.h"
 #include "page.h"
 
 namespace badgerdb {
 
 File::StreamMap File::open_streams_;
 File::CountMap File::open_counts_;
+File::SegmentMap File::open_segments_;
+std::mutex File::maps_mutex_;
+
+namespace {
 
-File File::create(const std::string &filename) {
-  return File(filename, true /* create_new */);
+/**
+ * Returns the size of the file open as <fd>, or 0 if unknown.
+ */
+std::streamoff fileSize(const int fd) {
+  struct stat st;
+  if (fd < 0 || ::fstat(fd, &st) != 0) {
+    return 0;
+  }
+  return st.st_size;
+}
+
+}  // namespace
+
+File File::create(const std::string &filename, const PageId segment_pages) {
+  return File(filename, true /* create_new */, segment_pages);
 }
 
 File File::open(const std::string &filename) {
   return File(filename, false /* create_new */);
 }
 
+File File::createAnonymous(const std::string &filename) {
+  std::shared_ptr<std::fstream> stream(new std::fstream(
+      filename, std::fstream::in | std::fstream::out | std::fstream::binary |
+                    std::fstream::trunc));
+  if (!*stream) {
+    throw FileNotFoundException(filename);
+  }
+  const int fd = ::open(filename.c_str(), O_RDWR);
+  ::unlink(filename.c_str());
+
+  File file;
+  file.filename_ = filename;
+  file.valid_ = true;
+  file.stream_ = stream;
+  Segments segments;
+  segments.open.push_back(Segment{stream, fd, 0});
+  segments.anonymous = true;
+  {
+    std::lock_guard<std::mutex> lock(maps_mutex_);
+    open_streams_[filename] = stream;
+    open_counts_[filename] = 1;
+    open_segments_[filename] = segments;
+  }
+
+  // File starts with 1 page (the header).
+  FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
+                       0 /* num_free_pages */, 0 /* first_free_page */,
+                       0 /* segment_pages */};
+  file.writeHeader(header);
+  return file;
+}
+
 void File::remove(const std::string &filename) {
   if (!exists(filename)) {
     throw FileNotFoundException(filename);
@@ -42,13 +98,31 @@ void File::remove(const std::string &filename) {
   if (isOpen(filename)) {
     throw FileOpenException(filename);
   }
+  // Only segmented files own "<filename>.<n>" files; others may share the
+  // pattern by accident.
+  FileHeader header = {};
+  {
+    std::ifstream in(filename, std::ios::binary);
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in) {
+      header.segment_pages = 0;
+    }
+  }
   std::remove(filename.c_str());
+  if (header.segment_pages == 0) {
+    return;
+  }
+  for (std::size_t segment = 1; exists(segmentName(filename, segment));
+       ++segment) {
+    std::remove(segmentName(filename, segment).c_str());
+  }
 }
 
 bool File::isOpen(const std::string &filename) {
   if (!exists(filename)) {
     return false;
   }
+  std::lock_guard<std::mutex> lock(maps_mutex_);
   return open_counts_.find(filename) != open_counts_.end();
 }
 
@@ -64,8 +138,10 @@ bool File::exists(const std::string &filename) {
 
 File::File(const File &other)
     : filename_(other.filename_),
-      stream_(open_streams_[filename_]),
+      segment_pages_(other.segment_pages_),
       valid_(other.valid_) {
+  std::lock_guard<std::mutex> lock(maps_mutex_);
+  stream_ = open_streams_[filename_];
   ++open_counts_[filename_];
 }
 
@@ -74,6 +150,7 @@ File &File::operator=(const File &rhs) {
   // same file.
   close();  // close my file and associate me with the new one
   filename_ = rhs.filename_;
+  segment_pages_ = rhs.segment_pages_;
   valid_ = rhs.valid_;
   openIfNeeded(false /* create_new */);
   return *this;
@@ -81,7 +158,7 @@ File &File::operator=(const File &rhs) {
 
 File::~File() { close(); }
 
-Page File::allocatePage() {
+Page File::allocatePage(PageId *previous) {
   FileHeader header = readHeader();
   Page new_page;
   Page existing_page;
@@ -120,6 +197,7 @@ Page File::allocatePage() {
            (header.first_free_page == Page::INVALID_NUMBER));
   } else {
     new_page.set_page_number(header.num_pages);
+    reserveExtent(new_page.page_number());
     if (header.first_used_page == Page::INVALID_NUMBER) {
       header.first_used_page = new_page.page_number();
     } else {
@@ -143,6 +221,9 @@ Page File::allocatePage() {
     writePage(existing_page.page_number(), existing_page);
   }
   writeHeader(header);
+  if (previous != NULL) {
+    *previous = existing_page.page_number();
+  }
 
   return new_page;
 }
@@ -156,10 +237,11 @@ Page File::readPage(const PageId page_number) const {
 }
 
 Page File::readPage(const PageId page_number, const bool allow_free) const {
-  Page page;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char *>(&page.header_), sizeof(page.header_));
-  stream_->read(&page.data_[0], Page::DATA_SIZE);
+  Page page{Page::Uninitialized()};
+  std::fstream &stream = pageStream(page_number);
+  stream.seekg(pagePosition(page_number, segment_pages_), std::ios::beg);
+  stream.read(reinterpret_cast<char *>(&page.header_), sizeof(page.header_));
+  stream.read(&page.data_[0], Page::DATA_SIZE);
   if (!allow_free && !page.isUsed()) {
     throw InvalidPageException(page_number, filename_);
   }
@@ -167,6 +249,56 @@ Page File::readPage(const PageId page_number, const bool allow_free) const {
   return page;
 }
 
+Page File::preadPage(const PageId page_number) const {
+  Page page{Page::Uninitialized()};
+  Page *const pages[] = {&page};
+  preadPages(&page_number, 1, pages);
+  return page;
+}
+
+void File::preadPages(const PageId *page_numbers, const std::size_t count,
+                      Page *const *pages) const {
+  // Descriptors of the segments the pages are in; segment 0 holds the header.
+  std::vector<int> fds;
+  {
+    std::lock_guard<std::mutex> lock(maps_mutex_);
+    std::size_t last_segment = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      last_segment = std::max(
+          last_segment, pageSegment(page_numbers[i], segment_pages_));
+    }
+    const Segments &segments = openSegments(last_segment);
+    for (const Segment &segment : segments.open) {
+      fds.push_back(segment.fd);
+    }
+  }
+  if (fds[0] < 0) {
+    throw FileNotFoundException(filename_);
+  }
+
+  for (std::size_t i = 0; i < count; ++i) {
+    const PageId page_number = page_numbers[i];
+    if (page_number == Page::INVALID_NUMBER) {
+      throw InvalidPageException(page_number, filename_);
+    }
+    const std::size_t segment = pageSegment(page_number, segment_pages_);
+    if (fds[segment] < 0) {
+      throw FileNotFoundException(segmentName(filename_, segment));
+    }
+    Page &page = *pages[i];
+    struct iovec iov[] = {{&page.header_, sizeof(page.header_)},
+                          {&page.data_[0], Page::DATA_SIZE}};
+    // The header is not consulted: pages past the end read short, and free
+    // or preallocated pages do not carry their own number.
+    if (::preadv(fds[segment], iov, 2,
+                 pagePosition(page_number, segment_pages_)) !=
+            static_cast<ssize_t>(Page::SIZE) ||
+        page.page_number() != page_number) {
+      throw InvalidPageException(page_number, filename_);
+    }
+  }
+}
+
 void File::writePage(const Page &new_page) {
   PageHeader header = readPageHeader(new_page.page_number());
   if (header.current_page_number == Page::INVALID_NUMBER) {
@@ -182,7 +314,8 @@ void File::writePage(const Page &new_page) {
   writePage(new_page.page_number(), header, new_page);
 }
 
-void File::deletePage(const PageId page_number) {
+void File::deletePage(const PageId page_number, PageId *previous,
+                      PageId *next) {
   FileHeader header = readHeader();
   Page existing_page = readPage(page_number);
   Page previous_page;
@@ -200,6 +333,13 @@ void File::deletePage(const PageId page_number) {
       }
     }
   }
+  if (previous != NULL) {
+    *previous = previous_page.isUsed() ? previous_page.page_number()
+                                       : Page::INVALID_NUMBER;
+  }
+  if (next != NULL) {
+    *next = existing_page.next_page_number();
+  }
   // Clear the page and add it to the head of the free list.
   existing_page.initialize();
   existing_page.set_next_page_number(header.first_free_page);
@@ -212,6 +352,71 @@ void File::deletePage(const PageId page_number) {
   writeHeader(header);
 }
 
+std::map<PageId, PageId> File::compact() {
+  FileHeader header = readHeader();
+  std::vector<PageId> used;
+  for (PageId page_number = header.first_used_page;
+       page_number != Page::INVALID_NUMBER;
+       page_number = readPageHeader(page_number).next_page_number) {
+    used.push_back(page_number);
+  }
+  std::sort(used.begin(), used.end());
+
+  // Pages that already lie within the first used.size() pages stay; the
+  // others fill the holes between them in order.
+  const PageId num_used = used.size();
+  std::vector<bool> occupied(num_used + 1, false);
+  for (const PageId page_number : used) {
+    if (page_number <= num_used) {
+      occupied[page_number] = true;
+    }
+  }
+  std::map<PageId, PageId> moved;
+  PageId hole = 1;
+  for (const PageId page_number : used) {
+    if (page_number <= num_used) {
+      continue;
+    }
+    while (occupied[hole]) {
+      ++hole;
+    }
+    Page page = readPage(page_number, false /* allow_free */);
+    page.set_page_number(hole);
+    writePage(hole, page);
+    occupied[hole] = true;
+    moved[page_number] = hole;
+  }
+
+  for (PageId page_number = 1; page_number <= num_used; ++page_number) {
+    const PageId next_used =
+        page_number < num_used ? page_number + 1 : Page::INVALID_NUMBER;
+    PageHeader page_header = readPageHeader(page_number);
+    if (page_header.page_type != static_cast<std::uint16_t>(
+                                     PageType::OVERFLOW)) {
+      page_header.next_page_number = next_used;
+      writePageHeader(page_number, page_header);
+      continue;
+    }
+    // Overflow chains link their pages through the data area as well.
+    Page page = readPage(page_number, false /* allow_free */);
+    page.set_next_page_number(next_used);
+    OverflowPage chunk(&page);
+    const std::map<PageId, PageId>::const_iterator forward =
+        moved.find(chunk.next_page());
+    if (forward != moved.end()) {
+      chunk.set_next_page(forward->second);
+    }
+    writePage(page_number, page);
+  }
+  header.num_pages = num_used + 1;
+  header.first_used_page = num_used > 0 ? 1 : Page::INVALID_NUMBER;
+  header.num_free_pages = 0;
+  header.first_free_page = Page::INVALID_NUMBER;
+  writeHeader(header);
+  truncate(header.num_pages);
+  return moved;
+}
+
 FileIterator File::begin() {
   const FileHeader &header = readHeader();
   return FileIterator(this, header.first_used_page);
@@ -219,19 +424,24 @@ FileIterator File::begin() {
 
 FileIterator File::end() { return FileIterator(this, Page::INVALID_NUMBER); }
 
-File::File(const std::string &name, const bool create_new)
-    : filename_(name), valid_(true) {
+File::File(const std::string &name, const bool create_new,
+           const PageId segment_pages)
+    : filename_(name), segment_pages_(segment_pages), valid_(true) {
   openIfNeeded(create_new);
 
   if (create_new) {
     // File starts with 1 page (the header).
     FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
-                         0 /* num_free_pages */, 0 /* first_free_page */};
+                         0 /* num_free_pages */, 0 /* first_free_page */,
+                         segment_pages};
     writeHeader(header);
+  } else {
+    segment_pages_ = readHeader().segment_pages;
   }
 }
 
 void File::openIfNeeded(const bool create_new) {
+  std::lock_guard<std::mutex> lock(maps_mutex_);
   if (open_counts_.find(filename_) !=
       open_counts_.end()) {  // exists an entry already
     ++open_counts_[filename_];
@@ -257,15 +467,89 @@ void File::openIfNeeded(const bool create_new) {
     stream_.reset(new std::fstream(filename_, mode));
     open_streams_[filename_] = stream_;
     open_counts_[filename_] = 1;
+    const int fd = ::open(filename_.c_str(), O_RDWR);
+    Segments segments;
+    segments.open.push_back(Segment{stream_, fd, fileSize(fd)});
+    segments.anonymous = false;
+    open_segments_[filename_] = segments;
+  }
+}
+
+std::fstream &File::pageStream(const PageId page_number) const {
+  const std::size_t segment = pageSegment(page_number, segment_pages_);
+  if (segment == 0) {
+    return *stream_;
+  }
+  std::lock_guard<std::mutex> lock(maps_mutex_);
+  return *openSegments(segment).open[segment].stream;
+}
+
+File::Segments &File::openSegments(const std::size_t segment) const {
+  const SegmentMap::iterator it = open_segments_.find(filename_);
+  assert(it != open_segments_.end());
+  Segments &segments = it->second;
+  while (segments.open.size() <= segment) {
+    segments.open.push_back(
+        openSegment(segments.open.size(), segments.anonymous));
+  }
+  return segments;
+}
+
+File::Segment File::openSegment(const std::size_t segment,
+                                const bool anonymous) const {
+  const std::string name = segmentName(filename_, segment);
+  std::ios_base::openmode mode =
+      std::fstream::in | std::fstream::out | std::fstream::binary;
+  if (!exists(name)) {
+    mode = mode | std::fstream::trunc;
+  }
+  std::shared_ptr<std::fstream> stream(new std::fstream(name, mode));
+  if (!*stream) {
+    throw FileNotFoundException(name);
+  }
+  const int fd = ::open(name.c_str(), O_RDWR);
+  if (anonymous) {
+    ::unlink(name.c_str());
+  }
+  return Segment{stream, fd, fileSize(fd)};
+}
+
+void File::reserveExtent(const PageId page_number) {
+  const std::size_t index = pageSegment(page_number, segment_pages_);
+  std::lock_guard<std::mutex> lock(maps_mutex_);
+  Segment &segment = openSegments(index).open[index];
+  const std::streamoff begin = pagePosition(page_number, segment_pages_);
+  if (segment.fd < 0 ||
+      begin + std::streamoff(Page::SIZE) <= segment.allocated) {
+    return;
+  }
+  PageId extent_pages = EXTENT_PAGES;
+  if (segment_pages_ != 0) {
+    extent_pages = std::min<PageId>(
+        extent_pages, segment_pages_ - (page_number - 1) % segment_pages_);
+  }
+  const std::streamoff length = std::streamoff(extent_pages) * Page::SIZE;
+  if (::posix_fallocate(segment.fd, begin, length) == 0) {
+    segment.allocated = begin + length;
   }
 }
 
 void File::close() {
+  std::lock_guard<std::mutex> lock(maps_mutex_);
   --open_counts_[filename_];
   stream_.reset();
   if (open_counts_[filename_] == 0) {
     open_streams_.erase(filename_);
     open_counts_.erase(filename_);
+    SegmentMap::iterator segments = open_segments_.find(filename_);
+    if (segments != open_segments_.end()) {
+      for (const Segment &segment : segments->second.open) {
+        if (segment.fd >= 0) {
+          ::close(segment.fd);
+        }
+      }
+      open_segments_.erase(segments);
+    }
   }
 }
 
@@ -275,10 +559,11 @@ void File::writePage(const PageId page_number, const Page &new_page) {
 
 void File::writePage(const PageId page_number, const PageHeader &header,
                      const Page &new_page) {
-  stream_->seekp(pagePosition(page_number), std::ios::beg);
-  stream_->write(reinterpret_cast<const char *>(&header), sizeof(header));
-  stream_->write(&new_page.data_[0], Page::DATA_SIZE);
-  stream_->flush();
+  std::fstream &stream = pageStream(page_number);
+  stream.seekp(pagePosition(page_number, segment_pages_), std::ios::beg);
+  stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  stream.write(&new_page.data_[0], Page::DATA_SIZE);
+  stream.flush();
 }
 
 FileHeader File::readHeader() const {
@@ -295,10 +580,53 @@ void File::writeHeader(const FileHeader &header) {
   stream_->flush();
 }
 
+void File::writePageHeader(const PageId page_number, const PageHeader &header) {
+  std::fstream &stream = pageStream(page_number);
+  stream.seekp(pagePosition(page_number, segment_pages_), std::ios::beg);
+  stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  stream.flush();
+}
+
+void File::truncate(const PageId num_pages) {
+  // The last page kept, or the header if no page is.
+  const PageId last_page = num_pages - 1;
+  const std::size_t last_segment =
+      last_page == 0 ? 0 : pageSegment(last_page, segment_pages_);
+  const std::streamoff end =
+      last_page == 0 ? std::streamoff(sizeof(FileHeader))
+                     : std::streamoff(pagePosition(last_page, segment_pages_)) +
+                           std::streamoff(Page::SIZE);
+  std::lock_guard<std::mutex> lock(maps_mutex_);
+  Segments &segments = openSegments(last_segment);
+  Segment &segment = segments.open[last_segment];
+  if (segment.fd >= 0 && ::ftruncate(segment.fd, end) == 0) {
+    segment.allocated = end;
+  }
+
+  // Drop whole segments past the end, including ones not opened yet.
+  while (segments.open.size() > last_segment + 1) {
+    const std::size_t index = segments.open.size() - 1;
+    if (segments.open[index].fd >= 0) {
+      ::close(segments.open[index].fd);
+    }
+    if (!segments.anonymous) {
+      std::remove(segmentName(filename_, index).c_str());
+    }
+    segments.open.pop_back();
+  }
+  if (!segments.anonymous) {
+    for (std::size_t index = last_segment + 1;
+         exists(segmentName(filename_, index)); ++index) {
+      std::remove(segmentName(filename_, index).c_str());
+    }
+  }
+}
+
 PageHeader File::readPageHeader(PageId page_number) const {
   PageHeader header;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char *>(&header), sizeof(header));
+  std::fstream &stream = pageStream(page_number);
+  stream.seekg(pagePosition(page_number, segment_pages_), std::ios::beg);
+  stream.read(reinterpret_cast<char *>(&header), sizeof(header));
 
   return header;
 }
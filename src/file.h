@@ -11,7 +11,9 @@
 #include <fstream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "page.h"
 
@@ -43,6 +45,12 @@ struct FileHeader {
    */
   PageId first_free_page;
 
+  /**
+   * Number of pages per segment file, or 0 if all pages are stored in this
+   * file.
+   */
+  PageId segment_pages;
+
   /**
    * Returns true if this file header is equal to the other.
    *
@@ -52,7 +60,8 @@ struct FileHeader {
   bool operator==(const FileHeader &rhs) const {
     return num_pages == rhs.num_pages && num_free_pages == rhs.num_free_pages &&
            first_used_page == rhs.first_used_page &&
-           first_free_page == rhs.first_free_page;
+           first_free_page == rhs.first_free_page &&
+           segment_pages == rhs.segment_pages;
   }
 };
 
@@ -69,17 +78,33 @@ struct FileHeader {
  * returns a file object with the already created stream for the file without
  * actually opening the UNIX file again.
  *
- * @warning This class is not threadsafe.
+ * Files grow by extents of EXTENT_PAGES pages, preallocated on disk with
+ * posix_fallocate() so that pages allocated one after the other are also
+ * contiguous on disk.  A file may also be split into segments of a fixed
+ * number of pages: the first segment is stored together with the file
+ * header, segment <n> in a file named "<filename>.<n>".  Segments are
+ * created as the file grows; page numbers are unaffected by the split.
+ *
+ * @warning This class is not threadsafe.  Different files may be used from
+ * different threads at once, but one file only from one thread at a time.
  */
 class File {
  public:
+  /**
+   * Number of pages by which files grow on disk at a time.
+   */
+  static const PageId EXTENT_PAGES = 64;
+
   /**
    * Creates a new file.
    *
-   * @param filename  Name of the file.
+   * @param filename       Name of the file.
+   * @param segment_pages  Number of pages per segment file, or 0 to keep all
+   *                       pages in one file.
    * @throws  FileExistsException     If the requested file already exists.
    */
-  static File create(const std::string &filename);
+  static File create(const std::string &filename,
+                     const PageId segment_pages = 0);
 
   /**
    * Opens the file named fileName and returns the corresponding File object.
@@ -97,7 +122,7 @@ class File {
   static File open(const std::string &filename);
 
   /**
-   * Deletes an existing file.
+   * Deletes an existing file together with its segment files.
    *
    * @param filename  Name of the file.
    * @throws  FileNotFoundException   If the file doesn't exist.
@@ -158,9 +183,12 @@ class File {
   /**
    * Allocates a new page in the file.
    *
+   * @param previous  If not NULL, set to the number of the used page whose
+   *                  next page is now the new page, or Page::INVALID_NUMBER
+   *                  if the new page heads the used list.
    * @return The new page.
    */
-  Page allocatePage();
+  Page allocatePage(PageId *previous = NULL);
 
   /**
    * Reads an existing page from the file.
@@ -172,6 +200,36 @@ class File {
    */
   Page readPage(const PageId page_number) const;
 
+  /**
+   * Reads an existing page like readPage(), but with pread() on the
+   * descriptors of the file's segments instead of through the shared
+   * stream.  Several threads may call this at once on the same file, as
+   * long as no other method of the file runs meanwhile.
+   *
+   * @param page_number   Number of page to read.
+   * @return  The page.
+   * @throws  InvalidPageException  If the page doesn't exist in the file or is
+   *                                not currently used.
+   * @throws  FileNotFoundException  If the file has no descriptor open.
+   */
+  Page preadPage(const PageId page_number) const;
+
+  /**
+   * Reads the existing pages <page_numbers>[0, count) into *<pages>[0,
+   * count) like preadPage(), with one preadv() call per page.  The
+   * pages are read into place, so the Page objects may be buffer frames.
+   *
+   * @param page_numbers  Numbers of the pages to read.
+   * @param count         Number of pages to read.
+   * @param pages         Pages to read into.
+   * @throws  InvalidPageException  If a page doesn't exist in the file or is
+   *                                not currently used; the pages may have been
+   *                                partly overwritten then.
+   * @throws  FileNotFoundException  If the file has no descriptor open.
+   */
+  void preadPages(const PageId *page_numbers, const std::size_t count,
+                  Page *const *pages) const;
+
   /**
    * Writes a page into the file, replacing any existing contents.  The page
    * must have been already allocated in this file by a call to allocatePage().
@@ -185,8 +243,33 @@ class File {
    * Deletes a page from the file.
    *
    * @param page_number   Number of page to delete.
+   * @param previous      If not NULL, set to the number of the used page that
+   *                      was linked to the deleted page, or
+   *                      Page::INVALID_NUMBER if it headed the used list.
+   * @param next          If not NULL, set to the number of the page that
+   *                      followed the deleted page in the used list.
+   */
+  void deletePage(const PageId page_number, PageId *previous = NULL,
+                  PageId *next = NULL);
+
+  /**
+   * Moves all used pages to the front of the file, relinks them in page
+   * number order and truncates the free pages at the end, so that the file
+   * holds no free pages and a scan reads it front to back.  Pages keep
+   * their contents but pages past the new end get new numbers, which
+   * changes the RecordIds of their records.  Links between the pages of
+   * overflow chains are forwarded; OverflowPointers stored in records must
+   * be forwarded by the caller, like RecordIds.
+   *
+   * This is offline compaction, done in one pass over the whole file: no
+   * other method of the file may run meanwhile, and no page of the file
+   * may be cached; use BufMgr::compactFile() for files read through a
+   * buffer manager.
+   *
+   * @return  Forwarding map from the old to the new number of every page
+   *          that was moved.
    */
-  void deletePage(const PageId page_number);
+  std::map<PageId, PageId> compact();
 
   /**
    * Returns the name of the file this object represents.
@@ -195,6 +278,12 @@ class File {
    */
   const std::string &filename() const { return filename_; }
 
+  /**
+   * Returns the number of pages per segment file, or 0 if the file is not
+   * segmented.
+   */
+  PageId segment_pages() const { return segment_pages_; }
+
   /**
    * Returns an iterator at the first page in the file.
    *
@@ -221,10 +310,11 @@ class File {
    * Creates an empty file
    * @return File object with valid_ bit set to false
    */
-  File() : valid_(false) {}
+  File() : segment_pages_(0), valid_(false) {}
 
  private:
   friend class BufMgr;
+  friend class TempFileManager;
 
   /**
    * Constructs a file object representing a file on the filesystem.
@@ -233,26 +323,86 @@ class File {
    *
    * @see File::create()
    * @see File::open()
-   * @param name        Name of file.
-   * @param create_new  Whether to create a new file.
+   * @param name           Name of file.
+   * @param create_new     Whether to create a new file.
+   * @param segment_pages  Number of pages per segment of a new file.
    * @throws  FileExistsException     If the underlying file exists and
    *                                  create_new is true.
    * @throws  FileNotFoundException   If the underlying file doesn't exist and
    *                                  create_new is false.
    */
-  explicit File(const std::string &name, const bool create_new);
+  explicit File(const std::string &name, const bool create_new,
+                const PageId segment_pages = 0);
 
   /**
-   * Returns the position of the page with the given number in the file (as an
-   * offset from the beginning of the file).
+   * Creates a new file without checking whether it already exists, and
+   * unlinks it from the filesystem right away.  The file stays usable
+   * through the returned object and its copies and disappears when the last
+   * of them is destroyed, even if the process crashes.
+   *
+   * The name must be unique among open files; it is only used to identify
+   * the file within the process.
    *
-   * @param page_number   Number of page.
+   * @param filename  Name to create the file under.
+   * @throws  FileNotFoundException  If the file could not be created, e.g.
+   *                                 because its directory does not exist.
+   */
+  static File createAnonymous(const std::string &filename);
+
+  /**
+   * Returns the segment holding the page with the given number.
+   *
+   * @param page_number    Number of page.
+   * @param segment_pages  Number of pages per segment, or 0.
+   * @return  Index of the segment; 0 for the file holding the header.
+   */
+  static std::size_t pageSegment(const PageId page_number,
+                                 const PageId segment_pages) {
+    return segment_pages == 0 ? 0 : (page_number - 1) / segment_pages;
+  }
+
+  /**
+   * Returns the position of the page with the given number in its segment
+   * (as an offset from the beginning of the segment's file).
+   *
+   * @param page_number    Number of page.
+   * @param segment_pages  Number of pages per segment, or 0.
    * @return  Position of page in file.
    */
-  static std::streampos pagePosition(const PageId page_number) {
-    return sizeof(FileHeader) + ((page_number - 1) * Page::SIZE);
+  static std::streampos pagePosition(const PageId page_number,
+                                     const PageId segment_pages = 0) {
+    if (segment_pages == 0) {
+      return sizeof(FileHeader) + ((page_number - 1) * Page::SIZE);
+    }
+    const std::streamoff offset =
+        ((page_number - 1) % segment_pages) * Page::SIZE;
+    return pageSegment(page_number, segment_pages) == 0
+               ? sizeof(FileHeader) + offset
+               : offset;
+  }
+
+  /**
+   * Returns the name of the file storing segment <segment> of <filename>.
+   */
+  static std::string segmentName(const std::string &filename,
+                                 const std::size_t segment) {
+    return segment == 0 ? filename : filename + "." + std::to_string(segment);
   }
 
+  /**
+   * Returns the stream of the segment holding <page_number>, opening or
+   * creating the segment's file if needed.
+   */
+  std::fstream &pageStream(const PageId page_number) const;
+
+  /**
+   * Preallocates disk space for an extent starting at <page_number> unless
+   * that page already has space.  Extents do not cross segments.  Failure
+   * to preallocate is ignored; the space is then allocated when the page is
+   * written.
+   */
+  void reserveExtent(const PageId page_number);
+
   /**
    * Opens the underlying file named in filename_.
    * This method only opens the file if no other File objects exist that access
@@ -333,8 +483,73 @@ class File {
    */
   PageHeader readPageHeader(const PageId page_number) const;
 
+  /**
+   * Writes only the header of the given page to disk.  No bounds checking
+   * is performed.
+   *
+   * @param page_number   Number of page whose header is to be written.
+   * @param header        Header to write.
+   */
+  void writePageHeader(const PageId page_number, const PageHeader &header);
+
+  /**
+   * Shrinks the file on disk to hold pages below <num_pages> only, removing
+   * segments that are no longer needed.
+   *
+   * @param num_pages   Number of pages to keep, including the header.
+   */
+  void truncate(const PageId num_pages);
+
+  /**
+   * An open segment of a file.
+   */
+  struct Segment {
+    /**
+     * Stream for reading and writing pages.
+     */
+    std::shared_ptr<std::fstream> stream;
+
+    /**
+     * Descriptor for preallocating space, or -1.
+     */
+    int fd;
+
+    /**
+     * Bytes of the segment's file known to be allocated on disk.
+     */
+    std::streamoff allocated;
+  };
+
+  /**
+   * Segments of an open file.
+   */
+  struct Segments {
+    /**
+     * Open segments, by index; segment 0 shares the file's stream.
+     */
+    std::vector<Segment> open;
+
+    /**
+     * Whether segment files are unlinked as soon as they are created.
+     */
+    bool anonymous;
+  };
+
+  /**
+   * Opens segment <segment> of this file, creating its file if needed, and
+   * unlinks it right away if <anonymous>.
+   */
+  Segment openSegment(const std::size_t segment, const bool anonymous) const;
+
+  /**
+   * Returns the segments of this file, opening them up to <segment> if
+   * needed.  Must be called with maps_mutex_ held.
+   */
+  Segments &openSegments(const std::size_t segment) const;
+
   typedef std::map<std::string, std::shared_ptr<std::fstream>> StreamMap;
   typedef std::map<std::string, int> CountMap;
+  typedef std::map<std::string, Segments> SegmentMap;
 
   /**
    * Streams for opened files.
@@ -346,6 +561,16 @@ class File {
    */
   static CountMap open_counts_;
 
+  /**
+   * Segments of opened files.
+   */
+  static SegmentMap open_segments_;
+
+  /**
+   * Guards the maps above, which File objects of all threads share.
+   */
+  static std::mutex maps_mutex_;
+
   /**
    * Name of the file this object represents.
    */
@@ -356,6 +581,11 @@ class File {
    */
   std::shared_ptr<std::fstream> stream_;
 
+  /**
+   * Number of pages per segment, or 0 if the file is not segmented.
+   */
+  PageId segment_pages_;
+
   /**
    * Whether this file is valid.
    */
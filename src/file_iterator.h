@@ -99,6 +99,13 @@ class FileIterator {
     return file_->readPage(current_page_number_);
   }
 
+  /**
+   * Returns the number of the page the iterator is at without reading it.
+   *
+   * @return  Page number, or Page::INVALID_NUMBER at the end of the file.
+   */
+  PageId page_number() const { return current_page_number_; }
+
  private:
   /**
    * File we're iterating over.
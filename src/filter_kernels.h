@@ -0,0 +1,121 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "record_batch.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Comparison applied by a filter between a field and a constant.
+ */
+enum class CompareOp { EQ, NE, LT, LE, GT, GE };
+
+/**
+ * @brief Kernels for evaluating comparisons over columns of fixed-width
+ * values.
+ *
+ * The kernels work on plain arrays and write selection vectors (positions of
+ * matching values) without data-dependent branches, so compilers can
+ * vectorize the inner loops.  The comparison operator is dispatched once per
+ * call rather than once per value.
+ */
+namespace kernels {
+
+/**
+ * Copies the <T>-typed field at byte <offset> of every record in <batch> into
+ * <values>.  Records too short to hold the field get a zero value and a zero
+ * entry in <present>.
+ *
+ * @param batch   Records to read the field from.
+ * @param offset  Byte offset of the field within each record.
+ * @param values  Output array with room for batch.size() values.
+ * @param present Output array with room for batch.size() flags.
+ */
+template <typename T>
+void gatherField(const RecordBatch &batch, const std::size_t offset, T *values,
+                 std::uint8_t *present) {
+  const std::size_t n = batch.size();
+  for (std::size_t i = 0; i < n; ++i) {
+    const RecordView &view = batch[i];
+    const bool fits = offset + sizeof(T) <= view.length;
+    T value = 0;
+    if (fits) {
+      // Records are not aligned on the page, so copy instead of casting.
+      std::memcpy(&value, view.data + offset, sizeof(T));
+    }
+    values[i] = value;
+    present[i] = fits;
+  }
+}
+
+/**
+ * Writes the positions i for which pred(values[i]) && present[i] holds into
+ * <selection>.
+ *
+ * @return  Number of positions written.
+ */
+template <typename T, typename Pred>
+std::size_t selectWhere(const T *values, const std::uint8_t *present,
+                        const std::size_t n, Pred pred,
+                        std::uint32_t *selection) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    selection[count] = static_cast<std::uint32_t>(i);
+    count += static_cast<std::size_t>(pred(values[i]) & (present[i] != 0));
+  }
+  return count;
+}
+
+/**
+ * Writes the positions of the values comparing true against <constant> with
+ * <op> into <selection>.  Positions whose <present> flag is zero never match.
+ *
+ * @param values    Values to compare.
+ * @param present   Flags telling which values exist.
+ * @param n         Number of values.
+ * @param op        Comparison to apply.
+ * @param constant  Right-hand side of the comparison.
+ * @param selection Output array with room for <n> positions.
+ * @return  Number of matching positions.
+ */
+template <typename T>
+std::size_t selectCompare(const T *values, const std::uint8_t *present,
+                          const std::size_t n, const CompareOp op,
+                          const T constant, std::uint32_t *selection) {
+  switch (op) {
+    case CompareOp::EQ:
+      return selectWhere(values, present, n,
+                         [constant](T v) { return v == constant; }, selection);
+    case CompareOp::NE:
+      return selectWhere(values, present, n,
+                         [constant](T v) { return v != constant; }, selection);
+    case CompareOp::LT:
+      return selectWhere(values, present, n,
+                         [constant](T v) { return v < constant; }, selection);
+    case CompareOp::LE:
+      return selectWhere(values, present, n,
+                         [constant](T v) { return v <= constant; }, selection);
+    case CompareOp::GT:
+      return selectWhere(values, present, n,
+                         [constant](T v) { return v > constant; }, selection);
+    case CompareOp::GE:
+      return selectWhere(values, present, n,
+                         [constant](T v) { return v >= constant; }, selection);
+  }
+  return 0;
+}
+
+}  // namespace kernels
+
+}  // namespace badgerdb
@@ -0,0 +1,262 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "fixed_page.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "buffer.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_page_type_exception.h"
+#include "exceptions/invalid_record_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Rounds <offset> up to a multiple of 8 so column arrays are aligned for
+ * word-sized loads.
+ */
+std::size_t alignUp(const std::size_t offset) { return (offset + 7) & ~7; }
+
+/**
+ * Returns the offset of the first row in a page with the given metadata size
+ * and capacity.
+ */
+std::size_t dataOffset(const std::size_t bitmap_offset,
+                       const std::size_t capacity) {
+  return alignUp(bitmap_offset + (capacity + 7) / 8);
+}
+
+}  // namespace
+
+FixedSchema::FixedSchema(const std::vector<std::uint16_t> &column_widths,
+                         const std::vector<std::size_t> &swip_columns)
+    : widths_(column_widths), swips_(column_widths.size()), row_width_(0) {
+  for (const std::size_t column : swip_columns) {
+    assert(widths_[column] == sizeof(Swip));
+    swips_[column] = true;
+  }
+  std::size_t row_width = 0;
+  for (const std::uint16_t width : widths_) {
+    row_width += width;
+  }
+  if (row_width > Page::DATA_SIZE) {
+    throw InsufficientSpaceException(Page::INVALID_NUMBER, row_width,
+                                     Page::DATA_SIZE);
+  }
+  row_width_ = static_cast<std::uint16_t>(row_width);
+}
+
+FixedPage FixedPage::format(Page *page, const FixedSchema &schema,
+                            const PageType layout) {
+  if (layout == PageType::SLOTTED) {
+    throw InvalidPageTypeException(page->page_number(),
+                                   static_cast<std::uint16_t>(layout));
+  }
+  const std::size_t bitmap_offset =
+      sizeof(FixedPageHeader) + 2 * sizeof(std::uint16_t) * schema.num_columns();
+  const std::size_t row_width = schema.row_width();
+  std::size_t capacity = 0;
+  if (row_width > 0 && bitmap_offset < Page::DATA_SIZE) {
+    // Every row costs its width plus one bit; correct for bitmap rounding
+    // and alignment afterwards.
+    capacity = (Page::DATA_SIZE - bitmap_offset) * 8 / (row_width * 8 + 1);
+    while (capacity > 0 && dataOffset(bitmap_offset, capacity) +
+                                   capacity * row_width >
+                               Page::DATA_SIZE) {
+      --capacity;
+    }
+  }
+  if (capacity == 0) {
+    throw InsufficientSpaceException(page->page_number(), row_width,
+                                     Page::DATA_SIZE);
+  }
+
+  page->header_.free_space_lower_bound = 0;
+  page->header_.free_space_upper_bound = 0;
+  page->header_.num_slots = 0;
+  page->header_.num_free_slots = 0;
+  page->header_.page_type = static_cast<std::uint16_t>(layout);
+  page->data_.assign(Page::DATA_SIZE, char());
+
+  FixedPage fixed(page);
+  FixedPageHeader *header = fixed.header();
+  header->num_columns = schema.num_columns();
+  header->row_width = row_width;
+  header->capacity = capacity;
+  header->num_rows = 0;
+  header->high_water = 0;
+  header->bitmap_offset = bitmap_offset;
+
+  std::uint16_t *widths = const_cast<std::uint16_t *>(fixed.widths());
+  std::uint16_t *starts = widths + schema.num_columns();
+  std::size_t start = dataOffset(bitmap_offset, capacity);
+  for (std::size_t c = 0; c < schema.num_columns(); ++c) {
+    widths[c] = schema.column_width(c) | (schema.is_swip(c) ? SWIP_COLUMN : 0);
+    starts[c] = start;
+    // Row-major columns are interleaved; PAX columns get a minipage each.
+    start += layout == PageType::FIXED_PAX ? capacity * schema.column_width(c)
+                                           : schema.column_width(c);
+  }
+  return fixed;
+}
+
+FixedPage::FixedPage(Page *page) : page_(page) {
+  assert(page_ != NULL);
+  if (page_->page_type() != PageType::FIXED_ROW &&
+      page_->page_type() != PageType::FIXED_PAX) {
+    throw InvalidPageTypeException(page_->page_number(),
+                                   page_->header_.page_type);
+  }
+}
+
+RecordId FixedPage::insertRecord(const std::string &record_data) {
+  if (num_rows() >= capacity() || record_data.length() > row_width()) {
+    throw InsufficientSpaceException(
+        page_->page_number(), record_data.length(),
+        num_rows() >= capacity() ? 0 : row_width());
+  }
+  // Reuse the first free row so the used rows stay dense at the front.
+  SlotId slot_number = 1;
+  const std::uint8_t *used = bitmap();
+  while (used[(slot_number - 1) / 8] & (1 << ((slot_number - 1) % 8))) {
+    ++slot_number;
+  }
+  writeRow(slot_number, record_data);
+  setUsed(slot_number, true);
+  FixedPageHeader *layout = header();
+  ++layout->num_rows;
+  if (slot_number > layout->high_water) {
+    layout->high_water = slot_number;
+  }
+  return {page_->page_number(), slot_number};
+}
+
+Swip *FixedPage::swip(const SlotId slot_number, const std::size_t column) {
+  validateRecordId({page_->page_number(), slot_number});
+  assert(is_swip_column(column));
+  char *address = data() + (location(slot_number, column) - data());
+  assert(reinterpret_cast<std::uintptr_t>(address) % alignof(Swip) == 0);
+  return reinterpret_cast<Swip *>(address);
+}
+
+std::string FixedPage::getRecord(const RecordId &record_id) const {
+  validateRecordId(record_id);
+  std::string record;
+  if (page_->page_type() == PageType::FIXED_ROW) {
+    record.assign(location(record_id.slot_number, 0), row_width());
+  } else {
+    record.reserve(row_width());
+    for (std::size_t c = 0; c < num_columns(); ++c) {
+      record.append(location(record_id.slot_number, c), column_width(c));
+    }
+  }
+  std::size_t offset = 0;
+  for (std::size_t c = 0; c < num_columns(); ++c) {
+    restoreSwips(c, record_id.slot_number, 1, &record[offset]);
+    offset += column_width(c);
+  }
+  return record;
+}
+
+void FixedPage::updateRecord(const RecordId &record_id,
+                             const std::string &record_data) {
+  validateRecordId(record_id);
+  if (record_data.length() > row_width()) {
+    throw InsufficientSpaceException(page_->page_number(),
+                                     record_data.length(), row_width());
+  }
+  forgetSwips(record_id.slot_number);
+  writeRow(record_id.slot_number, record_data);
+}
+
+void FixedPage::deleteRecord(const RecordId &record_id) {
+  validateRecordId(record_id);
+  forgetSwips(record_id.slot_number);
+  setUsed(record_id.slot_number, false);
+  FixedPageHeader *layout = header();
+  --layout->num_rows;
+  while (layout->high_water > 0 && !isUsed(layout->high_water)) {
+    --layout->high_water;
+  }
+}
+
+bool FixedPage::isUsed(const SlotId slot_number) const {
+  if (slot_number == Page::INVALID_SLOT || slot_number > capacity()) {
+    return false;
+  }
+  return (bitmap()[(slot_number - 1) / 8] >> ((slot_number - 1) % 8)) & 1;
+}
+
+void FixedPage::restoreSwips(const std::size_t column, const SlotId first_slot,
+                             const std::size_t rows, char *values) const {
+  if (!is_swip_column(column) || page_->pool_ == NULL) {
+    return;
+  }
+  for (std::size_t i = 0; i < rows; ++i) {
+    char *value = values + i * sizeof(Swip);
+    std::uint32_t word;
+    std::memcpy(&word, value, sizeof(word));
+    if ((word & Swip::SWIZZLED_BIT) != 0) {
+      const PageId page_number =
+          page_->pool_->swizzledPageNumber(word & ~Swip::SWIZZLED_BIT);
+      std::memcpy(value, &page_number, sizeof(page_number));
+    }
+  }
+}
+
+void FixedPage::forgetSwips(const SlotId slot_number) {
+  if (page_->pool_ == NULL) {
+    return;
+  }
+  for (std::size_t c = 0; c < num_columns(); ++c) {
+    if (is_swip_column(c)) {
+      Swip *value = reinterpret_cast<Swip *>(
+          data() + (location(slot_number, c) - data()));
+      if (value->isSwizzled()) {
+        page_->pool_->forgetSwip(page_, value);
+      }
+    }
+  }
+}
+
+void FixedPage::validateRecordId(const RecordId &record_id) const {
+  if (record_id.page_number != page_->page_number() ||
+      !isUsed(record_id.slot_number)) {
+    throw InvalidRecordException(record_id, page_->page_number());
+  }
+}
+
+void FixedPage::writeRow(const SlotId slot_number,
+                         const std::string &record_data) {
+  std::size_t row_offset = 0;
+  for (std::size_t c = 0; c < num_columns(); ++c) {
+    char *dest = const_cast<char *>(location(slot_number, c));
+    const std::size_t width = column_width(c);
+    std::size_t copied = 0;
+    if (row_offset < record_data.length()) {
+      copied = std::min(width, record_data.length() - row_offset);
+      std::memcpy(dest, record_data.data() + row_offset, copied);
+    }
+    std::memset(dest + copied, 0, width - copied);
+    row_offset += width;
+  }
+}
+
+void FixedPage::setUsed(const SlotId slot_number, const bool used) {
+  std::uint8_t *byte = reinterpret_cast<std::uint8_t *>(
+      data() + header()->bitmap_offset + (slot_number - 1) / 8);
+  const std::uint8_t mask = 1 << ((slot_number - 1) % 8);
+  *byte = used ? (*byte | mask) : (*byte & ~mask);
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,418 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "filter_kernels.h"
+#include "page.h"
+#include "swip.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Column widths of the fixed-width records stored on a FixedPage.
+ */
+class FixedSchema {
+ public:
+  /**
+   * Constructs a schema with the given column widths in bytes.
+   *
+   * @param column_widths Width of every column, in row order.
+   * @param swip_columns  Columns holding swips, which the buffer manager may
+   *                      swizzle; each must be sizeof(Swip) bytes wide.
+   * @throws  InsufficientSpaceException  If a row is wider than a page.
+   */
+  explicit FixedSchema(
+      const std::vector<std::uint16_t> &column_widths,
+      const std::vector<std::size_t> &swip_columns = std::vector<std::size_t>());
+
+  /**
+   * Returns the number of columns.
+   */
+  std::size_t num_columns() const { return widths_.size(); }
+
+  /**
+   * Returns the width of the given column in bytes.
+   */
+  std::uint16_t column_width(const std::size_t column) const {
+    return widths_[column];
+  }
+
+  /**
+   * Returns true if the given column holds swips.
+   */
+  bool is_swip(const std::size_t column) const { return swips_[column]; }
+
+  /**
+   * Returns the width of a whole row in bytes.
+   */
+  std::uint16_t row_width() const { return row_width_; }
+
+ private:
+  /**
+   * Width of every column.
+   */
+  std::vector<std::uint16_t> widths_;
+
+  /**
+   * Whether each column holds swips.
+   */
+  std::vector<bool> swips_;
+
+  /**
+   * Sum of the column widths.
+   */
+  std::uint16_t row_width_;
+};
+
+/**
+ * @brief Layout metadata stored at the start of the data area of a fixed-width
+ * page.
+ *
+ * It is followed by the width and the start offset of every column (two arrays
+ * of <num_columns> 16-bit values), the used-row bitmap and the row data.  The
+ * widths of swip columns are stored with FixedPage::SWIP_COLUMN set.
+ */
+struct FixedPageHeader {
+  /**
+   * Number of columns in each row.
+   */
+  std::uint16_t num_columns;
+
+  /**
+   * Width of a whole row in bytes.
+   */
+  std::uint16_t row_width;
+
+  /**
+   * Maximum number of rows on the page.
+   */
+  std::uint16_t capacity;
+
+  /**
+   * Number of rows currently in use.
+   */
+  std::uint16_t num_rows;
+
+  /**
+   * Highest slot in use, or 0 if the page holds no rows; scans stop after
+   * it.  Lowered when the highest rows are deleted.
+   */
+  std::uint16_t high_water;
+
+  /**
+   * Offset of the used-row bitmap in the data area.
+   */
+  std::uint16_t bitmap_offset;
+};
+
+/**
+ * @brief Accessor for pages holding fixed-width records.
+ *
+ * A fixed-width page has no slot directory: slot <n> of a page is simply the
+ * n-th row, and a bitmap tracks which rows are in use.  Rows are stored either
+ * one after another (PageType::FIXED_ROW) or split into PAX minipages, one
+ * contiguous array per column (PageType::FIXED_PAX), so that a scan of a
+ * single column only touches that column's bytes.
+ *
+ * A FixedPage does not own the page it wraps; it reads all layout
+ * information from the page itself, so it is cheap to construct for every
+ * page visited.
+ *
+ * @warning This class is not threadsafe.
+ */
+class FixedPage {
+ public:
+  /**
+   * Marks the stored width of a column holding swips.
+   */
+  static const std::uint16_t SWIP_COLUMN = 0x8000;
+
+  /**
+   * Erases <page> and formats it to hold rows of the given schema.
+   *
+   * @param page    Page to format; keeps its page number.
+   * @param schema  Column widths of the rows.
+   * @param layout  PageType::FIXED_ROW or PageType::FIXED_PAX.
+   * @return  Accessor for the formatted page.
+   * @throws  InvalidPageTypeException  If <layout> is not a fixed-width type.
+   * @throws  InsufficientSpaceException  If not even one row fits on a page.
+   */
+  static FixedPage format(Page *page, const FixedSchema &schema,
+                          const PageType layout);
+
+  /**
+   * Wraps a page previously formatted with format().
+   *
+   * @param page  Page to wrap.
+   * @throws  InvalidPageTypeException  If the page is not a fixed-width page.
+   */
+  explicit FixedPage(Page *page);
+
+  /**
+   * Inserts a row.  Rows shorter than the row width are padded with zeros.
+   *
+   * @param record_data Bytes of the row.
+   * @return  ID of the new row.
+   * @throws  InsufficientSpaceException  If the page is full or the row is
+   *                                      wider than the schema.
+   */
+  RecordId insertRecord(const std::string &record_data);
+
+  /**
+   * Returns a copy of the row with the given ID.
+   *
+   * @param record_id ID of the row.
+   * @throws  InvalidRecordException  If the ID does not refer to a used row.
+   */
+  std::string getRecord(const RecordId &record_id) const;
+
+  /**
+   * Replaces the row with the given ID.
+   *
+   * @param record_id   ID of the row.
+   * @param record_data New bytes of the row.
+   * @throws  InvalidRecordException  If the ID does not refer to a used row.
+   * @throws  InsufficientSpaceException  If the row is wider than the schema.
+   */
+  void updateRecord(const RecordId &record_id, const std::string &record_data);
+
+  /**
+   * Deletes the row with the given ID.  Other rows keep their IDs.
+   *
+   * @param record_id ID of the row.
+   * @throws  InvalidRecordException  If the ID does not refer to a used row.
+   */
+  void deleteRecord(const RecordId &record_id);
+
+  /**
+   * Returns true if the given slot holds a row.
+   */
+  bool isUsed(const SlotId slot_number) const;
+
+  /**
+   * Returns the value of <column> in the row at <slot_number>, which must be
+   * sizeof(T) bytes wide.  The slot must be below end_slot().  A swizzled
+   * swip is returned as the page number it refers to.
+   */
+  template <typename T>
+  T value(const SlotId slot_number, const std::size_t column) const;
+
+  /**
+   * Returns the swip stored as the value of <column> in the row at
+   * <slot_number>, for use with BufMgr::fixSwip().  The column must be
+   * declared as a swip column of the schema and the value 4-byte aligned,
+   * which holds for PAX pages whose preceding columns have widths divisible
+   * by four.
+   *
+   * @throws  InvalidRecordException  If the slot does not hold a row.
+   */
+  Swip *swip(const SlotId slot_number, const std::size_t column);
+
+  /**
+   * Returns a pointer to the value of <column> in the first row.  Values of
+   * following rows are column_stride() bytes apart; on PAX pages the stride
+   * equals the column width, so the values form a dense array.  These are
+   * the bytes as stored: swips swizzled by the buffer manager hold frame
+   * references, which getRecord(), value() and selectColumn() restore.
+   */
+  const char *column_base(const std::size_t column) const {
+    return data() + starts()[column];
+  }
+
+  /**
+   * Returns the distance in bytes between values of <column> in consecutive
+   * rows.
+   */
+  std::uint16_t column_stride(const std::size_t column) const {
+    return page_->page_type() == PageType::FIXED_PAX ? column_width(column)
+                                                     : header()->row_width;
+  }
+
+  /**
+   * Returns the width of <column> in bytes.
+   */
+  std::uint16_t column_width(const std::size_t column) const {
+    return widths()[column] & ~SWIP_COLUMN;
+  }
+
+  /**
+   * Returns true if <column> holds swips.
+   */
+  bool is_swip_column(const std::size_t column) const {
+    return (widths()[column] & SWIP_COLUMN) != 0;
+  }
+
+  /**
+   * Collects the slots of the used rows whose <T>-typed value in <column>
+   * compares true against <constant>.  Only the bytes of that column and the
+   * used-row bitmap are read.
+   *
+   * @param column    Column to compare; must be sizeof(T) bytes wide.
+   *                  Swizzled swips compare as their page numbers.
+   * @param op        Comparison to apply (value op constant).
+   * @param constant  Right-hand side of the comparison.
+   * @param slots     Receives the matching slots, in slot order.
+   * @return  Number of matching rows.
+   */
+  template <typename T>
+  std::size_t selectColumn(const std::size_t column, const CompareOp op,
+                           const T constant,
+                           std::vector<SlotId> &slots) const;
+
+  /**
+   * Returns the number of columns.
+   */
+  std::size_t num_columns() const { return header()->num_columns; }
+
+  /**
+   * Returns the width of a row in bytes.
+   */
+  std::uint16_t row_width() const { return header()->row_width; }
+
+  /**
+   * Returns the maximum number of rows on the page.
+   */
+  std::uint16_t capacity() const { return header()->capacity; }
+
+  /**
+   * Returns the number of rows in use.
+   */
+  std::uint16_t num_rows() const { return header()->num_rows; }
+
+  /**
+   * Returns the slot after the highest slot that may be in use.
+   */
+  SlotId end_slot() const { return header()->high_water + 1; }
+
+  /**
+   * Returns the page being accessed.
+   */
+  Page *page() const { return page_; }
+
+ private:
+  /**
+   * Returns a pointer to the value of <column> in the row at <slot_number>.
+   */
+  const char *location(const SlotId slot_number,
+                       const std::size_t column) const {
+    return column_base(column) +
+           (slot_number - 1) * static_cast<std::size_t>(column_stride(column));
+  }
+
+  /**
+   * Overwrites the copies of swizzled swips among the values of <column> in
+   * <rows> rows from <first_slot> on, copied densely to <values>, with the
+   * page numbers the swips refer to.  Only swip columns of pages held in a
+   * buffer pool can hold swizzled swips; they are recognized by their value
+   * alone, so no lock is taken.
+   */
+  void restoreSwips(const std::size_t column, const SlotId first_slot,
+                    const std::size_t rows, char *values) const;
+
+  /**
+   * Unswizzles the swips in the row at <slot_number> before the row is
+   * overwritten or deleted.
+   */
+  void forgetSwips(const SlotId slot_number);
+
+  /**
+   * Throws if <record_id> does not refer to a used row of this page.
+   */
+  void validateRecordId(const RecordId &record_id) const;
+
+  /**
+   * Copies <record_data> into the row at <slot_number>, zero-padding it.
+   */
+  void writeRow(const SlotId slot_number, const std::string &record_data);
+
+  /**
+   * Sets or clears the used bit of <slot_number>.
+   */
+  void setUsed(const SlotId slot_number, const bool used);
+
+  const char *data() const { return page_->data_.data(); }
+  char *data() { return &page_->data_[0]; }
+
+  const FixedPageHeader *header() const {
+    return reinterpret_cast<const FixedPageHeader *>(data());
+  }
+  FixedPageHeader *header() {
+    return reinterpret_cast<FixedPageHeader *>(data());
+  }
+
+  const std::uint16_t *widths() const {
+    return reinterpret_cast<const std::uint16_t *>(data() +
+                                                   sizeof(FixedPageHeader));
+  }
+
+  const std::uint16_t *starts() const {
+    return widths() + header()->num_columns;
+  }
+
+  const std::uint8_t *bitmap() const {
+    return reinterpret_cast<const std::uint8_t *>(data() +
+                                                  header()->bitmap_offset);
+  }
+
+  /**
+   * Page being accessed.
+   */
+  Page *page_;
+};
+
+template <typename T>
+T FixedPage::value(const SlotId slot_number, const std::size_t column) const {
+  assert(column_width(column) == sizeof(T));
+  T result;
+  std::memcpy(&result, location(slot_number, column), sizeof(T));
+  restoreSwips(column, slot_number, 1, reinterpret_cast<char *>(&result));
+  return result;
+}
+
+template <typename T>
+std::size_t FixedPage::selectColumn(const std::size_t column,
+                                    const CompareOp op, const T constant,
+                                    std::vector<SlotId> &slots) const {
+  assert(column_width(column) == sizeof(T));
+  const std::size_t n = header()->high_water;
+  const std::size_t stride = column_stride(column);
+  const char *base = column_base(column);
+  std::vector<T> values(n);
+  std::vector<std::uint8_t> present(n);
+  std::vector<std::uint32_t> selection(n);
+  if (stride == sizeof(T)) {
+    // PAX minipage: the values already form a dense array.
+    std::memcpy(values.data(), base, n * sizeof(T));
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      std::memcpy(&values[i], base + i * stride, sizeof(T));
+    }
+  }
+  restoreSwips(column, 1, n, reinterpret_cast<char *>(values.data()));
+  const std::uint8_t *used = bitmap();
+  for (std::size_t i = 0; i < n; ++i) {
+    present[i] = (used[i / 8] >> (i % 8)) & 1;
+  }
+  const std::size_t count = kernels::selectCompare(
+      values.data(), present.data(), n, op, constant, selection.data());
+  for (std::size_t i = 0; i < count; ++i) {
+    slots.push_back(static_cast<SlotId>(selection[i] + 1));
+  }
+  return count;
+}
+
+}  // namespace badgerdb
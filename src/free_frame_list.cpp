@@ -0,0 +1,73 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "free_frame_list.h"
+
+#include <cassert>
+
+namespace badgerdb {
+
+namespace {
+
+std::uint64_t packHead(const std::uint64_t tag, const FrameId frame) {
+  return (tag << 32) | frame;
+}
+
+FrameId headFrame(const std::uint64_t head) {
+  return static_cast<FrameId>(head);
+}
+
+std::uint64_t headTag(const std::uint64_t head) { return head >> 32; }
+
+}  // namespace
+
+FreeFrameList::FreeFrameList(const std::uint32_t num_frames)
+    : next_(new std::atomic<FrameId>[num_frames]),
+      head_(packHead(0, NO_FRAME)),
+      size_(0) {
+  for (std::uint32_t i = 0; i < num_frames; ++i) {
+    next_[i].store(NO_FRAME, std::memory_order_relaxed);
+  }
+}
+
+void FreeFrameList::push(const FrameId frame) {
+  assert(frame != NO_FRAME);
+  // Counted before the frame becomes visible so that a racing pop never
+  // drives the count below zero.
+  size_.fetch_add(1, std::memory_order_relaxed);
+  std::uint64_t head = head_.load(std::memory_order_relaxed);
+  std::uint64_t new_head;
+  do {
+    next_[frame].store(headFrame(head), std::memory_order_relaxed);
+    new_head = packHead(headTag(head) + 1, frame);
+  } while (!head_.compare_exchange_weak(head, new_head,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed));
+}
+
+bool FreeFrameList::pop(FrameId &frame) {
+  std::uint64_t head = head_.load(std::memory_order_acquire);
+  std::uint64_t new_head;
+  do {
+    if (headFrame(head) == NO_FRAME) {
+      return false;
+    }
+    // May read the link of a frame another thread already popped; the tag
+    // makes the exchange below fail in that case.
+    const FrameId next =
+        next_[headFrame(head)].load(std::memory_order_relaxed);
+    new_head = packHead(headTag(head) + 1, next);
+  } while (!head_.compare_exchange_weak(head, new_head,
+                                        std::memory_order_acquire,
+                                        std::memory_order_acquire));
+  frame = headFrame(head);
+  size_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+}  // namespace badgerdb
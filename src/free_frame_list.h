@@ -0,0 +1,83 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Lock-free stack of buffer frames that hold no page.
+ *
+ * The stack is intrusive: every frame has a slot holding the frame below it,
+ * so pushing and popping never allocate.  The head packs the top frame with a
+ * counter that changes on every update, so a pop that raced with a pop and
+ * re-push of the same frame fails its compare-and-swap instead of linking in
+ * a stale successor.
+ *
+ * Each frame may be on the stack at most once; callers push a frame only
+ * when it stops holding a page.  All operations are threadsafe.
+ */
+class FreeFrameList {
+ public:
+  /**
+   * Constructs an empty list for frames 0 to <num_frames> - 1.
+   */
+  explicit FreeFrameList(const std::uint32_t num_frames);
+
+  /**
+   * Pushes <frame> on the stack.
+   */
+  void push(const FrameId frame);
+
+  /**
+   * Pops the most recently pushed frame into <frame>.
+   *
+   * @return  False if the stack was empty.
+   */
+  bool pop(FrameId &frame);
+
+  /**
+   * Returns the number of frames on the stack.  Only a snapshot if other
+   * threads are updating it.
+   */
+  std::uint32_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  /**
+   * Returns true if the stack holds no frame.
+   */
+  bool empty() const { return size() == 0; }
+
+ private:
+  /**
+   * Marks the bottom of the stack.
+   */
+  static const FrameId NO_FRAME = UINT32_MAX;
+
+  /**
+   * Frame below each frame on the stack.
+   */
+  std::unique_ptr<std::atomic<FrameId>[]> next_;
+
+  /**
+   * Update counter in the high half, top frame in the low half.
+   */
+  std::atomic<std::uint64_t> head_;
+
+  /**
+   * Number of frames on the stack.
+   */
+  std::atomic<std::uint32_t> size_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,489 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "hash_aggregate.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <future>
+#include <memory>
+
+#include "batch_scanner.h"
+#include "hashing.h"
+#include "record_writer.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Spill depth after which groups are kept in memory regardless of the
+ * budget, so that recursion always terminates.
+ */
+const std::size_t MAX_PARTITION_DEPTH = 4;
+
+/**
+ * Records per input batch and thread in parallel mode.
+ */
+const std::size_t RECORDS_PER_THREAD = 4096;
+
+/**
+ * Returns the width in bytes of a field of the given type.
+ */
+std::size_t fieldWidth(const FieldType type) {
+  return type == FieldType::INT32 || type == FieldType::UINT32 ? 4 : 8;
+}
+
+/**
+ * Reads a field and widens it to 64 bits.  UINT64 values keep their bit
+ * pattern.
+ */
+std::int64_t readField(const char *data, const FieldType type) {
+  switch (type) {
+    case FieldType::INT32: {
+      std::int32_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    case FieldType::UINT32: {
+      std::uint32_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    default: {
+      std::int64_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+    }
+  }
+}
+
+/**
+ * Returns true if <a> orders before <b> as values of <type>.
+ */
+bool lessThan(const std::int64_t a, const std::int64_t b,
+              const FieldType type) {
+  if (type == FieldType::UINT64) {
+    return static_cast<std::uint64_t>(a) < static_cast<std::uint64_t>(b);
+  }
+  return a < b;
+}
+
+/**
+ * Returns the starting value of an aggregate.
+ */
+std::int64_t identity(const Aggregate &aggregate) {
+  const bool is_unsigned = aggregate.type == FieldType::UINT64;
+  switch (aggregate.function) {
+    case AggregateFunction::MIN:
+      return is_unsigned ? -1 /* all bits set */
+                         : std::numeric_limits<std::int64_t>::max();
+    case AggregateFunction::MAX:
+      return is_unsigned ? 0 : std::numeric_limits<std::int64_t>::min();
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Folds the partial aggregate <partial> into <acc>.  A raw value is the
+ * partial aggregate of a single record, except for COUNT whose partial is 1.
+ */
+void combine(std::int64_t &acc, const Aggregate &aggregate,
+             const std::int64_t partial) {
+  switch (aggregate.function) {
+    case AggregateFunction::COUNT:
+    case AggregateFunction::SUM:
+      acc = static_cast<std::int64_t>(static_cast<std::uint64_t>(acc) +
+                                      static_cast<std::uint64_t>(partial));
+      break;
+    case AggregateFunction::MIN:
+      if (lessThan(partial, acc, aggregate.type)) {
+        acc = partial;
+      }
+      break;
+    case AggregateFunction::MAX:
+      if (lessThan(acc, partial, aggregate.type)) {
+        acc = partial;
+      }
+      break;
+  }
+}
+
+/**
+ * @brief Open-addressing table from group keys to aggregate values.
+ *
+ * Each group occupies a fixed number of 64-bit words in one arena: its
+ * aggregate values followed by its key bytes.
+ */
+class GroupTable {
+ public:
+  GroupTable(const std::size_t key_width,
+             const std::vector<Aggregate> &aggregates,
+             const std::uint64_t seed)
+      : key_width_(key_width),
+        aggregates_(aggregates),
+        seed_(seed),
+        words_per_group_(aggregates.size() + (key_width + 7) / 8),
+        mask_(0),
+        num_groups_(0) {}
+
+  std::uint64_t hash(const char *key) const {
+    return hashBytes(key, key_width_, seed_);
+  }
+
+  /**
+   * Returns the values of the group with the given key, or NULL.
+   */
+  std::int64_t *find(const std::uint64_t hash, const char *key) {
+    if (slots_.empty()) {
+      return NULL;
+    }
+    for (std::size_t i = hash & mask_; slots_[i].group != 0;
+         i = (i + 1) & mask_) {
+      if (slots_[i].hash == hash) {
+        std::int64_t *values = group(slots_[i].group - 1);
+        if (std::memcmp(values + aggregates_.size(), key, key_width_) == 0) {
+          return values;
+        }
+      }
+    }
+    return NULL;
+  }
+
+  /**
+   * Adds a group that is not in the table and returns its values, set to the
+   * identity of each aggregate.
+   */
+  std::int64_t *insert(const std::uint64_t hash, const char *key) {
+    if ((num_groups_ + 1) * 2 > slots_.size()) {
+      grow();
+    }
+    const std::uint32_t index = num_groups_++;
+    arena_.resize(arena_.size() + words_per_group_, 0);
+    std::int64_t *values = group(index);
+    for (std::size_t a = 0; a < aggregates_.size(); ++a) {
+      values[a] = identity(aggregates_[a]);
+    }
+    std::memcpy(values + aggregates_.size(), key, key_width_);
+    place(hash, index);
+    return values;
+  }
+
+  /**
+   * Calls f(key, values) for every group.
+   */
+  template <typename F>
+  void forEach(F f) const {
+    for (std::size_t i = 0; i < num_groups_; ++i) {
+      const std::int64_t *values = arena_.data() + i * words_per_group_;
+      f(reinterpret_cast<const char *>(values + aggregates_.size()), values);
+    }
+  }
+
+  std::size_t memoryUsed() const {
+    return arena_.size() * sizeof(std::int64_t) + slots_.size() * sizeof(Slot);
+  }
+
+  /**
+   * Drops all groups but keeps their memory for reuse.
+   */
+  void clear() {
+    std::fill(slots_.begin(), slots_.end(), Slot{0, 0});
+    arena_.clear();
+    num_groups_ = 0;
+  }
+
+  /**
+   * Drops all groups and frees their memory.
+   */
+  void release() {
+    std::vector<Slot>().swap(slots_);
+    std::vector<std::int64_t>().swap(arena_);
+    mask_ = 0;
+    num_groups_ = 0;
+  }
+
+ private:
+  struct Slot {
+    std::uint64_t hash;
+    std::uint32_t group;
+  };
+
+  std::int64_t *group(const std::size_t index) {
+    return arena_.data() + index * words_per_group_;
+  }
+
+  void grow() {
+    const std::size_t new_size = slots_.empty() ? 1024 : slots_.size() * 2;
+    slots_.assign(new_size, Slot{0, 0});
+    mask_ = new_size - 1;
+    for (std::uint32_t i = 0; i < num_groups_; ++i) {
+      const std::int64_t *values = group(i);
+      place(hash(reinterpret_cast<const char *>(values + aggregates_.size())),
+            i);
+    }
+  }
+
+  void place(const std::uint64_t hash, const std::uint32_t index) {
+    std::size_t i = hash & mask_;
+    while (slots_[i].group != 0) {
+      i = (i + 1) & mask_;
+    }
+    slots_[i] = {hash, index + 1};
+  }
+
+  std::size_t key_width_;
+  const std::vector<Aggregate> &aggregates_;
+  std::uint64_t seed_;
+  std::size_t words_per_group_;
+  std::vector<Slot> slots_;
+  std::size_t mask_;
+  std::size_t num_groups_;
+  std::vector<std::int64_t> arena_;
+};
+
+/**
+ * @brief Partitioned spill files of partial aggregates, created on first use.
+ */
+class SpillPartitions {
+ public:
+  SpillPartitions(BufMgr *bufMgr, const std::size_t key_width,
+                  const std::size_t num_aggregates)
+      : bufMgr_(bufMgr),
+        key_width_(key_width),
+        num_aggregates_(num_aggregates) {}
+
+  bool empty() const { return files_.empty(); }
+
+  /**
+   * Creates the partition files.
+   */
+  void open(TempFileManager *temp_files, const std::size_t num_partitions) {
+    files_.reserve(num_partitions);
+    for (std::size_t i = 0; i < num_partitions; ++i) {
+      files_.push_back(temp_files->create());
+    }
+    for (File &file : files_) {
+      writers_.emplace_back(new RecordWriter(bufMgr_, &file));
+    }
+  }
+
+  /**
+   * Writes the partial aggregate of one group to the partition for <hash>.
+   */
+  void write(const std::uint64_t hash, const char *key,
+             const std::int64_t *values) {
+    record_.assign(key, key_width_);
+    record_.append(reinterpret_cast<const char *>(values),
+                   num_aggregates_ * sizeof(std::int64_t));
+    // Use the high bits; the table at this level uses the low ones.
+    writers_[(hash >> 32) % writers_.size()]->append(record_);
+  }
+
+  /**
+   * Finishes writing and returns the partition files.
+   */
+  std::vector<File> close() {
+    writers_.clear();
+    std::vector<File> files;
+    files.swap(files_);
+    return files;
+  }
+
+ private:
+  BufMgr *bufMgr_;
+  std::size_t key_width_;
+  std::size_t num_aggregates_;
+  std::vector<File> files_;
+  std::vector<std::unique_ptr<RecordWriter>> writers_;
+  std::string record_;
+};
+
+}  // namespace
+
+HashAggregate::HashAggregate(BufMgr *bufMgr, TempFileManager *temp_files,
+                             const GroupKey &group_key,
+                             const std::vector<Aggregate> &aggregates,
+                             const std::size_t memory_budget,
+                             const std::size_t num_partitions)
+    : bufMgr_(bufMgr),
+      temp_files_(temp_files),
+      group_key_(group_key),
+      aggregates_(aggregates),
+      memory_budget_(memory_budget),
+      num_partitions_(num_partitions),
+      num_threads_(1),
+      num_partition_files_(0) {
+  assert(bufMgr_ != NULL && temp_files_ != NULL);
+  assert(num_partitions_ > 1);
+}
+
+void HashAggregate::setThreads(const std::size_t num_threads) {
+  num_threads_ = std::max<std::size_t>(1, num_threads);
+  // The calling thread takes a share of every batch itself.
+  workers_.reset(num_threads_ > 1 ? new Executor(num_threads_ - 1) : NULL);
+}
+
+void HashAggregate::aggregate(File &input, const Emit &emit) {
+  num_partition_files_ = 0;
+  aggregateFile(input, 0 /* level */, emit);
+}
+
+void HashAggregate::aggregateFile(File &input, const std::size_t level,
+                                  const Emit &emit) {
+  const bool raw = level == 0;
+  const std::size_t num_aggregates = aggregates_.size();
+  const std::size_t key_width = group_key_.width;
+  // Minimum record length; raw records must hold the key and every field.
+  std::size_t min_length = key_width + num_aggregates * sizeof(std::int64_t);
+  if (raw) {
+    min_length = group_key_.offset + key_width;
+    for (const Aggregate &aggregate : aggregates_) {
+      if (aggregate.function != AggregateFunction::COUNT) {
+        min_length = std::max(min_length, aggregate.offset +
+                                              fieldWidth(aggregate.type));
+      }
+    }
+  }
+  const std::size_t key_offset = raw ? group_key_.offset : 0;
+
+  GroupTable table(key_width, aggregates_, level);
+  SpillPartitions spills(bufMgr_, key_width, num_aggregates);
+  const bool bounded = level < MAX_PARTITION_DEPTH;
+  std::vector<std::int64_t> partial(num_aggregates);
+
+  // Folds the partial aggregate of one group into the table, or spills it if
+  // the group is new and the table is over budget.
+  auto mergePartial = [&](const std::uint64_t hash, const char *key,
+                          const std::int64_t *values) {
+    std::int64_t *acc = table.find(hash, key);
+    if (acc == NULL) {
+      if (bounded && table.memoryUsed() >= memory_budget_) {
+        if (spills.empty()) {
+          spills.open(temp_files_, num_partitions_);
+          num_partition_files_ += num_partitions_;
+        }
+        spills.write(hash, key, values);
+        return;
+      }
+      acc = table.insert(hash, key);
+    }
+    for (std::size_t a = 0; a < num_aggregates; ++a) {
+      combine(acc[a], aggregates_[a], values[a]);
+    }
+  };
+
+  // Computes the partial aggregate a single record contributes.
+  auto recordPartial = [&](const RecordView &view, std::int64_t *values) {
+    if (raw) {
+      for (std::size_t a = 0; a < num_aggregates; ++a) {
+        const Aggregate &aggregate = aggregates_[a];
+        values[a] = aggregate.function == AggregateFunction::COUNT
+                        ? 1
+                        : readField(view.data + aggregate.offset,
+                                    aggregate.type);
+      }
+    } else {
+      std::memcpy(values, view.data + key_width,
+                  num_aggregates * sizeof(std::int64_t));
+    }
+  };
+
+  {
+    const std::size_t threads = raw ? num_threads_ : 1;
+    // Once the table spills, every partition pins the page it is writing
+    // next to the pages backing the current batch.
+    const std::size_t frames = bufMgr_->numFrames();
+    BatchScanner scanner(
+        bufMgr_, &input,
+        frames > num_partitions_ + 1 ? frames - num_partitions_ : 1);
+    RecordBatch batch(threads > 1 ? RECORDS_PER_THREAD * threads
+                                  : RecordBatch::DEFAULT_CAPACITY);
+    // Thread-local tables, cleared after every batch.
+    std::vector<std::unique_ptr<GroupTable>> locals;
+    for (std::size_t t = 0; threads > 1 && t < threads; ++t) {
+      locals.emplace_back(new GroupTable(key_width, aggregates_, level));
+    }
+    while (scanner.next(batch)) {
+      if (threads == 1) {
+        for (const RecordView &view : batch) {
+          if (view.length < min_length) {
+            continue;
+          }
+          const char *key = view.data + key_offset;
+          recordPartial(view, partial.data());
+          mergePartial(table.hash(key), key, partial.data());
+        }
+        continue;
+      }
+
+      // Pre-aggregate slices of the batch in thread-local tables, one on
+      // the calling thread and the others on the workers.  The pages stay
+      // pinned until the next batch, so workers can read the views.
+      const std::size_t slice = (batch.size() + threads - 1) / threads;
+      auto preAggregate = [&](const std::size_t t) {
+        const std::size_t begin = std::min(batch.size(), t * slice);
+        const std::size_t end = std::min(batch.size(), begin + slice);
+        GroupTable *local = locals[t].get();
+        std::vector<std::int64_t> values(num_aggregates);
+        for (std::size_t i = begin; i < end; ++i) {
+          const RecordView &view = batch[i];
+          if (view.length < min_length) {
+            continue;
+          }
+          const char *key = view.data + key_offset;
+          const std::uint64_t hash = local->hash(key);
+          std::int64_t *acc = local->find(hash, key);
+          if (acc == NULL) {
+            acc = local->insert(hash, key);
+          }
+          recordPartial(view, values.data());
+          for (std::size_t a = 0; a < num_aggregates; ++a) {
+            combine(acc[a], aggregates_[a], values[a]);
+          }
+        }
+      };
+      std::vector<std::future<void>> pending;
+      for (std::size_t t = 1; t < threads; ++t) {
+        std::shared_ptr<std::packaged_task<void()>> task(
+            new std::packaged_task<void()>([&preAggregate, t]() {
+              preAggregate(t);
+            }));
+        pending.push_back(task->get_future());
+        workers_->post([task]() { (*task)(); });
+      }
+      preAggregate(0);
+      for (std::future<void> &done : pending) {
+        done.get();
+      }
+      for (const std::unique_ptr<GroupTable> &local : locals) {
+        local->forEach([&](const char *key, const std::int64_t *values) {
+          mergePartial(table.hash(key), key, values);
+        });
+        local->clear();
+      }
+    }
+  }
+
+  std::vector<File> partitions;
+  if (!spills.empty()) {
+    partitions = spills.close();
+  }
+  table.forEach(emit);
+  table.release();
+
+  for (File &partition : partitions) {
+    aggregateFile(partition, level + 1, emit);
+    temp_files_->drop(partition);
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,179 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "executor.h"
+#include "file.h"
+#include "hash_join.h"
+#include "predicate.h"
+#include "temp_file_manager.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Aggregate functions supported by HashAggregate.
+ */
+enum class AggregateFunction { COUNT, SUM, MIN, MAX };
+
+/**
+ * @brief One aggregate computed per group.
+ */
+struct Aggregate {
+  /**
+   * Function to compute.
+   */
+  AggregateFunction function;
+
+  /**
+   * Type of the aggregated field; ignored for COUNT.
+   */
+  FieldType type;
+
+  /**
+   * Byte offset of the aggregated field; ignored for COUNT.
+   */
+  std::size_t offset;
+};
+
+/**
+ * @brief Location of the group-by key inside a record.
+ */
+typedef JoinKey GroupKey;
+
+/**
+ * @brief Group-by aggregation over a record file.
+ *
+ * Groups are kept in an open-addressing hash table.  While the table is within
+ * the memory budget, every new group is added to it.  Once the budget is
+ * exceeded, records of groups already in the table are still aggregated in
+ * memory, but records of new groups are converted to partial aggregates and
+ * spilled by key hash into temporary files through the buffer manager.  After
+ * the input is consumed, the in-memory groups are emitted and every spill
+ * partition is aggregated the same way with a fresh hash function.
+ *
+ * With more than one thread, each batch read from the input is split between
+ * the calling thread and worker threads kept for the operator's lifetime,
+ * which pre-aggregate their share into thread-local tables; the partial
+ * aggregates are then merged into the main table on the calling thread,
+ * which also does all page accesses.  Batches pin no more pages than the
+ * buffer pool has left next to the spill partitions.
+ *
+ * Records too short to contain the key or any aggregated field are ignored.
+ * Results for UINT64 fields are returned as the bit pattern of the unsigned
+ * value.
+ *
+ * @warning This class is not threadsafe.
+ */
+class HashAggregate {
+ public:
+  /**
+   * Called once per group with its key bytes and one value per aggregate, in
+   * the order the aggregates were given.  Both pointers are only valid during
+   * the call.
+   */
+  typedef std::function<void(const char *key, const std::int64_t *values)>
+      Emit;
+
+  /**
+   * Constructs an aggregation operator.
+   *
+   * @param bufMgr          Buffer manager for all page accesses.
+   * @param temp_files      Manager creating the temporary spill files.
+   * @param group_key       Location of the group-by key.
+   * @param aggregates      Aggregates to compute per group.
+   * @param memory_budget   Bytes the group table may use in memory.
+   * @param num_partitions  Fan-out of each spill pass.
+   */
+  HashAggregate(BufMgr *bufMgr, TempFileManager *temp_files,
+                const GroupKey &group_key,
+                const std::vector<Aggregate> &aggregates,
+                const std::size_t memory_budget,
+                const std::size_t num_partitions = 16);
+
+  /**
+   * Sets the number of threads pre-aggregating input batches, starting all
+   * but the calling thread as workers.  One (the default) aggregates on the
+   * calling thread only.
+   */
+  void setThreads(const std::size_t num_threads);
+
+  /**
+   * Aggregates <input>, calling <emit> once per group in no particular order.
+   */
+  void aggregate(File &input, const Emit &emit);
+
+  /**
+   * Returns the number of spill files written by the last aggregation; zero
+   * if it ran entirely in memory.
+   */
+  std::size_t num_partition_files() const { return num_partition_files_; }
+
+ private:
+  /**
+   * Aggregates <input> at spill depth <level>.  At level zero the input holds
+   * raw records; below it holds partial aggregates.
+   */
+  void aggregateFile(File &input, const std::size_t level, const Emit &emit);
+
+  /**
+   * Buffer manager for all page accesses.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * Manager creating the temporary spill files.
+   */
+  TempFileManager *temp_files_;
+
+  /**
+   * Location of the group-by key.
+   */
+  GroupKey group_key_;
+
+  /**
+   * Aggregates computed per group.
+   */
+  std::vector<Aggregate> aggregates_;
+
+  /**
+   * Bytes the group table may use in memory.
+   */
+  std::size_t memory_budget_;
+
+  /**
+   * Fan-out of each spill pass.
+   */
+  std::size_t num_partitions_;
+
+  /**
+   * Number of threads pre-aggregating input batches.
+   */
+  std::size_t num_threads_;
+
+  /**
+   * Threads pre-aggregating input batches next to the calling thread, or
+   * NULL with a single thread.
+   */
+  std::unique_ptr<Executor> workers_;
+
+  /**
+   * Number of spill files written by the last aggregation.
+   */
+  std::size_t num_partition_files_;
+};
+
+}  // namespace badgerdb
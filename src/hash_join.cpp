@@ -0,0 +1,202 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "hash_join.h"
+
+#include <cassert>
+#include <memory>
+
+#include "batch_scanner.h"
+#include "hashing.h"
+#include "record_writer.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Partitioning depth after which build partitions are loaded regardless of
+ * the memory budget, so heavily duplicated keys cannot recurse forever.
+ */
+const std::size_t MAX_PARTITION_DEPTH = 4;
+
+/**
+ * Initial number of slots in a JoinHashTable.
+ */
+const std::size_t INITIAL_SLOTS = 1024;
+
+}  // namespace
+
+JoinHashTable::JoinHashTable(const JoinKey &key, const std::uint64_t seed)
+    : key_(key), seed_(seed), mask_(0) {}
+
+void JoinHashTable::insert(const RecordView &view) {
+  assert(key_.fits(view));
+  // Keep the load factor at or below one half so probe chains stay short.
+  if ((entries_.size() + 1) * 2 > slots_.size()) {
+    grow();
+  }
+  const std::uint32_t index = entries_.size();
+  entries_.push_back({arena_.size(), view.length});
+  arena_.insert(arena_.end(), view.data, view.data + view.length);
+  place(hash(view.data + key_.offset), index);
+}
+
+std::uint64_t JoinHashTable::hash(const char *key) const {
+  return hashBytes(key, key_.width, seed_);
+}
+
+void JoinHashTable::clear() {
+  slots_.assign(slots_.size(), Slot{0, 0});
+  entries_.clear();
+  arena_.clear();
+}
+
+std::size_t JoinHashTable::memoryUsed() const {
+  return arena_.size() + entries_.size() * sizeof(Entry) +
+         slots_.size() * sizeof(Slot);
+}
+
+void JoinHashTable::grow() {
+  const std::size_t new_size =
+      slots_.empty() ? INITIAL_SLOTS : slots_.size() * 2;
+  slots_.assign(new_size, Slot{0, 0});
+  mask_ = new_size - 1;
+  for (std::uint32_t i = 0; i < entries_.size(); ++i) {
+    place(hash(arena_.data() + entries_[i].offset + key_.offset), i);
+  }
+}
+
+void JoinHashTable::place(const std::uint64_t hash, const std::uint32_t index) {
+  std::size_t i = hash & mask_;
+  while (slots_[i].entry != 0) {
+    i = (i + 1) & mask_;
+  }
+  slots_[i] = {hash, index + 1};
+}
+
+HashJoin::HashJoin(BufMgr *bufMgr, TempFileManager *temp_files,
+                   const JoinKey &build_key, const JoinKey &probe_key,
+                   const std::size_t memory_budget,
+                   const std::size_t num_partitions)
+    : bufMgr_(bufMgr),
+      temp_files_(temp_files),
+      build_key_(build_key),
+      probe_key_(probe_key),
+      memory_budget_(memory_budget),
+      num_partitions_(num_partitions),
+      num_partition_files_(0) {
+  assert(bufMgr_ != NULL && temp_files_ != NULL);
+  assert(build_key_.width == probe_key_.width);
+  assert(num_partitions_ > 1);
+}
+
+void HashJoin::join(File &build, File &probe, const Emit &emit) {
+  num_partition_files_ = 0;
+  joinFiles(build, probe, 0 /* level */, emit);
+}
+
+void HashJoin::joinFiles(File &build, File &probe, const std::size_t level,
+                         const Emit &emit) {
+  bool fits = true;
+  {
+    JoinHashTable table(build_key_, level);
+    BatchScanner scanner(bufMgr_, &build, bufMgr_->numFrames());
+    RecordBatch batch;
+    while (fits && scanner.next(batch)) {
+      for (const RecordView &view : batch) {
+        if (!build_key_.fits(view)) {
+          continue;
+        }
+        table.insert(view);
+        if (table.memoryUsed() > memory_budget_ &&
+            level < MAX_PARTITION_DEPTH) {
+          fits = false;
+          break;
+        }
+      }
+    }
+    scanner.close();
+    if (fits) {
+      probeFile(probe, table, emit);
+      return;
+    }
+  }
+
+  // The build side does not fit: partition both sides and join the pairs.
+  std::vector<File> build_parts = partition(build, build_key_, level);
+  std::vector<File> probe_parts = partition(probe, probe_key_, level);
+  for (std::size_t i = 0; i < num_partitions_; ++i) {
+    joinFiles(build_parts[i], probe_parts[i], level + 1, emit);
+    temp_files_->drop(build_parts[i]);
+    temp_files_->drop(probe_parts[i]);
+  }
+}
+
+void HashJoin::probeFile(File &probe, const JoinHashTable &table,
+                         const Emit &emit) {
+  BatchScanner scanner(bufMgr_, &probe, bufMgr_->numFrames());
+  RecordBatch batch;
+  std::vector<std::uint64_t> hashes(batch.capacity());
+  while (scanner.next(batch)) {
+    // Hash the whole batch and prefetch its slots before probing, so the
+    // cache misses of different records overlap.
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      if (probe_key_.fits(batch[i])) {
+        hashes[i] = table.hash(batch[i].data + probe_key_.offset);
+        table.prefetch(hashes[i]);
+      }
+    }
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      const RecordView &probe_view = batch[i];
+      if (!probe_key_.fits(probe_view)) {
+        continue;
+      }
+      table.probe(hashes[i], probe_view.data + probe_key_.offset,
+                  [&emit, &probe_view](const RecordView &build_view) {
+                    emit(build_view, probe_view);
+                  });
+    }
+  }
+}
+
+std::vector<File> HashJoin::partition(File &input, const JoinKey &key,
+                                      const std::size_t level) {
+  std::vector<File> files;
+  for (std::size_t i = 0; i < num_partitions_; ++i) {
+    files.push_back(temp_files_->create());
+  }
+  num_partition_files_ += num_partitions_;
+  {
+    std::vector<std::unique_ptr<RecordWriter>> writers;
+    for (std::size_t i = 0; i < num_partitions_; ++i) {
+      writers.emplace_back(new RecordWriter(bufMgr_, &files[i]));
+    }
+    // Every writer pins the page it is filling; the scan gets the rest.
+    const std::size_t frames = bufMgr_->numFrames();
+    BatchScanner scanner(
+        bufMgr_, &input,
+        frames > num_partitions_ + 1 ? frames - num_partitions_ : 1);
+    RecordBatch batch;
+    while (scanner.next(batch)) {
+      for (const RecordView &view : batch) {
+        if (!key.fits(view)) {
+          continue;
+        }
+        // Use the high bits; the table at this level uses the low ones.
+        const std::uint64_t hash =
+            hashBytes(view.data + key.offset, key.width, level);
+        writers[(hash >> 32) % num_partitions_]->append(view.data,
+                                                        view.length);
+      }
+    }
+  }
+  return files;
+}
+
+}  // namespace badgerdb
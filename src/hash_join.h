@@ -0,0 +1,297 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "record_batch.h"
+#include "temp_file_manager.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Location of a join key inside a record.
+ */
+struct JoinKey {
+  /**
+   * Byte offset of the key.
+   */
+  std::size_t offset;
+
+  /**
+   * Width of the key in bytes.
+   */
+  std::size_t width;
+
+  /**
+   * Returns true if <view> is long enough to contain the key.
+   */
+  bool fits(const RecordView &view) const {
+    return offset + width <= view.length;
+  }
+};
+
+/**
+ * @brief Open-addressing hash table holding the build side of a hash join.
+ *
+ * Records are copied into one contiguous arena.  The table itself is a flat,
+ * power-of-two sized array of (hash, entry) pairs probed linearly, so a lookup
+ * usually touches a single cache line before comparing keys.  Duplicate keys
+ * are stored in separate slots and all returned by a probe.
+ *
+ * @warning This class is not threadsafe.
+ */
+class JoinHashTable {
+ public:
+  /**
+   * Constructs an empty table.
+   *
+   * @param key   Location of the key in build records.
+   * @param seed  Hash function seed.
+   */
+  JoinHashTable(const JoinKey &key, const std::uint64_t seed);
+
+  /**
+   * Copies <view> into the table.  The record must contain the key.
+   */
+  void insert(const RecordView &view);
+
+  /**
+   * Calls <emit> with every stored record whose key equals the key-width
+   * bytes at <key>.
+   *
+   * @param hash  Hash of the key, as returned by hash().
+   * @param key   Pointer to the probe key.
+   * @param emit  Called with each matching build record.
+   */
+  template <typename Emit>
+  void probe(const std::uint64_t hash, const char *key, Emit emit) const;
+
+  /**
+   * Issues a prefetch for the slot <hash> maps to.
+   */
+  void prefetch(const std::uint64_t hash) const {
+    if (!slots_.empty()) {
+      __builtin_prefetch(&slots_[hash & mask_]);
+    }
+  }
+
+  /**
+   * Returns the hash of the key at <key>.
+   */
+  std::uint64_t hash(const char *key) const;
+
+  /**
+   * Removes all records, keeping allocated memory.
+   */
+  void clear();
+
+  /**
+   * Returns the approximate memory used by the table in bytes.
+   */
+  std::size_t memoryUsed() const;
+
+  /**
+   * Returns the number of records in the table.
+   */
+  std::size_t size() const { return entries_.size(); }
+
+ private:
+  /**
+   * Slot of the open-addressing array.  <entry> is one more than the index
+   * into entries_, so zero marks an empty slot.
+   */
+  struct Slot {
+    std::uint64_t hash;
+    std::uint32_t entry;
+  };
+
+  /**
+   * Position of a stored record in the arena.
+   */
+  struct Entry {
+    std::size_t offset;
+    std::uint16_t length;
+  };
+
+  /**
+   * Doubles the slot array and reinserts all entries.
+   */
+  void grow();
+
+  /**
+   * Places entry <index> with hash <hash> into the slot array.
+   */
+  void place(const std::uint64_t hash, const std::uint32_t index);
+
+  /**
+   * Location of the key in stored records.
+   */
+  JoinKey key_;
+
+  /**
+   * Hash function seed.
+   */
+  std::uint64_t seed_;
+
+  /**
+   * Open-addressing slot array.
+   */
+  std::vector<Slot> slots_;
+
+  /**
+   * slots_.size() - 1.
+   */
+  std::size_t mask_;
+
+  /**
+   * Stored records.
+   */
+  std::vector<Entry> entries_;
+
+  /**
+   * Bytes of the stored records.
+   */
+  std::vector<char> arena_;
+};
+
+template <typename Emit>
+void JoinHashTable::probe(const std::uint64_t hash, const char *key,
+                          Emit emit) const {
+  if (slots_.empty()) {
+    return;
+  }
+  for (std::size_t i = hash & mask_; slots_[i].entry != 0;
+       i = (i + 1) & mask_) {
+    if (slots_[i].hash != hash) {
+      continue;
+    }
+    const Entry &entry = entries_[slots_[i].entry - 1];
+    const char *data = arena_.data() + entry.offset;
+    if (std::memcmp(data + key_.offset, key, key_.width) == 0) {
+      emit(RecordView{{Page::INVALID_NUMBER, Page::INVALID_SLOT}, data,
+                      entry.length});
+    }
+  }
+}
+
+/**
+ * @brief Equi-join of two record files on fixed-position keys.
+ *
+ * If the build input fits in the memory budget it is loaded into a
+ * JoinHashTable and the probe input is streamed against it in batches.
+ * Otherwise both inputs are partitioned by key hash into temporary files
+ * through the buffer manager (grace hash join) and each pair of partitions is
+ * joined in turn, partitioning again with a fresh hash function if a build
+ * partition still does not fit.  Scans pin no more pages than the buffer
+ * pool has left next to the partition writers.
+ *
+ * Records too short to contain their key never match.
+ *
+ * @warning This class is not threadsafe.
+ */
+class HashJoin {
+ public:
+  /**
+   * Called for every joined pair.  Both views are only valid during the call.
+   */
+  typedef std::function<void(const RecordView &build, const RecordView &probe)>
+      Emit;
+
+  /**
+   * Constructs a join operator.
+   *
+   * @param bufMgr          Buffer manager for all page accesses.
+   * @param temp_files      Manager creating the temporary partition files.
+   * @param build_key       Location of the key in build records.
+   * @param probe_key       Location of the key in probe records; must have
+   *                        the same width as <build_key>.
+   * @param memory_budget   Bytes the build side may use in memory.
+   * @param num_partitions  Fan-out of each partitioning pass.
+   */
+  HashJoin(BufMgr *bufMgr, TempFileManager *temp_files,
+           const JoinKey &build_key, const JoinKey &probe_key,
+           const std::size_t memory_budget,
+           const std::size_t num_partitions = 16);
+
+  /**
+   * Joins <build> with <probe>, calling <emit> for every matching pair.
+   */
+  void join(File &build, File &probe, const Emit &emit);
+
+  /**
+   * Returns the number of partition files written by the last join; zero if
+   * it ran entirely in memory.
+   */
+  std::size_t num_partition_files() const { return num_partition_files_; }
+
+ private:
+  /**
+   * Joins the two files at partitioning depth <level>.
+   */
+  void joinFiles(File &build, File &probe, const std::size_t level,
+                 const Emit &emit);
+
+  /**
+   * Streams <probe> against the loaded table.
+   */
+  void probeFile(File &probe, const JoinHashTable &table, const Emit &emit);
+
+  /**
+   * Splits <input> into num_partitions_ temporary files by the hash of <key>
+   * at depth <level>.
+   */
+  std::vector<File> partition(File &input, const JoinKey &key,
+                              const std::size_t level);
+
+  /**
+   * Buffer manager for all page accesses.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * Manager creating the temporary partition files.
+   */
+  TempFileManager *temp_files_;
+
+  /**
+   * Location of the key in build records.
+   */
+  JoinKey build_key_;
+
+  /**
+   * Location of the key in probe records.
+   */
+  JoinKey probe_key_;
+
+  /**
+   * Bytes the build side may use in memory.
+   */
+  std::size_t memory_budget_;
+
+  /**
+   * Fan-out of each partitioning pass.
+   */
+  std::size_t num_partitions_;
+
+  /**
+   * Number of partition files written by the last join.
+   */
+  std::size_t num_partition_files_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,39 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * Hashes <length> bytes at <data> (64-bit FNV-1a followed by a final mix so
+ * that both the low and the high bits are usable).  Different seeds give
+ * independent hash functions, which operators use to partition recursively.
+ *
+ * @param data    Bytes to hash.
+ * @param length  Number of bytes.
+ * @param seed    Selects the hash function.
+ * @return  Hash value.
+ */
+inline std::uint64_t hashBytes(const char *data, const std::size_t length,
+                               const std::uint64_t seed = 0) {
+  std::uint64_t hash = 14695981039346656037ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+  for (std::size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+}  // namespace badgerdb
@@ -1,20 +1,55 @@
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include <iostream>
 //#include <stdio.h>
 #include <cstring>
+#include <fstream>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
 #include <optional>
+#include <set>
+#include <thread>
 
 #include "buffer.h"
+#include "buffer_pools.h"
+#include "compressed_cache.h"
 #include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/file_cached_exception.h"
 #include "exceptions/file_not_found_exception.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "external_sort.h"
 #include "exceptions/invalid_page_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
+#include "exceptions/pool_exists_exception.h"
+#include "exceptions/pool_not_found_exception.h"
+#include "async_page_fetch.h"
+#include "batch_lookup.h"
+#include "batch_scanner.h"
+#include "exceptions/invalid_record_exception.h"
 #include "file_iterator.h"
+#include "free_frame_list.h"
+#include "fixed_page.h"
+#include "hash_aggregate.h"
+#include "hash_join.h"
 #include "page.h"
+#include "page_buffer_pool.h"
+#include "page_compressor.h"
+#include "optimistic_read.h"
+#include "overflow_cursor.h"
+#include "overflow_record.h"
 #include "page_iterator.h"
+#include "predicate.h"
+#include "record_batch.h"
+#include "record_writer.h"
+#include "ssd_cache.h"
+#include "temp_file_manager.h"
+#include "vacuum.h"
 
 #define PRINT_ERROR(str)                            \
   {                                                 \
@@ -40,6 +75,34 @@ void test3(File &file4);
 void test4(File &file4);
 void test5(File &file4);
 void test6(File &file1);
+void test7(File &file6);
+void test8(File &file7);
+void test9(File &file8);
+void test10(File &file9, File &file10);
+void test11(File &file11, File &file12);
+void test12(File &file13);
+void test13();
+void test14(File &file14);
+void test15(File &file15);
+void test16(File &file16);
+void test17(File &file17);
+void test18(File &file18);
+void test19(File &file19);
+void test20(File &file20);
+void test21(File &file21);
+void test22(File &file22);
+void test23(File &file23);
+void test24(File &file24);
+void test25(File &file25);
+void test26(File &file26);
+void test27(File &file27);
+void test28(File &file28);
+void test29(File &file29);
+void test30(File &file30);
+void test31(File &file31);
+void test32(File &file32);
+void test33(File &file33);
+void test34(File &file34);
 // Calls the above tests
 void testBufMgr();
 
@@ -111,6 +174,35 @@ void testBufMgr() {
   const std::string filename3 = "test.3";
   const std::string filename4 = "test.4";
   const std::string filename5 = "test.5";
+  const std::string filename6 = "test.6";
+  const std::string filename7 = "test.7";
+  const std::string filename8 = "test.8";
+  const std::string filename9 = "test.9";
+  const std::string filename10 = "test.10";
+  const std::string filename11 = "test.11";
+  const std::string filename12 = "test.12";
+  const std::string filename13 = "test.13";
+  const std::string filename14 = "test.14";
+  const std::string filename15 = "test.15";
+  const std::string filename16 = "test.16";
+  const std::string filename17 = "test.17";
+  const std::string filename18 = "test.18";
+  const std::string filename19 = "test.19";
+  const std::string filename20 = "test.20";
+  const std::string filename21 = "test.21";
+  const std::string filename22 = "test.22";
+  const std::string filename23 = "test.23";
+  const std::string filename24 = "test.24";
+  const std::string filename25 = "test.25";
+  const std::string filename26 = "test.26";
+  const std::string filename27 = "test.27";
+  const std::string filename28 = "test.28";
+  const std::string filename29 = "test.29";
+  const std::string filename30 = "test.30";
+  const std::string filename31 = "test.31";
+  const std::string filename32 = "test.32";
+  const std::string filename33 = "test.33";
+  const std::string filename34 = "test.34";
 
   // Clean up from any previous runs that crashed.
   try {
@@ -119,6 +211,35 @@ void testBufMgr() {
     File::remove(filename3);
     File::remove(filename4);
     File::remove(filename5);
+    File::remove(filename6);
+    File::remove(filename7);
+    File::remove(filename8);
+    File::remove(filename9);
+    File::remove(filename10);
+    File::remove(filename11);
+    File::remove(filename12);
+    File::remove(filename13);
+    File::remove(filename14);
+    File::remove(filename15);
+    File::remove(filename16);
+    File::remove(filename17);
+    File::remove(filename18);
+    File::remove(filename19);
+    File::remove(filename20);
+    File::remove(filename21);
+    File::remove(filename22);
+    File::remove(filename23);
+    File::remove(filename24);
+    File::remove(filename25);
+    File::remove(filename26);
+    File::remove(filename27);
+    File::remove(filename28);
+    File::remove(filename29);
+    File::remove(filename30);
+    File::remove(filename31);
+    File::remove(filename32);
+    File::remove(filename33);
+    File::remove(filename34);
   } catch (const FileNotFoundException &e) {
   }
 
@@ -128,6 +249,35 @@ void testBufMgr() {
     File file3 = File::create(filename3);
     File file4 = File::create(filename4);
     File file5 = File::create(filename5);
+    File file6 = File::create(filename6);
+    File file7 = File::create(filename7);
+    File file8 = File::create(filename8);
+    File file9 = File::create(filename9);
+    File file10 = File::create(filename10);
+    File file11 = File::create(filename11);
+    File file12 = File::create(filename12);
+    File file13 = File::create(filename13);
+    File file14 = File::create(filename14);
+    File file15 = File::create(filename15);
+    File file16 = File::create(filename16);
+    File file17 = File::create(filename17);
+    File file18 = File::create(filename18);
+    File file19 = File::create(filename19);
+    File file20 = File::create(filename20);
+    File file21 = File::create(filename21);
+    File file22 = File::create(filename22);
+    File file23 = File::create(filename23);
+    File file24 = File::create(filename24);
+    File file25 = File::create(filename25);
+    File file26 = File::create(filename26);
+    File file27 = File::create(filename27);
+    File file28 = File::create(filename28);
+    File file29 = File::create(filename29);
+    File file30 = File::create(filename30);
+    File file31 = File::create(filename31);
+    File file32 = File::create(filename32);
+    File file33 = File::create(filename33);
+    File file34 = File::create(filename34);
 
     // Test buffer manager
     // Comment tests which you do not wish to run now. Tests are dependent on
@@ -140,6 +290,34 @@ void testBufMgr() {
     test4(file4);
     test5(file5);
     test6(file1);
+    test7(file6);
+    test8(file7);
+    test9(file8);
+    test10(file9, file10);
+    test11(file11, file12);
+    test12(file13);
+    test13();
+    test14(file14);
+    test15(file15);
+    test16(file16);
+    test17(file17);
+    test18(file18);
+    test19(file19);
+    test20(file20);
+    test21(file21);
+    test22(file22);
+    test23(file23);
+    test24(file24);
+    test25(file25);
+    test26(file26);
+    test27(file27);
+    test28(file28);
+    test29(file29);
+    test30(file30);
+    test31(file31);
+    test32(file32);
+    test33(file33);
+    test34(file34);
 
     // Close the files by going out of scope
   }
@@ -150,6 +328,35 @@ void testBufMgr() {
   File::remove(filename3);
   File::remove(filename4);
   File::remove(filename5);
+  File::remove(filename6);
+  File::remove(filename7);
+  File::remove(filename8);
+  File::remove(filename9);
+  File::remove(filename10);
+  File::remove(filename11);
+  File::remove(filename12);
+  File::remove(filename13);
+  File::remove(filename14);
+  File::remove(filename15);
+  File::remove(filename16);
+  File::remove(filename17);
+  File::remove(filename18);
+  File::remove(filename19);
+  File::remove(filename20);
+  File::remove(filename21);
+  File::remove(filename22);
+  File::remove(filename23);
+  File::remove(filename24);
+  File::remove(filename25);
+  File::remove(filename26);
+  File::remove(filename27);
+  File::remove(filename28);
+  File::remove(filename29);
+  File::remove(filename30);
+  File::remove(filename31);
+  File::remove(filename32);
+  File::remove(filename33);
+  File::remove(filename34);
 
   std::cout << "\n"
             << "Passed all tests."
@@ -297,3 +504,2485 @@ void test6(File &file1) {
 
   bufMgr->flushFile(file1);
 }
+
+void test7(File &file6) {
+  // Batch scans must return every record exactly once, spanning pages.
+  const SlotId records_per_page = 30;
+  for (i = 0; i < num / 5; i++) {
+    bufMgr->allocPage(file6, pageno1, page);
+    for (SlotId s = 0; s < records_per_page; s++) {
+      sprintf(tmpbuf, "test.6 Page %u Record %u", pageno1, s + 1);
+      page->insertRecord(tmpbuf);
+    }
+    bufMgr->unPinPage(file6, pageno1, true);
+  }
+
+  RecordBatch batch(64);
+  BatchScanner scanner(bufMgr.get(), &file6);
+  PageId found = 0;
+  while (scanner.next(batch)) {
+    for (const RecordView &view : batch) {
+      sprintf(tmpbuf, "test.6 Page %u Record %u", view.rid.page_number,
+              view.rid.slot_number);
+      if (view.length != strlen(tmpbuf) ||
+          strncmp(view.data, tmpbuf, view.length) != 0) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+      found++;
+    }
+  }
+  if (found != (num / 5) * records_per_page) {
+    PRINT_ERROR("ERROR :: BATCH SCAN MISSED RECORDS");
+  }
+
+  // All pages must have been unpinned by the end of the scan.
+  bufMgr->flushFile(file6);
+
+  std::cout << "Test 7 passed"
+            << "\n";
+}
+
+// Counts the records of <file> returned by a filtered batch scan.
+static PageId countMatches(File &file, const Predicate &predicate) {
+  RecordBatch batch(50);
+  BatchScanner scanner(bufMgr.get(), &file);
+  PageId found = 0;
+  while (scanner.next(batch, predicate)) {
+    for (const RecordView &view : batch) {
+      if (!predicate.matches(view)) {
+        PRINT_ERROR("ERROR :: FILTER RETURNED A NON-MATCHING RECORD");
+      }
+      found++;
+    }
+  }
+  return found;
+}
+
+void test8(File &file7) {
+  // Records are a 4-byte key followed by a text payload.
+  const std::int32_t num_keys = 400;
+  bufMgr->allocPage(file7, pageno1, page);
+  for (std::int32_t key = 0; key < num_keys; key++) {
+    std::string record(reinterpret_cast<const char *>(&key), sizeof(key));
+    record += "test.7 payload";
+    if (!page->hasSpaceForRecord(record)) {
+      bufMgr->unPinPage(file7, pageno1, true);
+      bufMgr->allocPage(file7, pageno1, page);
+    }
+    page->insertRecord(record);
+  }
+  bufMgr->unPinPage(file7, pageno1, true);
+
+  if (countMatches(file7, Predicate::compareField(FieldType::INT32, 0,
+                                                  CompareOp::GE, 300)) != 100) {
+    PRINT_ERROR("ERROR :: FIELD FILTER RETURNED WRONG COUNT");
+  }
+  if (countMatches(file7, Predicate::compareField(FieldType::INT32, 0,
+                                                  CompareOp::EQ, 7)) != 1) {
+    PRINT_ERROR("ERROR :: FIELD FILTER RETURNED WRONG COUNT");
+  }
+  // The field lies past the end of every record, so nothing may match.
+  if (countMatches(file7, Predicate::compareField(FieldType::INT64, 100,
+                                                  CompareOp::NE, 0)) != 0) {
+    PRINT_ERROR("ERROR :: FIELD FILTER MATCHED A SHORT RECORD");
+  }
+  const std::int32_t prefix_key = 42;
+  if (countMatches(file7, Predicate::hasPrefix(std::string(
+                              reinterpret_cast<const char *>(&prefix_key),
+                              sizeof(prefix_key)))) != 1) {
+    PRINT_ERROR("ERROR :: PREFIX FILTER RETURNED WRONG COUNT");
+  }
+  if (countMatches(file7, Predicate::matching([](const char *data,
+                                                 std::uint16_t length) {
+                     std::int32_t key;
+                     memcpy(&key, data, sizeof(key));
+                     return key % 2 == 0;
+                   })) != num_keys / 2) {
+    PRINT_ERROR("ERROR :: FUNCTOR FILTER RETURNED WRONG COUNT");
+  }
+
+  bufMgr->flushFile(file7);
+
+  std::cout << "Test 8 passed"
+            << "\n";
+}
+
+void test9(File &file8) {
+  // Rows are a 4-byte key, an 8-byte value and an 8-byte name.
+  const FixedSchema schema({4, 8, 8});
+  // Column widths that wrap a 16-bit row width must not be accepted.
+  try {
+    FixedSchema wide({60000, 60000});
+    PRINT_ERROR(
+        "ERROR :: Row is wider than a page. Exception should have been thrown "
+        "before execution reaches this point.");
+  } catch (const InsufficientSpaceException &e) {
+  }
+  const PageType layouts[] = {PageType::FIXED_ROW, PageType::FIXED_PAX};
+  PageId layout_pages[2];
+  for (int l = 0; l < 2; l++) {
+    bufMgr->allocPage(file8, layout_pages[l], page);
+    FixedPage fixed = FixedPage::format(page, schema, layouts[l]);
+    for (std::int32_t key = 0; key < fixed.capacity(); key++) {
+      const std::int64_t value = key * 10;
+      std::string row(reinterpret_cast<const char *>(&key), sizeof(key));
+      row.append(reinterpret_cast<const char *>(&value), sizeof(value));
+      row.append("name");
+      fixed.insertRecord(row);
+    }
+    try {
+      fixed.insertRecord("x");
+      PRINT_ERROR(
+          "ERROR :: Page is full. Exception should have been thrown "
+          "before execution reaches this point.");
+    } catch (const InsufficientSpaceException &e) {
+    }
+    // Delete every third row.
+    for (SlotId slot = 1; slot <= fixed.capacity(); slot += 3) {
+      fixed.deleteRecord({layout_pages[l], slot});
+    }
+    bufMgr->unPinPage(file8, layout_pages[l], true);
+  }
+  // Force the pages to disk and read them back.
+  bufMgr->flushFile(file8);
+
+  for (int l = 0; l < 2; l++) {
+    bufMgr->readPage(file8, layout_pages[l], page);
+    if (page->page_type() != layouts[l]) {
+      PRINT_ERROR("ERROR :: PAGE TYPE WAS NOT PERSISTED");
+    }
+    FixedPage fixed(page);
+    std::vector<SlotId> slots;
+    fixed.selectColumn<std::int32_t>(0, CompareOp::LT, 30, slots);
+    // Keys 0..29 minus the deleted keys 0, 3, ..., 27.
+    if (slots.size() != 20) {
+      PRINT_ERROR("ERROR :: COLUMN SELECTION RETURNED WRONG COUNT");
+    }
+    for (const SlotId slot : slots) {
+      const std::string row = fixed.getRecord({layout_pages[l], slot});
+      std::int32_t key;
+      std::int64_t value;
+      memcpy(&key, row.data(), sizeof(key));
+      memcpy(&value, row.data() + 4, sizeof(value));
+      if (key != slot - 1 || value != key * 10 ||
+          strncmp(row.data() + 12, "name", 4) != 0) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+    }
+    // Slotted-page accessors must reject fixed-width pages.
+    try {
+      page->getRecord({layout_pages[l], 2});
+      PRINT_ERROR(
+          "ERROR :: Page is not slotted. Exception should have been thrown "
+          "before execution reaches this point.");
+    } catch (const InvalidRecordException &e) {
+    }
+    bufMgr->unPinPage(file8, layout_pages[l], false);
+  }
+  bufMgr->flushFile(file8);
+
+  std::cout << "Test 9 passed"
+            << "\n";
+}
+
+void test10(File &file9, File &file10) {
+  // A small pool forces several runs and more than one merge pass.
+  BufMgr sortMgr(10);
+  TempFileManager tempFiles(&sortMgr);
+  const int num_records = 3000;
+  {
+    RecordWriter writer(&sortMgr, &file9);
+    for (int r = 0; r < num_records; r++) {
+      sprintf(tmpbuf, "%08ld test.9 record padding to forty", random());
+      writer.append(tmpbuf);
+    }
+  }
+  sortMgr.flushFile(file9);
+
+  ExternalSort sorter(&sortMgr, &tempFiles, 0.3);
+  sorter.sort(file9, file10);
+  if (sorter.num_runs() < 2 || sorter.num_merge_passes() < 2) {
+    PRINT_ERROR("ERROR :: SORT DID NOT SPILL");
+  }
+  if (tempFiles.num_open() != 0) {
+    PRINT_ERROR("ERROR :: SORT DID NOT DROP ITS RUNS");
+  }
+
+  RecordBatch batch;
+  BatchScanner scanner(&sortMgr, &file10);
+  std::string previous;
+  int found = 0;
+  while (scanner.next(batch)) {
+    for (const RecordView &view : batch) {
+      const std::string record(view.data, view.length);
+      if (record < previous) {
+        PRINT_ERROR("ERROR :: SORT OUTPUT IS OUT OF ORDER");
+      }
+      previous = record;
+      found++;
+    }
+  }
+  scanner.close();
+  if (found != num_records) {
+    PRINT_ERROR("ERROR :: SORT LOST RECORDS");
+  }
+  sortMgr.flushFile(file9);
+  sortMgr.flushFile(file10);
+
+  std::cout << "Test 10 passed"
+            << "\n";
+}
+
+// Appends a record made of a 4-byte key followed by <payload>.
+static void appendKeyed(RecordWriter &writer, const std::int32_t key,
+                        const char *payload) {
+  std::string record(reinterpret_cast<const char *>(&key), sizeof(key));
+  record += payload;
+  writer.append(record);
+}
+
+void test11(File &file11, File &file12) {
+  BufMgr joinMgr(40);
+  TempFileManager tempFiles(&joinMgr);
+  {
+    RecordWriter build(&joinMgr, &file11);
+    for (std::int32_t key = 0; key < 500; key++) {
+      appendKeyed(build, key, "test.11 build");
+    }
+    RecordWriter probe(&joinMgr, &file12);
+    for (std::int32_t key = 0; key < 1000; key++) {
+      appendKeyed(probe, key % 600, "test.12 probe");
+    }
+  }
+  // Keys 0..399 appear twice on the probe side and keys 400..499 once.
+  const int expected = 900;
+
+  const JoinKey key = {0, sizeof(std::int32_t)};
+  const std::size_t budgets[] = {1 << 20, 2048};
+  for (const std::size_t budget : budgets) {
+    HashJoin join(&joinMgr, &tempFiles, key, key, budget, 4);
+    int found = 0;
+    join.join(file11, file12,
+              [&found](const RecordView &build, const RecordView &probe) {
+                if (memcmp(build.data, probe.data, sizeof(std::int32_t)) != 0 ||
+                    strncmp(build.data + 4, "test.11", 7) != 0 ||
+                    strncmp(probe.data + 4, "test.12", 7) != 0) {
+                  PRINT_ERROR("ERROR :: JOINED RECORDS DO NOT MATCH");
+                }
+                found++;
+              });
+    if (found != expected) {
+      PRINT_ERROR("ERROR :: JOIN RETURNED WRONG NUMBER OF PAIRS");
+    }
+    if ((join.num_partition_files() == 0) != (budget == (1 << 20))) {
+      PRINT_ERROR("ERROR :: JOIN DID NOT SPILL AS EXPECTED");
+    }
+  }
+  joinMgr.flushFile(file11);
+  joinMgr.flushFile(file12);
+
+  // Partitioning wide records through a pool barely larger than the 16
+  // partition writers: a full batch would span more pages than are left.
+  {
+    BufMgr smallMgr(24);
+    TempFileManager smallFiles(&smallMgr);
+    File wide_build = smallFiles.create();
+    File wide_probe = smallFiles.create();
+    const std::string padding(300, '.');
+    {
+      RecordWriter build(&smallMgr, &wide_build);
+      RecordWriter probe(&smallMgr, &wide_probe);
+      for (std::int32_t key = 0; key < 500; key++) {
+        appendKeyed(build, key, ("test.11 build" + padding).c_str());
+        appendKeyed(probe, key, ("test.12 probe" + padding).c_str());
+      }
+    }
+    HashJoin join(&smallMgr, &smallFiles, key, key, 2048);
+    int found = 0;
+    join.join(wide_build, wide_probe,
+              [&found](const RecordView &build, const RecordView &probe) {
+                if (memcmp(build.data, probe.data, sizeof(std::int32_t)) != 0) {
+                  PRINT_ERROR("ERROR :: JOINED RECORDS DO NOT MATCH");
+                }
+                found++;
+              });
+    if (found != 500 || join.num_partition_files() == 0) {
+      PRINT_ERROR("ERROR :: WIDE JOIN RETURNED WRONG NUMBER OF PAIRS");
+    }
+    smallFiles.drop(wide_build);
+    smallFiles.drop(wide_probe);
+  }
+
+  std::cout << "Test 11 passed"
+            << "\n";
+}
+
+void test12(File &file13) {
+  // Records are a 4-byte group key followed by an 8-byte value.
+  BufMgr aggMgr(40);
+  TempFileManager tempFiles(&aggMgr);
+  const std::int32_t num_records = 6000;
+  const std::int32_t num_groups = 3000;
+  {
+    RecordWriter writer(&aggMgr, &file13);
+    for (std::int32_t r = 0; r < num_records; r++) {
+      const std::int32_t key = r % num_groups;
+      const std::int64_t value = r;
+      std::string record(reinterpret_cast<const char *>(&key), sizeof(key));
+      record.append(reinterpret_cast<const char *>(&value), sizeof(value));
+      writer.append(record);
+    }
+  }
+
+  const std::vector<Aggregate> aggregates = {
+      {AggregateFunction::COUNT, FieldType::INT64, 0},
+      {AggregateFunction::SUM, FieldType::INT64, 4},
+      {AggregateFunction::MIN, FieldType::INT64, 4},
+      {AggregateFunction::MAX, FieldType::INT64, 4}};
+  const GroupKey key = {0, sizeof(std::int32_t)};
+  // Run in memory and with a budget that forces spilling, each with one and
+  // with four threads.
+  const std::size_t budgets[] = {1 << 22, 16384};
+  for (const std::size_t budget : budgets) {
+    for (std::size_t threads = 1; threads <= 4; threads += 3) {
+      HashAggregate aggregate(&aggMgr, &tempFiles, key, aggregates, budget, 4);
+      aggregate.setThreads(threads);
+      std::vector<int> seen(num_groups, 0);
+      aggregate.aggregate(file13, [&seen](const char *group_key,
+                                          const std::int64_t *values) {
+        std::int32_t group;
+        memcpy(&group, group_key, sizeof(group));
+        // Group g holds the values g and g + num_groups.
+        if (group < 0 || group >= num_groups || values[0] != 2 ||
+            values[1] != 2 * group + num_groups || values[2] != group ||
+            values[3] != group + num_groups) {
+          PRINT_ERROR("ERROR :: AGGREGATE VALUES DID NOT MATCH");
+        }
+        seen[group]++;
+      });
+      for (std::int32_t g = 0; g < num_groups; g++) {
+        if (seen[g] != 1) {
+          PRINT_ERROR("ERROR :: GROUP EMITTED WRONG NUMBER OF TIMES");
+        }
+      }
+      if ((aggregate.num_partition_files() == 0) != (budget == (1 << 22))) {
+        PRINT_ERROR("ERROR :: AGGREGATION DID NOT SPILL AS EXPECTED");
+      }
+    }
+  }
+  aggMgr.flushFile(file13);
+
+  std::cout << "Test 12 passed"
+            << "\n";
+}
+
+void test13() {
+  std::string directory;
+  {
+    TempFileManager tempFiles(bufMgr.get());
+    directory = tempFiles.directory();
+    if (access(directory.c_str(), F_OK) != 0) {
+      PRINT_ERROR("ERROR :: TEMP DIRECTORY WAS NOT CREATED");
+    }
+
+    File temp = tempFiles.create();
+    if (File::exists(temp.filename())) {
+      PRINT_ERROR("ERROR :: TEMP FILE IS VISIBLE IN THE FILESYSTEM");
+    }
+    const PageId num_temp = 10;
+    for (i = 0; i < num_temp; i++) {
+      bufMgr->allocPage(temp, pid[i], page);
+      sprintf(tmpbuf, "test.13 Page %u %7.1f", pid[i], (float)pid[i]);
+      rid[i] = page->insertRecord(tmpbuf);
+      bufMgr->unPinPage(temp, pid[i], true);
+    }
+    // Pages of an anonymous file can be read back.
+    for (i = 0; i < num_temp; i++) {
+      bufMgr->readPage(temp, pid[i], page);
+      sprintf(tmpbuf, "test.13 Page %u %7.1f", pid[i], (float)pid[i]);
+      if (strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) !=
+          0) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+      bufMgr->unPinPage(temp, pid[i], false);
+    }
+
+    bufMgr->readPage(temp, pid[0], page);
+    try {
+      tempFiles.drop(temp);
+      PRINT_ERROR(
+          "ERROR :: Pages pinned for file being dropped. Exception should "
+          "have been thrown before execution reaches this point.");
+    } catch (const PagePinnedException &e) {
+    }
+    bufMgr->unPinPage(temp, pid[0], false);
+
+    // Dropping discards the dirty pages without writing them, so only the
+    // empty pages written on allocation are left in the file.
+    tempFiles.drop(temp);
+    if (tempFiles.num_open() != 0) {
+      PRINT_ERROR("ERROR :: DROPPED TEMP FILE IS STILL OPEN");
+    }
+    for (i = 0; i < num_temp; i++) {
+      bufMgr->readPage(temp, pid[i], page);
+      if (page->begin() != page->end()) {
+        PRINT_ERROR("ERROR :: DROPPED TEMP FILE WAS WRITTEN BACK");
+      }
+      bufMgr->unPinPage(temp, pid[i], false);
+    }
+    bufMgr->flushFile(temp);
+
+    // Files left over are dropped with the manager.
+    File leftover = tempFiles.create();
+    bufMgr->allocPage(leftover, pageno1, page);
+    bufMgr->unPinPage(leftover, pageno1, true);
+  }
+  if (access(directory.c_str(), F_OK) == 0) {
+    PRINT_ERROR("ERROR :: TEMP DIRECTORY WAS NOT REMOVED");
+  }
+
+  std::cout << "Test 13 passed"
+            << "\n";
+}
+
+void test14(File &file14) {
+  const PageId num_pages = 20;
+  for (i = 0; i < num_pages; i++) {
+    bufMgr->allocPage(file14, pid[i], page);
+    sprintf(tmpbuf, "test.14 Page %u %7.1f", pid[i], (float)pid[i]);
+    rid[i] = page->insertRecord(tmpbuf);
+    bufMgr->unPinPage(file14, pid[i], true);
+  }
+
+  bufMgr->readPage(file14, pid[0], page);
+  try {
+    bufMgr->invalidateFile(file14);
+    PRINT_ERROR(
+        "ERROR :: Pages pinned for file being invalidated. Exception should "
+        "have been thrown before execution reaches this point.");
+  } catch (const PagePinnedException &e) {
+  }
+  bufMgr->unPinPage(file14, pid[0], false);
+
+  // Invalidation frees the frames without writing the dirty pages.
+  bufMgr->clearBufStats();
+  const std::uint32_t free_before = bufMgr->numFreeFrames();
+  bufMgr->invalidateFile(file14);
+  if (bufMgr->getBufStats().diskwrites != 0 ||
+      bufMgr->getBufStats().discards != (int)num_pages) {
+    PRINT_ERROR("ERROR :: INVALIDATED PAGES WERE WRITTEN BACK");
+  }
+  if (bufMgr->numFreeFrames() != free_before + num_pages) {
+    PRINT_ERROR("ERROR :: INVALIDATED FRAMES NOT ON THE FREE LIST");
+  }
+
+  // Reading the pages back takes frames from the free list and finds the
+  // pages as they were on disk, without the records.
+  for (i = 0; i < num_pages; i++) {
+    bufMgr->readPage(file14, pid[i], page);
+    if (page->begin() != page->end()) {
+      PRINT_ERROR("ERROR :: INVALIDATED PAGE WAS WRITTEN BACK");
+    }
+    bufMgr->unPinPage(file14, pid[i], false);
+  }
+  if (bufMgr->numFreeFrames() != free_before) {
+    PRINT_ERROR("ERROR :: FREE FRAMES WERE NOT REUSED");
+  }
+  bufMgr->flushFile(file14);
+
+  std::cout << "Test 14 passed"
+            << "\n";
+}
+
+void test15(File &file15) {
+  // A fresh pool hands out frames from the free list without sweeping.
+  BufMgr freeMgr(20);
+  if (freeMgr.numFreeFrames() != 20) {
+    PRINT_ERROR("ERROR :: NEW POOL DOES NOT START WITH ALL FRAMES FREE");
+  }
+  for (i = 0; i < 10; i++) {
+    freeMgr.allocPage(file15, pid[i], page);
+    freeMgr.unPinPage(file15, pid[i], true);
+  }
+  if (freeMgr.numFreeFrames() != 10) {
+    PRINT_ERROR("ERROR :: ALLOCATED FRAMES STILL ON THE FREE LIST");
+  }
+
+  // Disposing and flushing return the frames.
+  freeMgr.disposePage(file15, pid[0]);
+  freeMgr.disposePage(file15, pid[1]);
+  if (freeMgr.numFreeFrames() != 12) {
+    PRINT_ERROR("ERROR :: DISPOSED FRAMES NOT ON THE FREE LIST");
+  }
+  freeMgr.flushFile(file15);
+  if (freeMgr.numFreeFrames() != 20) {
+    PRINT_ERROR("ERROR :: FLUSHED FRAMES NOT ON THE FREE LIST");
+  }
+  for (i = 2; i < 10; i++) {
+    freeMgr.readPage(file15, pid[i], page);
+    freeMgr.unPinPage(file15, pid[i], false);
+  }
+  freeMgr.flushFile(file15);
+
+  // Concurrent pops and pushes neither lose nor duplicate frames.
+  const std::uint32_t num_frames = 64;
+  FreeFrameList list(num_frames);
+  for (FrameId f = 0; f < num_frames; f++) {
+    list.push(f);
+  }
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 4; t++) {
+    workers.emplace_back([&list]() {
+      FrameId held[8];
+      for (int round = 0; round < 20000; round++) {
+        int count = 0;
+        while (count < 8 && list.pop(held[count])) {
+          count++;
+        }
+        while (count > 0) {
+          list.push(held[--count]);
+        }
+      }
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  std::vector<bool> seen(num_frames, false);
+  FrameId frame;
+  while (list.pop(frame)) {
+    if (frame >= num_frames || seen[frame]) {
+      PRINT_ERROR("ERROR :: FREE LIST RETURNED A FRAME TWICE");
+    }
+    seen[frame] = true;
+  }
+  for (FrameId f = 0; f < num_frames; f++) {
+    if (!seen[f]) {
+      PRINT_ERROR("ERROR :: FREE LIST LOST A FRAME");
+    }
+  }
+
+  std::cout << "Test 15 passed"
+            << "\n";
+}
+
+void test16(File &file16) {
+  const std::string dump = "test.16.dump";
+  const PageId num_pages = 20;
+  {
+    BufMgr dumpMgr(num_pages);
+    for (i = 0; i < num_pages; i++) {
+      dumpMgr.allocPage(file16, pid[i], page);
+      sprintf(tmpbuf, "test.16 Page %u %7.1f", pid[i], (float)pid[i]);
+      rid[i] = page->insertRecord(tmpbuf);
+      dumpMgr.unPinPage(file16, pid[i], true);
+    }
+    dumpMgr.flushFile(file16);
+
+    // Page i is pinned i + 1 times, so higher pages are hotter.
+    for (i = 10; i < num_pages; i++) {
+      for (PageId hit = 0; hit <= i; hit++) {
+        dumpMgr.readPage(file16, pid[i], page);
+        dumpMgr.unPinPage(file16, pid[i], false);
+      }
+    }
+    dumpMgr.dumpResidentPages(dump);
+    dumpMgr.flushFile(file16);
+  }
+  {
+    // Pages of files that no longer exist are skipped.
+    std::ofstream out(dump, std::ios::app);
+    out << "1 test.16.missing\n";
+  }
+
+  // A pool with room for everything loads all resident pages, which are
+  // then served without reading the file.
+  BufMgr loadMgr(num_pages);
+  if (loadMgr.loadResidentPages(dump, 4) != 10) {
+    PRINT_ERROR("ERROR :: WARM-UP LOADED WRONG NUMBER OF PAGES");
+  }
+  loadMgr.clearBufStats();
+  for (i = 10; i < num_pages; i++) {
+    loadMgr.readPage(file16, pid[i], page);
+    sprintf(tmpbuf, "test.16 Page %u %7.1f", pid[i], (float)pid[i]);
+    if (strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) !=
+        0) {
+      PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+    }
+    loadMgr.unPinPage(file16, pid[i], false);
+  }
+  if (loadMgr.getBufStats().diskreads != 0) {
+    PRINT_ERROR("ERROR :: WARMED-UP PAGES WERE READ AGAIN");
+  }
+  loadMgr.flushFile(file16);
+
+  // A smaller pool keeps only the hottest pages.
+  BufMgr smallMgr(4);
+  if (smallMgr.loadResidentPages(dump) != 4) {
+    PRINT_ERROR("ERROR :: WARM-UP OVERFILLED THE POOL");
+  }
+  smallMgr.clearBufStats();
+  for (i = num_pages - 4; i < num_pages; i++) {
+    smallMgr.readPage(file16, pid[i], page);
+    smallMgr.unPinPage(file16, pid[i], false);
+  }
+  if (smallMgr.getBufStats().diskreads != 0) {
+    PRINT_ERROR("ERROR :: WARM-UP DID NOT KEEP THE HOTTEST PAGES");
+  }
+  smallMgr.flushFile(file16);
+  std::remove(dump.c_str());
+
+  std::cout << "Test 16 passed"
+            << "\n";
+}
+
+void test17(File &file17) {
+  // Each hot page holds one record of two counters that writers always
+  // increment together, so readers must never see them differ.
+  BufMgr latchMgr(16);
+  const int num_hot = 4;
+  PageId hot[num_hot];
+  RecordId counters[num_hot];
+  const std::string zero(2 * sizeof(std::uint64_t), '\0');
+  for (int h = 0; h < num_hot; h++) {
+    latchMgr.allocPage(file17, hot[h], page);
+    counters[h] = page->insertRecord(zero);
+    latchMgr.unPinPage(file17, hot[h], true);
+  }
+
+  // Optimistic reads of a pinned page fail once a writer intervenes.
+  latchMgr.readPage(file17, hot[0], page);
+  const std::uint64_t version = latchMgr.pageVersion(page);
+  if (!latchMgr.validatePage(page, version)) {
+    PRINT_ERROR("ERROR :: UNCHANGED PAGE FAILED VALIDATION");
+  }
+  Page *written;
+  latchMgr.readPage(file17, hot[0], written, LatchMode::EXCLUSIVE);
+  latchMgr.unPinPage(file17, hot[0], false, LatchMode::EXCLUSIVE);
+  if (latchMgr.validatePage(page, version)) {
+    PRINT_ERROR("ERROR :: CHANGED PAGE PASSED VALIDATION");
+  }
+  latchMgr.unPinPage(file17, hot[0], false);
+
+  // Contention benchmark: 90% shared reads, 10% exclusive updates.
+  const int num_threads = 8;
+  const int ops_per_thread = 20000;
+  std::vector<int> writes(num_threads, 0);
+  std::vector<std::thread> workers;
+  const auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < num_threads; t++) {
+    workers.emplace_back([&, t]() {
+      unsigned int seed = t;
+      for (int op = 0; op < ops_per_thread; op++) {
+        const int h = rand_r(&seed) % num_hot;
+        const bool write = rand_r(&seed) % 10 == 0;
+        Page *hot_page;
+        latchMgr.readPage(file17, hot[h], hot_page,
+                          write ? LatchMode::EXCLUSIVE : LatchMode::SHARED);
+        std::string record = hot_page->getRecord(counters[h]);
+        std::uint64_t values[2];
+        memcpy(values, record.data(), sizeof(values));
+        if (values[0] != values[1]) {
+          PRINT_ERROR("ERROR :: READER SAW A PARTIAL UPDATE");
+        }
+        if (write) {
+          values[0]++;
+          values[1]++;
+          record.assign(reinterpret_cast<const char *>(values),
+                        sizeof(values));
+          hot_page->updateRecord(counters[h], record);
+          writes[t]++;
+        }
+        latchMgr.unPinPage(file17, hot[h], write,
+                           write ? LatchMode::EXCLUSIVE : LatchMode::SHARED);
+      }
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+  std::uint64_t total = 0;
+  for (int h = 0; h < num_hot; h++) {
+    latchMgr.readPage(file17, hot[h], page, LatchMode::SHARED);
+    std::uint64_t values[2];
+    memcpy(values, page->getRecord(counters[h]).data(), sizeof(values));
+    total += values[0];
+    latchMgr.unPinPage(file17, hot[h], false, LatchMode::SHARED);
+  }
+  int expected = 0;
+  for (int t = 0; t < num_threads; t++) {
+    expected += writes[t];
+  }
+  if (total != (std::uint64_t)expected) {
+    PRINT_ERROR("ERROR :: CONCURRENT UPDATES WERE LOST");
+  }
+  latchMgr.flushFile(file17);
+
+  std::cout << "90/10 read/write mix on " << num_hot << " hot pages, "
+            << num_threads << " threads: "
+            << (long)(num_threads * ops_per_thread / seconds) << " ops/s"
+            << "\n";
+  std::cout << "Test 17 passed"
+            << "\n";
+}
+
+void test18(File &file18) {
+  BufMgr olcMgr(8);
+  PageId root;
+  const std::string zero(2 * sizeof(std::uint64_t), '\0');
+  olcMgr.allocPage(file18, root, page);
+  const RecordId counter = page->insertRecord(zero);
+  olcMgr.unPinPage(file18, root, true);
+
+  // A handle stays valid until the page is written or leaves its frame.
+  PageHandle handle = olcMgr.readHandle(file18, root);
+  if (!olcMgr.validate(handle)) {
+    PRINT_ERROR("ERROR :: FRESH HANDLE FAILED VALIDATION");
+  }
+  olcMgr.readPage(file18, root, page, LatchMode::EXCLUSIVE);
+  olcMgr.unPinPage(file18, root, false, LatchMode::EXCLUSIVE);
+  if (olcMgr.validate(handle)) {
+    PRINT_ERROR("ERROR :: HANDLE SURVIVED A WRITE");
+  }
+  handle = olcMgr.readHandle(file18, root);
+  olcMgr.flushFile(file18);
+  if (olcMgr.validate(handle)) {
+    PRINT_ERROR("ERROR :: HANDLE SURVIVED EVICTION");
+  }
+
+  // Repeated optimistic reads do not touch the pool's shared state.
+  auto readCounters = [&counter](const Page &p) {
+    std::uint64_t values[2];
+    memcpy(values, p.getRecord(counter).data(), sizeof(values));
+    return std::make_pair(values[0], values[1]);
+  };
+  OptimisticReader reader(&olcMgr, &file18, root);
+  reader.read(readCounters);
+  olcMgr.clearBufStats();
+  for (int r = 0; r < 100; r++) {
+    reader.read(readCounters);
+  }
+  if (olcMgr.getBufStats().accesses != 0) {
+    PRINT_ERROR("ERROR :: OPTIMISTIC READS PINNED THE PAGE");
+  }
+
+  // Readers racing with writers only ever return consistent counters.
+  const int num_writes = 2000;
+  std::vector<std::thread> workers;
+  workers.emplace_back([&]() {
+    for (int w = 0; w < num_writes; w++) {
+      Page *root_page;
+      olcMgr.readPage(file18, root, root_page, LatchMode::EXCLUSIVE);
+      std::uint64_t values[2];
+      memcpy(values, root_page->getRecord(counter).data(), sizeof(values));
+      values[0]++;
+      values[1]++;
+      root_page->updateRecord(
+          counter,
+          std::string(reinterpret_cast<const char *>(values), sizeof(values)));
+      olcMgr.unPinPage(file18, root, true, LatchMode::EXCLUSIVE);
+    }
+  });
+  for (int t = 0; t < 3; t++) {
+    workers.emplace_back([&]() {
+      OptimisticReader thread_reader(&olcMgr, &file18, root);
+      std::uint64_t last = 0;
+      for (int r = 0; r < 20000; r++) {
+        const std::pair<std::uint64_t, std::uint64_t> values =
+            thread_reader.read(readCounters);
+        if (values.first != values.second || values.first < last) {
+          PRINT_ERROR("ERROR :: OPTIMISTIC READ RETURNED A TORN PAGE");
+        }
+        last = values.first;
+      }
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  if (reader.read(readCounters).first != (std::uint64_t)num_writes) {
+    PRINT_ERROR("ERROR :: UPDATES WERE LOST");
+  }
+  olcMgr.flushFile(file18);
+
+  std::cout << "Test 18 passed"
+            << "\n";
+}
+
+void test19(File &file19) {
+  // A parent page holds swips to three child pages in a pool of four
+  // frames, so reading other pages evicts the children.
+  BufMgr swipMgr(4);
+  const int num_children = 3;
+  PageId parent, children[num_children], others[4];
+  for (int c = 0; c < num_children; c++) {
+    swipMgr.allocPage(file19, children[c], page);
+    sprintf(tmpbuf, "test.19 child %d", c);
+    rid[c] = page->insertRecord(tmpbuf);
+    swipMgr.unPinPage(file19, children[c], true);
+  }
+  for (int o = 0; o < 4; o++) {
+    swipMgr.allocPage(file19, others[o], page);
+    swipMgr.unPinPage(file19, others[o], true);
+  }
+  swipMgr.allocPage(file19, parent, page);
+  FixedPage node =
+      FixedPage::format(page, FixedSchema({sizeof(Swip)}, {0}),
+                        PageType::FIXED_PAX);
+  for (int c = 0; c < num_children; c++) {
+    const Swip child(children[c]);
+    node.insertRecord(
+        std::string(reinterpret_cast<const char *>(&child), sizeof(child)));
+  }
+
+  // Following a swip swizzles it; following it again needs no lookup.
+  Swip *swip = node.swip(1, 0);
+  swipMgr.fixSwip(file19, page, *swip, page2);
+  if (!swip->isSwizzled() || swipMgr.swipPageNumber(*swip) != children[0]) {
+    PRINT_ERROR("ERROR :: SWIP WAS NOT SWIZZLED");
+  }
+  swipMgr.unPinPage(file19, children[0], false);
+  swipMgr.fixSwip(file19, page, *swip, page3, LatchMode::SHARED);
+  if (page3 != page2 ||
+      page3->getRecord(rid[0]).compare(0, 15, "test.19 child 0") != 0) {
+    PRINT_ERROR("ERROR :: SWIZZLED SWIP LED TO THE WRONG PAGE");
+  }
+  swipMgr.unPinPage(file19, children[0], false, LatchMode::SHARED);
+
+  // Accessors copying values out see the page number, not the frame.
+  const RecordId first_row{parent, 1};
+  std::vector<SlotId> selected;
+  PageId restored;
+  std::memcpy(&restored, node.getRecord(first_row).data(), sizeof(restored));
+  if (restored != children[0] ||
+      node.value<PageId>(1, 0) != children[0] ||
+      node.selectColumn<PageId>(0, CompareOp::EQ, children[0], selected) !=
+          1 ||
+      selected[0] != 1) {
+    PRINT_ERROR("ERROR :: ACCESSOR RETURNED A SWIZZLED SWIP");
+  }
+
+  // Overwriting a swizzled row forgets the swip, so evicting its old target
+  // leaves the new value alone.
+  const Swip replacement(children[2]);
+  node.updateRecord(first_row,
+                    std::string(reinterpret_cast<const char *>(&replacement),
+                                sizeof(replacement)));
+  if (swip->isSwizzled()) {
+    PRINT_ERROR("ERROR :: UPDATED SWIP IS STILL SWIZZLED");
+  }
+  for (int o = 0; o < 4; o++) {
+    swipMgr.readPage(file19, others[o], page2);
+    swipMgr.unPinPage(file19, others[o], false);
+  }
+  if (node.value<PageId>(1, 0) != children[2]) {
+    PRINT_ERROR("ERROR :: EVICTION OVERWROTE AN UPDATED SWIP");
+  }
+  const Swip original(children[0]);
+  node.updateRecord(first_row,
+                    std::string(reinterpret_cast<const char *>(&original),
+                                sizeof(original)));
+
+  // Deleting a swizzled row forgets the swip as well.
+  const RecordId third_row{parent, 3};
+  swipMgr.fixSwip(file19, page, *node.swip(3, 0), page2);
+  swipMgr.unPinPage(file19, children[2], false);
+  node.deleteRecord(third_row);
+  std::uint32_t deleted;
+  std::memcpy(&deleted, node.column_base(0) + 2 * sizeof(Swip),
+              sizeof(deleted));
+  if ((deleted & Swip::SWIZZLED_BIT) != 0) {
+    PRINT_ERROR("ERROR :: DELETED SWIP IS STILL SWIZZLED");
+  }
+  node.insertRecord(std::string(reinterpret_cast<const char *>(&replacement),
+                                sizeof(replacement)));
+  swipMgr.fixSwip(file19, page, *swip, page2);
+  swipMgr.unPinPage(file19, children[0], false);
+
+  // Evicting the child unswizzles the swip.
+  for (int o = 0; o < 4; o++) {
+    swipMgr.readPage(file19, others[o], page2);
+    swipMgr.unPinPage(file19, others[o], false);
+  }
+  if (swip->isSwizzled() || swip->page_number() != children[0]) {
+    PRINT_ERROR("ERROR :: SWIP NOT UNSWIZZLED ON EVICTION");
+  }
+
+  // Swips of a page being written back are unswizzled first.
+  swipMgr.fixSwip(file19, page, *node.swip(2, 0), page2);
+  swipMgr.unPinPage(file19, children[1], false);
+  swipMgr.unPinPage(file19, parent, true);
+  swipMgr.flushFile(file19);
+  swipMgr.readPage(file19, parent, page);
+  FixedPage stored(page);
+  for (int c = 0; c < num_children; c++) {
+    if (stored.swip(c + 1, 0)->isSwizzled() ||
+        stored.swip(c + 1, 0)->page_number() != children[c]) {
+      PRINT_ERROR("ERROR :: SWIZZLED SWIP WAS WRITTEN TO DISK");
+    }
+  }
+  swipMgr.unPinPage(file19, parent, false);
+  swipMgr.flushFile(file19);
+
+  std::cout << "Test 19 passed"
+            << "\n";
+}
+
+// Coroutine type that starts eagerly and frees itself when done.
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return DetachedTask(); }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// Fetches a page of test.20, checks its record and unpins it.
+static DetachedTask fetchAndCheck(AsyncPageReader &reader, File &file20,
+                                  const PageId page_number,
+                                  const RecordId record_id,
+                                  std::atomic<int> &done) {
+  Page *fetched = co_await reader.fetch(file20, page_number, LatchMode::SHARED);
+  char expected[100];
+  sprintf(expected, "test.20 Page %u %7.1f", page_number, (float)page_number);
+  if (strncmp(fetched->getRecord(record_id).c_str(), expected,
+              strlen(expected)) != 0) {
+    PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+  }
+  bufMgr->unPinPage(file20, page_number, false, LatchMode::SHARED);
+  done++;
+}
+
+// Fetches a resident page and records whether the coroutine stayed on the
+// calling thread.
+static DetachedTask fetchResident(AsyncPageReader &reader, File &file20,
+                                  const PageId page_number, bool &same_thread) {
+  const std::thread::id before = std::this_thread::get_id();
+  co_await reader.fetch(file20, page_number);
+  same_thread = std::this_thread::get_id() == before;
+  bufMgr->unPinPage(file20, page_number, false);
+}
+
+// Fetches a page that does not exist and counts the error.
+static DetachedTask fetchMissing(AsyncPageReader &reader, File &file20,
+                                 const PageId page_number,
+                                 std::atomic<int> &errors) {
+  try {
+    co_await reader.fetch(file20, page_number);
+  } catch (const InvalidPageException &e) {
+    errors++;
+  }
+}
+
+void test20(File &file20) {
+  const PageId num_pages = 40;
+  for (i = 0; i < num_pages; i++) {
+    bufMgr->allocPage(file20, pid[i], page);
+    sprintf(tmpbuf, "test.20 Page %u %7.1f", pid[i], (float)pid[i]);
+    rid[i] = page->insertRecord(tmpbuf);
+    bufMgr->unPinPage(file20, pid[i], true);
+  }
+  bufMgr->flushFile(file20);
+
+  {
+    Executor io(4);
+    Executor scheduler(2);
+    AsyncPageReader reader(bufMgr.get(), &io, &scheduler);
+
+    // Many concurrent fetches, most of them misses at first.
+    const int num_fetches = 400;
+    std::atomic<int> done(0);
+    for (int f = 0; f < num_fetches; f++) {
+      const PageId p = f % num_pages;
+      fetchAndCheck(reader, file20, pid[p], rid[p], done);
+    }
+    while (done < num_fetches) {
+      std::this_thread::yield();
+    }
+
+    // Hits complete without suspending.
+    bool same_thread = false;
+    fetchResident(reader, file20, pid[0], same_thread);
+    if (!same_thread) {
+      PRINT_ERROR("ERROR :: FETCH OF A RESIDENT PAGE SUSPENDED");
+    }
+
+    // A page latched exclusively suspends the fetch instead of blocking the
+    // calling thread; the fetch completes once the latch is released.
+    bufMgr->readPage(file20, pid[1], page, LatchMode::EXCLUSIVE);
+    std::atomic<int> latched_done(0);
+    fetchAndCheck(reader, file20, pid[1], rid[1], latched_done);
+    if (latched_done != 0) {
+      PRINT_ERROR("ERROR :: FETCH DID NOT WAIT FOR THE LATCH");
+    }
+    bufMgr->unPinPage(file20, pid[1], false, LatchMode::EXCLUSIVE);
+    while (latched_done == 0) {
+      std::this_thread::yield();
+    }
+
+    // Read errors surface at the co_await.
+    std::atomic<int> errors(0);
+    fetchMissing(reader, file20, 10000, errors);
+    while (errors == 0) {
+      std::this_thread::yield();
+    }
+  }
+  bufMgr->flushFile(file20);
+
+  std::cout << "Test 20 passed"
+            << "\n";
+}
+
+// Looks up <keys> one at a time and returns lookups per second.
+static double lookupOneAtATime(BufMgr &lookupMgr, File &file21,
+                               const std::vector<PageId> &keys,
+                               const std::vector<RecordId> &records,
+                               std::uint64_t &checksum) {
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t k = 0; k < keys.size(); k++) {
+    Page *looked_up;
+    lookupMgr.readPage(file21, keys[k], looked_up);
+    checksum += looked_up->getRecord(records[keys[k]]).size();
+    lookupMgr.unPinPage(file21, keys[k], false);
+  }
+  return keys.size() / std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+}
+
+// Looks up <keys> with a BatchLookup and returns lookups per second.
+static double lookupBatched(BatchLookup &batch, File &file21,
+                            const std::vector<PageId> &keys,
+                            const std::vector<RecordId> &records,
+                            std::uint64_t &checksum) {
+  const auto start = std::chrono::steady_clock::now();
+  batch.run(file21, keys, [&](std::size_t k, const Page &looked_up) {
+    checksum += looked_up.getRecord(records[keys[k]]).size();
+  });
+  return keys.size() / std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+}
+
+void test21(File &file21) {
+  // Page numbers start at 1, so records are indexed by page number.
+  const PageId num_pages = 200;
+  std::vector<RecordId> records(num_pages + 1);
+  {
+    BufMgr loadMgr(16);
+    for (i = 1; i <= num_pages; i++) {
+      PageId page_number;
+      loadMgr.allocPage(file21, page_number, page);
+      sprintf(tmpbuf, "test.21 Page %u %7.1f", page_number,
+              (float)page_number);
+      records[page_number] = page->insertRecord(tmpbuf);
+      loadMgr.unPinPage(file21, page_number, true);
+    }
+    loadMgr.flushFile(file21);
+  }
+
+  std::vector<PageId> keys(20000);
+  unsigned int seed = 21;
+  for (std::size_t k = 0; k < keys.size(); k++) {
+    keys[k] = 1 + rand_r(&seed) % num_pages;
+  }
+
+  // Every key is processed exactly once, with its own page.
+  {
+    BufMgr lookupMgr(32);
+    Executor io(4);
+    BatchLookup batch(&lookupMgr, &io);
+    std::vector<int> seen(keys.size(), 0);
+    batch.run(file21, keys, [&](std::size_t k, const Page &looked_up) {
+      sprintf(tmpbuf, "test.21 Page %u %7.1f", keys[k], (float)keys[k]);
+      if (looked_up.page_number() != keys[k] ||
+          strncmp(looked_up.getRecord(records[keys[k]]).c_str(), tmpbuf,
+                  strlen(tmpbuf)) != 0) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+      seen[k]++;
+    });
+    for (std::size_t k = 0; k < keys.size(); k++) {
+      if (seen[k] != 1) {
+        PRINT_ERROR("ERROR :: KEY NOT PROCESSED EXACTLY ONCE");
+      }
+    }
+    if (batch.hits() + batch.misses() != keys.size() || batch.misses() == 0 ||
+        batch.hits() == 0) {
+      PRINT_ERROR("ERROR :: HITS AND MISSES MISCOUNTED");
+    }
+
+    // A failed read is rethrown once the rest of its group is released.
+    std::vector<PageId> bad(keys.begin(), keys.begin() + 10);
+    bad[5] = 10000;
+    try {
+      batch.run(file21, bad, [](std::size_t, const Page &) {});
+      PRINT_ERROR("ERROR :: No exception thrown for invalid page");
+    } catch (const InvalidPageException &e) {
+    }
+    // Throws PagePinnedException if a page were left pinned.
+    lookupMgr.flushFile(file21);
+  }
+
+  // Benchmarks: all keys resident, then a pool a sixth of the file.  The
+  // batched lookups run on the calling thread and with an I/O executor.
+  const std::size_t pool_sizes[] = {num_pages + 56, 32};
+  for (const std::size_t pool_size : pool_sizes) {
+    BufMgr lookupMgr(pool_size);
+    Executor io(4);
+    BatchLookup batch(&lookupMgr, NULL);
+    BatchLookup async_batch(&lookupMgr, &io);
+    std::uint64_t single_sum = 0, batch_sum = 0, async_sum = 0;
+    if (pool_size > num_pages) {
+      lookupOneAtATime(lookupMgr, file21, keys, records, single_sum);
+      single_sum = 0;
+    }
+    const double single =
+        lookupOneAtATime(lookupMgr, file21, keys, records, single_sum);
+    const double batched =
+        lookupBatched(batch, file21, keys, records, batch_sum);
+    const double async_batched =
+        lookupBatched(async_batch, file21, keys, records, async_sum);
+    if (single_sum != batch_sum || single_sum != async_sum) {
+      PRINT_ERROR("ERROR :: BATCHED LOOKUPS READ DIFFERENT RECORDS");
+    }
+    lookupMgr.flushFile(file21);
+    std::cout << keys.size() << " lookups, " << pool_size << " frames: "
+              << (long)single << " lookups/s one at a time, " << (long)batched
+              << " batched, " << (long)async_batched
+              << " batched with I/O threads"
+              << "\n";
+  }
+
+  std::cout << "Test 21 passed"
+            << "\n";
+}
+
+void test22(File &file22) {
+  const PageId num_pages = 50;
+  for (i = 0; i < num_pages; i++) {
+    Page new_page = file22.allocatePage();
+    sprintf(tmpbuf, "test.22 Page %u %7.1f", new_page.page_number(),
+            (float)new_page.page_number());
+    new_page.insertRecord(tmpbuf);
+    file22.writePage(new_page);
+  }
+
+  // Copies own their data; moves hand it over.
+  Page first = file22.readPage(1);
+  Page copy = first;
+  copy.insertRecord("only in the copy");
+  if (first.getFreeSpace() == copy.getFreeSpace()) {
+    PRINT_ERROR("ERROR :: COPY SHARED ITS DATA WITH THE ORIGINAL");
+  }
+  Page moved = std::move(copy);
+  copy = first;
+  if (moved.getFreeSpace() >= first.getFreeSpace() ||
+      copy.getFreeSpace() != first.getFreeSpace()) {
+    PRINT_ERROR("ERROR :: MOVE OR ASSIGNMENT LOST DATA");
+  }
+
+  // After the first walk, walks and reads reuse the same buffers.
+  const std::size_t walks = 20;
+  std::size_t allocations = 0;
+  for (std::size_t w = 0; w < walks; w++) {
+    if (w == 1) {
+      allocations = PageBufferPool::allocations();
+    }
+    PageId seen = 0;
+    for (FileIterator iter = file22.begin(); iter != file22.end(); ++iter) {
+      const Page walked = *iter;
+      sprintf(tmpbuf, "test.22 Page %u %7.1f", walked.page_number(),
+              (float)walked.page_number());
+      if (strncmp(walked.getRecord(RecordId{walked.page_number(), 1}).c_str(),
+                  tmpbuf, strlen(tmpbuf)) != 0) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+      seen++;
+    }
+    if (seen != num_pages) {
+      PRINT_ERROR("ERROR :: WALK MISSED PAGES");
+    }
+    for (i = 1; i <= num_pages; i++) {
+      file22.readPage(i);
+    }
+  }
+  if (PageBufferPool::allocations() != allocations) {
+    PRINT_ERROR("ERROR :: TRANSIENT PAGES ALLOCATED NEW BUFFERS");
+  }
+  if (PageBufferPool::cached() == 0 ||
+      PageBufferPool::cached() > PageBufferPool::MAX_CACHED) {
+    PRINT_ERROR("ERROR :: BUFFER CACHE SIZE OUT OF RANGE");
+  }
+
+  std::cout << "Test 22 passed"
+            << "\n";
+}
+
+void test23(File &file23) {
+  // Fill recycled buffers with a page full of records.
+  Page full = file23.allocatePage();
+  const PageId full_number = full.page_number();
+  std::string record(100, 'x');
+  while (full.hasSpaceForRecord(record)) {
+    full.insertRecord(record);
+  }
+  file23.writePage(full);
+  for (i = 0; i < 10; i++) {
+    file23.readPage(full_number);
+  }
+
+  // Pages read into those buffers are exactly what is on disk.
+  Page empty = file23.allocatePage();
+  Page read_back = file23.readPage(empty.page_number());
+  if (read_back.getFreeSpace() != Page().getFreeSpace() ||
+      read_back.begin() != read_back.end()) {
+    PRINT_ERROR("ERROR :: READ PAGE KEPT STALE CONTENTS");
+  }
+
+  // Freshly allocated and reused pages still start out empty.
+  file23.deletePage(full_number);
+  Page reused = file23.allocatePage();
+  if (reused.page_number() != full_number ||
+      reused.getFreeSpace() != Page().getFreeSpace() ||
+      reused.begin() != reused.end()) {
+    PRINT_ERROR("ERROR :: ALLOCATED PAGE WAS NOT EMPTY");
+  }
+  Page on_disk = file23.readPage(full_number);
+  if (on_disk.begin() != on_disk.end()) {
+    PRINT_ERROR("ERROR :: REUSED PAGE ON DISK WAS NOT EMPTY");
+  }
+
+  std::cout << "Test 23 passed"
+            << "\n";
+}
+
+// Returns the size of the named file on disk, or -1 if it does not exist.
+static long long diskSize(const std::string &filename) {
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) {
+    return -1;
+  }
+  return st.st_size;
+}
+
+void test24(File &file24) {
+  // Files grow by whole extents.
+  const long long header_size = sizeof(FileHeader);
+  const long long extent_size = File::EXTENT_PAGES * Page::SIZE;
+  file24.allocatePage();
+  if (diskSize("test.24") != header_size + extent_size) {
+    PRINT_ERROR("ERROR :: FILE DID NOT GROW BY AN EXTENT");
+  }
+  for (i = 1; i <= File::EXTENT_PAGES; i++) {
+    file24.allocatePage();
+  }
+  if (diskSize("test.24") != header_size + 2 * extent_size) {
+    PRINT_ERROR("ERROR :: FILE DID NOT GROW BY A SECOND EXTENT");
+  }
+
+  // Segmented files are used through the buffer manager as usual.
+  const std::string segmented_name = "test.24.segmented";
+  const PageId segment_pages = 8;
+  const PageId num_pages = 30;
+  try {
+    File::remove(segmented_name);
+  } catch (const FileNotFoundException &e) {
+  }
+  {
+    File segmented = File::create(segmented_name, segment_pages);
+    for (i = 0; i < num_pages; i++) {
+      bufMgr->allocPage(segmented, pid[i], page);
+      sprintf(tmpbuf, "test.24 Page %u %7.1f", pid[i], (float)pid[i]);
+      rid[i] = page->insertRecord(tmpbuf);
+      bufMgr->unPinPage(segmented, pid[i], true);
+    }
+    bufMgr->flushFile(segmented);
+
+    // Deleted pages in later segments are reused.
+    segmented.deletePage(pid[20]);
+    bufMgr->allocPage(segmented, pid[20], page);
+    sprintf(tmpbuf, "test.24 Page %u %7.1f", pid[20], (float)pid[20]);
+    rid[20] = page->insertRecord(tmpbuf);
+    bufMgr->unPinPage(segmented, pid[20], true);
+    bufMgr->flushFile(segmented);
+  }
+  for (std::size_t segment = 1; segment < num_pages / segment_pages + 1;
+       segment++) {
+    const long long size =
+        diskSize(segmented_name + "." + std::to_string(segment));
+    if (size <= 0 || size > (long long)(segment_pages * Page::SIZE)) {
+      PRINT_ERROR("ERROR :: SEGMENT FILE HAS THE WRONG SIZE");
+    }
+  }
+  if (diskSize(segmented_name) !=
+      header_size + (long long)(segment_pages * Page::SIZE)) {
+    PRINT_ERROR("ERROR :: FIRST SEGMENT HAS THE WRONG SIZE");
+  }
+
+  {
+    File segmented = File::open(segmented_name);
+    if (segmented.segment_pages() != segment_pages) {
+      PRINT_ERROR("ERROR :: SEGMENT SIZE WAS NOT STORED");
+    }
+    PageId seen = 0;
+    for (FileIterator iter = segmented.begin(); iter != segmented.end();
+         ++iter) {
+      seen++;
+    }
+    if (seen != num_pages) {
+      PRINT_ERROR("ERROR :: SCAN OF SEGMENTED FILE MISSED PAGES");
+    }
+    for (i = 0; i < num_pages; i++) {
+      bufMgr->readPage(segmented, pid[i], page);
+      sprintf(tmpbuf, "test.24 Page %u %7.1f", pid[i], (float)pid[i]);
+      if (strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) !=
+          0) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+      bufMgr->unPinPage(segmented, pid[i], false);
+      Page read_back = segmented.preadPage(pid[i]);
+      if (strncmp(read_back.getRecord(rid[i]).c_str(), tmpbuf,
+                  strlen(tmpbuf)) != 0) {
+        PRINT_ERROR("ERROR :: PREAD DID NOT FIND THE PAGE");
+      }
+    }
+    bufMgr->flushFile(segmented);
+  }
+
+  File::remove(segmented_name);
+  if (diskSize(segmented_name + ".1") != -1) {
+    PRINT_ERROR("ERROR :: SEGMENT FILES WERE NOT REMOVED");
+  }
+
+  // Removing a file that is not segmented leaves files that merely look
+  // like its segments alone.
+  const std::string plain_name = "test.24.plain";
+  { File::create(plain_name); }
+  { std::ofstream(plain_name + ".1") << "unrelated"; }
+  File::remove(plain_name);
+  if (diskSize(plain_name) != -1 || diskSize(plain_name + ".1") <= 0) {
+    PRINT_ERROR("ERROR :: UNRELATED FILE WAS REMOVED WITH A PLAIN FILE");
+  }
+  std::remove((plain_name + ".1").c_str());
+
+  std::cout << "Test 24 passed"
+            << "\n";
+}
+
+// Scans file25 <passes> times and returns pages scanned per second.
+static double scanRate(File &file25, const int passes) {
+  std::size_t scanned = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int p = 0; p < passes; p++) {
+    for (FileIterator iter = file25.begin(); iter != file25.end(); ++iter) {
+      scanned += (*iter).getFreeSpace() > 0;
+    }
+  }
+  return scanned / std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+}
+
+void test25(File &file25) {
+  const PageId num_pages = 400;
+  std::vector<PageId> pages(num_pages);
+  for (i = 0; i < num_pages; i++) {
+    bufMgr->allocPage(file25, pages[i], page);
+    sprintf(tmpbuf, "test.25 Page %u", pages[i]);
+    page->insertRecord(tmpbuf);
+    bufMgr->unPinPage(file25, pages[i], true);
+  }
+  bufMgr->flushFile(file25);
+  const double fresh = scanRate(file25, 10);
+
+  // Churn: delete most pages, then reuse a few of the holes.
+  unsigned int seed = 25;
+  std::map<PageId, std::string> expected;
+  for (i = 0; i < num_pages; i++) {
+    if (rand_r(&seed) % 10 < 7) {
+      bufMgr->disposePage(file25, pages[i]);
+    } else {
+      sprintf(tmpbuf, "test.25 Page %u", pages[i]);
+      expected[pages[i]] = tmpbuf;
+    }
+  }
+  for (i = 0; i < 20; i++) {
+    PageId reused;
+    bufMgr->allocPage(file25, reused, page);
+    sprintf(tmpbuf, "test.25 Reused %u", i);
+    page->insertRecord(tmpbuf);
+    expected[reused] = tmpbuf;
+    bufMgr->unPinPage(file25, reused, true);
+  }
+  const double churned = scanRate(file25, 10);
+
+  // Compaction refuses to run while a page is pinned.
+  const PageId first = expected.begin()->first;
+  bufMgr->readPage(file25, first, page);
+  try {
+    bufMgr->compactFile(file25);
+    PRINT_ERROR("ERROR :: No exception thrown for pinned page");
+  } catch (const PagePinnedException &e) {
+  }
+  bufMgr->unPinPage(file25, first, false);
+
+  const long long churned_size = diskSize("test.25");
+  const std::map<PageId, PageId> moved = bufMgr->compactFile(file25);
+  const double compacted = scanRate(file25, 10);
+
+  // Used pages are 1..n in order, with their contents at the forwarded
+  // numbers, and the file shrank.
+  PageId next = 1;
+  for (FileIterator iter = file25.begin(); iter != file25.end(); ++iter) {
+    if ((*iter).page_number() != next++) {
+      PRINT_ERROR("ERROR :: COMPACTED FILE IS NOT IN PAGE ORDER");
+    }
+  }
+  if (next - 1 != expected.size()) {
+    PRINT_ERROR("ERROR :: COMPACTION LOST OR ADDED PAGES");
+  }
+  for (std::map<PageId, std::string>::const_iterator it = expected.begin();
+       it != expected.end(); ++it) {
+    std::map<PageId, PageId>::const_iterator forward = moved.find(it->first);
+    const PageId now = forward == moved.end() ? it->first : forward->second;
+    if (now > expected.size()) {
+      PRINT_ERROR("ERROR :: PAGE LEFT PAST THE END OF THE FILE");
+    }
+    bufMgr->readPage(file25, now, page);
+    if (page->getRecord(RecordId{now, 1}) != it->second) {
+      PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+    }
+    bufMgr->unPinPage(file25, now, false);
+  }
+  if (diskSize("test.25") !=
+          (long long)(sizeof(FileHeader) + expected.size() * Page::SIZE) ||
+      diskSize("test.25") >= churned_size) {
+    PRINT_ERROR("ERROR :: FILE WAS NOT TRUNCATED");
+  }
+
+  // The compacted file grows again as usual.
+  PageId appended;
+  bufMgr->allocPage(file25, appended, page);
+  if (appended != expected.size() + 1) {
+    PRINT_ERROR("ERROR :: PAGE NOT APPENDED AFTER COMPACTION");
+  }
+  bufMgr->unPinPage(file25, appended, true);
+  bufMgr->flushFile(file25);
+
+  // Compacting a segmented file removes the segments it no longer needs.
+  const std::string segmented_name = "test.25.segmented";
+  try {
+    File::remove(segmented_name);
+  } catch (const FileNotFoundException &e) {
+  }
+  {
+    File segmented = File::create(segmented_name, 8);
+    for (i = 1; i <= 30; i++) {
+      segmented.allocatePage();
+    }
+    for (i = 3; i <= 30; i++) {
+      if (i != 29) {
+        segmented.deletePage(i);
+      }
+    }
+    const std::map<PageId, PageId> forwarded = segmented.compact();
+    if (forwarded.size() != 1 || forwarded.at(29) != 3 ||
+        segmented.readPage(3).page_number() != 3) {
+      PRINT_ERROR("ERROR :: SEGMENTED PAGE NOT FORWARDED");
+    }
+  }
+  if (diskSize(segmented_name + ".1") != -1 ||
+      diskSize(segmented_name) !=
+          (long long)(sizeof(FileHeader) + 3 * Page::SIZE)) {
+    PRINT_ERROR("ERROR :: SEGMENTS WERE NOT TRUNCATED");
+  }
+  File::remove(segmented_name);
+
+  std::cout << "Scan of " << num_pages << " pages: "
+            << (long)fresh << " pages/s fresh, " << (long)churned
+            << " pages/s after churn, " << (long)compacted
+            << " pages/s compacted"
+            << "\n";
+  std::cout << "Test 25 passed"
+            << "\n";
+}
+
+void test26(File &file26) {
+  // Dense pages stay as they are; sparse pages lose 85% of their records.
+  const PageId num_dense = 5;
+  const PageId num_pages = 60;
+  const std::string filler(150, '.');
+  std::map<std::pair<PageId, SlotId>, std::string> records;
+  // Every third record carries a slot flag, which must move with it.
+  std::set<std::string> flagged;
+  std::vector<PageId> pages(num_pages);
+  unsigned int seed = 26;
+  for (i = 0; i < num_pages; i++) {
+    bufMgr->allocPage(file26, pages[i], page);
+    std::vector<std::pair<RecordId, std::string>> inserted;
+    for (int r = 0;; r++) {
+      sprintf(tmpbuf, "test.26 Page %u Record %d ", pages[i], r);
+      const std::string record = tmpbuf + filler;
+      if (!page->hasSpaceForRecord(record)) {
+        break;
+      }
+      const std::uint8_t flags = r % 3 == 0 ? PageSlot::OVERFLOW_POINTER : 0;
+      if (flags != 0) {
+        flagged.insert(record);
+      }
+      inserted.push_back(
+          std::make_pair(page->insertRecord(record, flags), record));
+    }
+    for (const std::pair<RecordId, std::string> &entry : inserted) {
+      if (i < num_dense || rand_r(&seed) % 100 < 15) {
+        records[std::make_pair(entry.first.page_number,
+                               entry.first.slot_number)] = entry.second;
+      } else {
+        page->deleteRecord(entry.first);
+      }
+    }
+    bufMgr->unPinPage(file26, pages[i], true);
+  }
+
+  // Readers keep using the dense pages while the vacuum runs, and scan the
+  // sparse pages it moves records between and frees.
+  std::atomic<bool> vacuuming(true);
+  std::atomic<std::size_t> sparse_reads(0);
+  std::thread reader([&]() {
+    unsigned int reader_seed = 260;
+    while (vacuuming) {
+      const PageId dense = pages[rand_r(&reader_seed) % num_dense];
+      Page *dense_page;
+      bufMgr->readPage(file26, dense, dense_page, LatchMode::SHARED);
+      if (dense_page->getFreeSpace() > Page::DATA_SIZE / 2) {
+        PRINT_ERROR("ERROR :: DENSE PAGE CHANGED");
+      }
+      bufMgr->unPinPage(file26, dense, false, LatchMode::SHARED);
+
+      const PageId sparse =
+          pages[num_dense + rand_r(&reader_seed) % (num_pages - num_dense)];
+      Page *sparse_page;
+      try {
+        bufMgr->readPage(file26, sparse, sparse_page, LatchMode::SHARED);
+      } catch (const InvalidPageException &) {
+        // Freed by the vacuum already.
+        continue;
+      }
+      for (PageIterator iter = sparse_page->begin();
+           iter != sparse_page->end(); ++iter) {
+        const std::string record = *iter;
+        if (record.compare(0, 13, "test.26 Page ") != 0 ||
+            record.size() <= filler.size()) {
+          PRINT_ERROR("ERROR :: SPARSE PAGE HOLDS A BROKEN RECORD");
+        }
+      }
+      bufMgr->unPinPage(file26, sparse, false, LatchMode::SHARED);
+      sparse_reads++;
+    }
+  });
+
+  // The callback keeps every first record in place and redirects the rest.
+  std::size_t refused = 0;
+  Vacuum vacuum(bufMgr.get(), &file26,
+                [&](const RecordId &from, const RecordId &to) {
+                  const std::pair<PageId, SlotId> key(from.page_number,
+                                                      from.slot_number);
+                  if (records[key].find(" Record 0 ") != std::string::npos) {
+                    refused++;
+                    return false;
+                  }
+                  records[std::make_pair(to.page_number, to.slot_number)] =
+                      records[key];
+                  records.erase(key);
+                  return true;
+                });
+  VacuumReport report;
+  {
+    Executor background(1);
+    background.post([&]() { report = vacuum.run(); });
+  }
+  vacuuming = false;
+  reader.join();
+
+  if (report.pages_scanned != num_pages ||
+      report.sparse_pages != num_pages - num_dense ||
+      report.records_kept != refused || refused == 0 ||
+      report.pages_freed == 0 || sparse_reads == 0 ||
+      report.bytes_reclaimed != report.pages_freed * Page::SIZE) {
+    PRINT_ERROR("ERROR :: VACUUM REPORT IS WRONG");
+  }
+  for (std::map<std::pair<PageId, SlotId>, std::string>::const_iterator it =
+           records.begin();
+       it != records.end(); ++it) {
+    bufMgr->readPage(file26, it->first.first, page);
+    const RecordId rid{it->first.first, it->first.second};
+    if (page->getRecord(rid) != it->second) {
+      PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+    }
+    if (page->getRecordFlags(rid) != (flagged.count(it->second) > 0
+                                          ? PageSlot::OVERFLOW_POINTER
+                                          : 0)) {
+      PRINT_ERROR("ERROR :: SLOT FLAGS WERE NOT MOVED");
+    }
+    bufMgr->unPinPage(file26, it->first.first, false);
+  }
+  PageId remaining = 0;
+  bufMgr->flushFile(file26);
+  for (FileIterator iter = file26.begin(); iter != file26.end(); ++iter) {
+    remaining++;
+  }
+  if (remaining != num_pages - report.pages_freed) {
+    PRINT_ERROR("ERROR :: FREED PAGES ARE STILL IN USE");
+  }
+
+  std::cout << "Vacuum moved " << report.records_moved << " records, freed "
+            << report.pages_freed << " of " << report.sparse_pages
+            << " sparse pages, reclaimed " << report.bytes_reclaimed
+            << " bytes"
+            << "\n";
+  std::cout << "Test 26 passed"
+            << "\n";
+}
+
+// Returns the byte at <offset> of the test.27 value.
+static char overflowByte(const std::size_t offset) {
+  return static_cast<char>('a' + (offset * 7 + offset / 8191) % 26);
+}
+
+void test27(File &file27) {
+  // Pages in front of the value are freed later, so that compaction moves
+  // the value's pages.
+  const PageId num_fillers = 16;
+  std::vector<PageId> fillers(num_fillers);
+  for (i = 0; i < num_fillers; i++) {
+    bufMgr->allocPage(file27, fillers[i], page);
+    bufMgr->unPinPage(file27, fillers[i], true);
+  }
+
+  // Write a value twelve pages long in pieces of varying size.
+  const std::size_t value_length = 12 * Page::SIZE + 123;
+  OverflowPointer pointer;
+  {
+    OverflowWriter writer(bufMgr.get(), &file27);
+    unsigned int seed = 27;
+    std::size_t written = 0;
+    while (written < value_length) {
+      const std::size_t piece = std::min<std::size_t>(
+          1 + rand_r(&seed) % 5000, value_length - written);
+      std::string data(piece, '\0');
+      for (std::size_t b = 0; b < piece; b++) {
+        data[b] = overflowByte(written + b);
+      }
+      writer.write(data);
+      written += piece;
+    }
+    pointer = writer.finish();
+  }
+  if (pointer.length != value_length) {
+    PRINT_ERROR("ERROR :: OVERFLOW LENGTH IS WRONG");
+  }
+
+  // The slot holds only the pointer.
+  PageId main_page;
+  bufMgr->allocPage(file27, main_page, page);
+  const RecordId pointer_rid = pointer.insertInto(page);
+  // Data that happens to look like a pointer is not taken for one.
+  const RecordId lookalike_rid = page->insertRecord(pointer.encode());
+  bufMgr->unPinPage(file27, main_page, true);
+  bufMgr->flushFile(file27);
+
+  bufMgr->readPage(file27, main_page, page);
+  OverflowPointer stored;
+  OverflowPointer ignored;
+  if (page->getRecord(pointer_rid).size() != OverflowPointer::ENCODED_SIZE ||
+      !OverflowPointer::read(*page, pointer_rid, &stored) ||
+      stored.length != pointer.length ||
+      stored.first_page != pointer.first_page ||
+      OverflowPointer::read(*page, lookalike_rid, &ignored)) {
+    PRINT_ERROR("ERROR :: POINTER DID NOT ROUND TRIP");
+  }
+  bufMgr->unPinPage(file27, main_page, false);
+
+  // Stream the value back in small pieces, with and without read-ahead.
+  Executor io(2);
+  Executor *executors[] = {NULL, &io};
+  const auto readBack = [&]() {
+    for (Executor *executor : executors) {
+      OverflowReader reader(bufMgr.get(), &file27, stored, executor);
+      std::size_t offset = 0;
+      char buffer[1000];
+      std::size_t got;
+      while ((got = reader.read(buffer, sizeof(buffer))) > 0) {
+        for (std::size_t b = 0; b < got; b++) {
+          if (buffer[b] != overflowByte(offset + b)) {
+            PRINT_ERROR("ERROR :: OVERFLOW CONTENTS DID NOT MATCH");
+          }
+        }
+        offset += got;
+      }
+      if (offset != value_length || reader.remaining() != 0) {
+        PRINT_ERROR("ERROR :: OVERFLOW VALUE WAS CUT SHORT");
+      }
+    }
+  };
+  readBack();
+
+  // Compaction moves the value's pages into the freed ones and keeps the
+  // chain intact; the stored pointer is forwarded like a RecordId.
+  for (i = 0; i < num_fillers; i++) {
+    bufMgr->disposePage(file27, fillers[i]);
+  }
+  bufMgr->flushFile(file27);
+  const std::map<PageId, PageId> moved = bufMgr->compactFile(file27);
+  if (moved.count(stored.first_page) == 0 || moved.count(main_page) == 0) {
+    PRINT_ERROR("ERROR :: COMPACTION DID NOT MOVE THE VALUE");
+  }
+  main_page = moved.at(main_page);
+  if (!stored.forward(moved) || stored.forward(moved)) {
+    PRINT_ERROR("ERROR :: POINTER WAS NOT FORWARDED");
+  }
+  bufMgr->readPage(file27, main_page, page);
+  stored.updateIn(page, RecordId{main_page, pointer_rid.slot_number});
+  bufMgr->unPinPage(file27, main_page, true);
+  readBack();
+
+  // Empty values need no pages.
+  OverflowWriter empty_writer(bufMgr.get(), &file27);
+  const OverflowPointer empty = empty_writer.finish();
+  char byte;
+  if (empty.length != 0 || empty.first_page != Page::INVALID_NUMBER ||
+      OverflowReader(bufMgr.get(), &file27, empty).read(&byte, 1) != 0) {
+    PRINT_ERROR("ERROR :: EMPTY VALUE WAS NOT EMPTY");
+  }
+
+  // Disposing of the value frees all its pages.
+  disposeOverflow(bufMgr.get(), &file27, stored);
+  bufMgr->flushFile(file27);
+  PageId used = 0;
+  for (FileIterator iter = file27.begin(); iter != file27.end(); ++iter) {
+    used++;
+  }
+  if (used != 1) {
+    PRINT_ERROR("ERROR :: OVERFLOW PAGES WERE NOT FREED");
+  }
+
+  std::cout << "Test 27 passed"
+            << "\n";
+}
+
+void test28(File &file28) {
+  // Write a value twenty pages long.
+  const std::size_t value_length = 20 * Page::SIZE + 77;
+  OverflowPointer pointer;
+  {
+    OverflowWriter writer(bufMgr.get(), &file28);
+    std::string data(value_length, '\0');
+    for (std::size_t b = 0; b < value_length; b++) {
+      data[b] = overflowByte(b);
+    }
+    writer.write(data);
+    pointer = writer.finish();
+  }
+  bufMgr->flushFile(file28);
+
+  // Chunk by chunk, with and without read-ahead.
+  Executor io(2);
+  Executor *executors[] = {NULL, &io};
+  for (Executor *executor : executors) {
+    OverflowCursor cursor(bufMgr.get(), &file28, pointer, executor);
+    std::size_t offset = 0;
+    ChunkView chunk;
+    while (cursor.next(&chunk)) {
+      for (std::size_t b = 0; b < chunk.length; b++) {
+        if (chunk.data[b] != overflowByte(offset + b)) {
+          PRINT_ERROR("ERROR :: CHUNK VIEW CONTENTS DID NOT MATCH");
+        }
+      }
+      offset += chunk.length;
+    }
+    if (offset != value_length || cursor.remaining() != 0) {
+      PRINT_ERROR("ERROR :: CHUNK VIEWS WERE CUT SHORT");
+    }
+  }
+
+  // A window of views at a time, all valid together.
+  {
+    OverflowCursor cursor(bufMgr.get(), &file28, pointer, &io, 6);
+    std::vector<ChunkView> chunks;
+    std::size_t offset = 0;
+    std::size_t batches = 0;
+    while (cursor.next(&chunks) > 0) {
+      if (chunks.size() > 6) {
+        PRINT_ERROR("ERROR :: TOO MANY VIEWS IN A BATCH");
+      }
+      for (const ChunkView &view : chunks) {
+        for (std::size_t b = 0; b < view.length; b++) {
+          if (view.data[b] != overflowByte(offset + b)) {
+            PRINT_ERROR("ERROR :: BATCHED VIEW CONTENTS DID NOT MATCH");
+          }
+        }
+        offset += view.length;
+      }
+      batches++;
+    }
+    if (offset != value_length || batches != 4) {
+      PRINT_ERROR("ERROR :: BATCHED VIEWS WERE CUT SHORT");
+    }
+  }
+
+  // Scattered into buffers of odd sizes, across chunk boundaries.
+  {
+    OverflowCursor cursor(bufMgr.get(), &file28, pointer);
+    ChunkView chunk;
+    cursor.next(&chunk);
+    std::size_t offset = chunk.length;
+    std::vector<char> small(100), large(3 * Page::SIZE), rest(value_length);
+    struct iovec iov[] = {{small.data(), small.size()},
+                          {large.data(), large.size()},
+                          {rest.data(), rest.size()}};
+    const std::size_t got = cursor.read(iov, 3);
+    if (got != value_length - offset || cursor.remaining() != 0) {
+      PRINT_ERROR("ERROR :: SCATTERED READ WAS CUT SHORT");
+    }
+    for (std::size_t b = 0; b < got; b++) {
+      const char c = b < small.size() ? small[b]
+                     : b < small.size() + large.size()
+                         ? large[b - small.size()]
+                         : rest[b - small.size() - large.size()];
+      if (c != overflowByte(offset + b)) {
+        PRINT_ERROR("ERROR :: SCATTERED READ CONTENTS DID NOT MATCH");
+      }
+    }
+  }
+
+  // Straight to a file descriptor.
+  char path[] = "/tmp/badgerdb-test28-XXXXXX";
+  const int fd = mkstemp(path);
+  unlink(path);
+  const auto start = std::chrono::steady_clock::now();
+  std::uint64_t written;
+  {
+    OverflowCursor cursor(bufMgr.get(), &file28, pointer, &io);
+    written = cursor.writeTo(fd);
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  std::vector<char> copy(value_length + 1);
+  if (written != value_length ||
+      pread(fd, copy.data(), copy.size(), 0) !=
+          static_cast<ssize_t>(value_length)) {
+    PRINT_ERROR("ERROR :: WRITEV OUTPUT WAS CUT SHORT");
+  }
+  for (std::size_t b = 0; b < value_length; b++) {
+    if (copy[b] != overflowByte(b)) {
+      PRINT_ERROR("ERROR :: WRITEV OUTPUT DID NOT MATCH");
+    }
+  }
+  close(fd);
+  std::cout << "Streamed " << value_length << " bytes to a file in "
+            << seconds * 1e3 << " ms\n";
+
+  // Destroying a cursor part way releases its pins.
+  {
+    OverflowCursor cursor(bufMgr.get(), &file28, pointer, &io);
+    std::vector<ChunkView> chunks;
+    cursor.next(&chunks);
+  }
+  bufMgr->flushFile(file28);
+
+  std::cout << "Test 28 passed"
+            << "\n";
+}
+
+void test29(File &file29) {
+  // Forty pages through a pool of eight frames: most are evicted into the
+  // SSD cache while they are written.
+  const PageId num_pages = 40;
+  SsdCache ssd("test.29.ssd", 64);
+  {
+    BufMgr tieredMgr(8, &ssd);
+    for (i = 0; i < num_pages; i++) {
+      tieredMgr.allocPage(file29, pid[i], page);
+      sprintf(tmpbuf, "test.29 Page %u %7.1f", pid[i], (float)pid[i]);
+      rid[i] = page->insertRecord(tmpbuf);
+      tieredMgr.unPinPage(file29, pid[i], true);
+    }
+    if (tieredMgr.getBufStats().ssdwrites != (int)(num_pages - 8) ||
+        ssd.size() != num_pages - 8) {
+      PRINT_ERROR("ERROR :: EVICTED PAGES WERE NOT CACHED");
+    }
+
+    // Reading them all back goes to the SSD cache, never to the file.
+    tieredMgr.clearBufStats();
+    for (i = 0; i < num_pages; i++) {
+      tieredMgr.readPage(file29, pid[i], page);
+      sprintf(tmpbuf, "test.29 Page %u %7.1f", pid[i], (float)pid[i]);
+      if (strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) !=
+          0) {
+        PRINT_ERROR("ERROR :: CACHED CONTENTS DID NOT MATCH");
+      }
+      tieredMgr.unPinPage(file29, pid[i], false);
+    }
+    const BufStats &stats = tieredMgr.getBufStats();
+    if (stats.diskreads != 0 || stats.ssdmisses != 0 ||
+        stats.ssdhits != (int)num_pages) {
+      PRINT_ERROR("ERROR :: SSD CACHE DID NOT SERVE THE MISSES");
+    }
+    std::cout << "Pool hit rate "
+              << 1.0 - double(stats.ssdhits + stats.ssdmisses) / stats.accesses
+              << ", SSD hit rate "
+              << double(stats.ssdhits) / (stats.ssdhits + stats.ssdmisses)
+              << "\n";
+
+    // A changed page is not served from its stale copy.
+    tieredMgr.readPage(file29, pid[0], page);
+    page->updateRecord(rid[0], "test.29 changed");
+    tieredMgr.unPinPage(file29, pid[0], true);
+    for (i = 1; i < num_pages; i++) {
+      tieredMgr.readPage(file29, pid[i], page);
+      tieredMgr.unPinPage(file29, pid[i], false);
+    }
+    tieredMgr.readPage(file29, pid[0], page);
+    if (page->getRecord(rid[0]) != "test.29 changed") {
+      PRINT_ERROR("ERROR :: STALE PAGE WAS SERVED FROM THE SSD CACHE");
+    }
+    tieredMgr.unPinPage(file29, pid[0], false);
+
+    // Once the log wraps, the oldest pages must come from the file again.
+    for (i = num_pages; i < num_pages + 40; i++) {
+      tieredMgr.allocPage(file29, pid[i], page);
+      tieredMgr.unPinPage(file29, pid[i], true);
+    }
+    tieredMgr.clearBufStats();
+    for (i = 0; i < num_pages; i++) {
+      tieredMgr.readPage(file29, pid[i], page);
+      sprintf(tmpbuf, "test.29 Page %u %7.1f", pid[i], (float)pid[i]);
+      if (i > 0 && strncmp(page->getRecord(rid[i]).c_str(), tmpbuf,
+                           strlen(tmpbuf)) != 0) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH AFTER WRAPPING");
+      }
+      tieredMgr.unPinPage(file29, pid[i], false);
+    }
+    if (tieredMgr.getBufStats().ssdmisses == 0 ||
+        tieredMgr.getBufStats().diskreads == 0 ||
+        ssd.size() > ssd.capacity()) {
+      PRINT_ERROR("ERROR :: SSD CACHE DID NOT WRAP");
+    }
+
+    // Dropping the file forgets its cached pages.
+    tieredMgr.flushFile(file29);
+    tieredMgr.invalidateFile(file29);
+    if (ssd.size() != 0) {
+      PRINT_ERROR("ERROR :: INVALIDATED FILE STAYED IN THE SSD CACHE");
+    }
+  }
+
+  std::cout << "Test 29 passed"
+            << "\n";
+}
+
+void test30(File &file30) {
+  // The codec round-trips typical, incompressible and empty input.
+  {
+    std::string random(Page::SIZE, '\0');
+    unsigned int seed = 30;
+    for (char &c : random) {
+      c = static_cast<char>(rand_r(&seed));
+    }
+    const std::string inputs[] = {"test.30 record" +
+                                      std::string(Page::DATA_SIZE, '\0') +
+                                      std::string(300, 'x'),
+                                  random, std::string()};
+    for (const std::string &input : inputs) {
+      std::string compressed;
+      PageCompressor::compress(input.data(), input.size(), &compressed);
+      std::string output(input.size(), '\0');
+      if (!PageCompressor::decompress(compressed.data(), compressed.size(),
+                                      &output[0], output.size()) ||
+          output != input) {
+        PRINT_ERROR("ERROR :: CODEC DID NOT ROUND TRIP");
+      }
+      if (compressed.size() > 1 &&
+          PageCompressor::decompress(compressed.data(), compressed.size() - 1,
+                                     &output[0], output.size())) {
+        PRINT_ERROR("ERROR :: CODEC ACCEPTED TRUNCATED INPUT");
+      }
+    }
+  }
+
+  // Sixty pages through a pool of eight frames, with room for all of them
+  // in sixteen frames' worth of compressed memory.
+  const PageId num_pages = 60;
+  CompressedCache compressed(16 * Page::SIZE);
+  std::size_t page_bytes;
+  {
+    BufMgr tieredMgr(8, NULL, &compressed);
+    for (i = 0; i < num_pages; i++) {
+      tieredMgr.allocPage(file30, pid[i], page);
+      sprintf(tmpbuf, "test.30 Page %u %7.1f", pid[i], (float)pid[i]);
+      rid[i] = page->insertRecord(tmpbuf);
+      tieredMgr.unPinPage(file30, pid[i], true);
+    }
+    tieredMgr.clearBufStats();
+    for (i = 0; i < num_pages; i++) {
+      tieredMgr.readPage(file30, pid[i], page);
+      sprintf(tmpbuf, "test.30 Page %u %7.1f", pid[i], (float)pid[i]);
+      if (strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) !=
+          0) {
+        PRINT_ERROR("ERROR :: COMPRESSED CONTENTS DID NOT MATCH");
+      }
+      tieredMgr.unPinPage(file30, pid[i], false);
+    }
+    const BufStats &stats = tieredMgr.getBufStats();
+    if (stats.diskreads != 0 || stats.compressedmisses != 0 ||
+        stats.compressedhits != (int)num_pages) {
+      PRINT_ERROR("ERROR :: COMPRESSED CACHE DID NOT SERVE THE MISSES");
+    }
+    if (compressed.bytes() > compressed.budget() || compressed.ratio() < 4) {
+      PRINT_ERROR("ERROR :: COMPRESSED CACHE IS SIZED WRONG");
+    }
+    std::cout << "Compressed cache holds " << compressed.size() << " pages in "
+              << compressed.bytes() << " bytes, " << compressed.ratio()
+              << "x\n";
+    page_bytes = compressed.bytes() / compressed.size();
+
+    // A changed page is not served from its stale copy.
+    tieredMgr.readPage(file30, pid[0], page);
+    page->updateRecord(rid[0], "test.30 changed");
+    tieredMgr.unPinPage(file30, pid[0], true);
+    for (i = 1; i < num_pages; i++) {
+      tieredMgr.readPage(file30, pid[i], page);
+      tieredMgr.unPinPage(file30, pid[i], false);
+    }
+    tieredMgr.readPage(file30, pid[0], page);
+    if (page->getRecord(rid[0]) != "test.30 changed") {
+      PRINT_ERROR("ERROR :: STALE PAGE WAS SERVED FROM THE COMPRESSED CACHE");
+    }
+    tieredMgr.unPinPage(file30, pid[0], false);
+    tieredMgr.flushFile(file30);
+    tieredMgr.invalidateFile(file30);
+    if (compressed.size() != 0 || compressed.bytes() != 0) {
+      PRINT_ERROR("ERROR :: INVALIDATED FILE STAYED IN THE COMPRESSED CACHE");
+    }
+  }
+
+  // Below an SSD cache, a small budget drops the least recently used pages,
+  // whose misses then go to the SSD.
+  CompressedCache small(20 * page_bytes);
+  SsdCache ssd("test.30.ssd", num_pages);
+  {
+    BufMgr tieredMgr(8, &ssd, &small);
+    tieredMgr.clearBufStats();
+    for (i = 0; i < num_pages; i++) {
+      tieredMgr.readPage(file30, pid[i], page);
+      tieredMgr.unPinPage(file30, pid[i], false);
+    }
+    // Backwards, so the most recently evicted pages come first.
+    for (i = num_pages; i-- > 0;) {
+      tieredMgr.readPage(file30, pid[i], page);
+      tieredMgr.unPinPage(file30, pid[i], false);
+    }
+    const BufStats &stats = tieredMgr.getBufStats();
+    if (small.bytes() > small.budget() || small.size() >= num_pages ||
+        stats.compressedhits == 0 || stats.ssdhits == 0 ||
+        stats.diskreads != (int)num_pages) {
+      PRINT_ERROR("ERROR :: TIERS DID NOT SHARE THE MISSES");
+    }
+    tieredMgr.flushFile(file30);
+  }
+
+  std::cout << "Test 30 passed"
+            << "\n";
+}
+
+// Runs rounds of a latency-sensitive lookup of every hot page followed by a
+// long scan of the report file, through the pools the files are assigned to.
+// Returns the time spent on hot lookups and sets <hot_misses> to the number of
+// hot lookups that read the disk.
+static double mixedWorkload(BufferPools &pools, File &hot,
+                            const std::vector<PageId> &hot_pages, File &report,
+                            const std::vector<PageId> &report_pages,
+                            const std::size_t scan_pages, const int rounds,
+                            int *hot_misses) {
+  BufMgr *hot_pool = pools.poolFor(hot);
+  BufMgr *report_pool = pools.poolFor(report);
+  pools.clearBufStats();
+  *hot_misses = 0;
+  double seconds = 0;
+  std::size_t next_report = 0;
+  for (int round = 0; round < rounds; round++) {
+    const int reads_before = hot_pool->getBufStats().diskreads;
+    const auto start = std::chrono::steady_clock::now();
+    for (const PageId page_number : hot_pages) {
+      hot_pool->readPage(hot, page_number, page);
+      hot_pool->unPinPage(hot, page_number, false);
+    }
+    seconds += std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+    *hot_misses += hot_pool->getBufStats().diskreads - reads_before;
+    for (std::size_t s = 0; s < scan_pages; s++) {
+      const PageId page_number = report_pages[next_report];
+      next_report = (next_report + 1) % report_pages.size();
+      report_pool->readPage(report, page_number, page);
+      report_pool->unPinPage(report, page_number, false);
+    }
+  }
+  hot_pool->flushFile(hot);
+  report_pool->flushFile(report);
+  return seconds;
+}
+
+void test31(File &file31) {
+  const std::string report_name = "test.31.report";
+  try {
+    File::remove(report_name);
+  } catch (const FileNotFoundException &) {
+  }
+  {
+    File report = File::create(report_name);
+
+    // Exact names win over prefixes, and longer prefixes over shorter ones.
+    {
+      BufferPools pools(4);
+      pools.addPool("critical", 4);
+      pools.addPool("reports", 4);
+      pools.assignFile(file31.filename(), "critical");
+      pools.assignPrefix("test.31.", "reports");
+      pools.assignPrefix("test.31.archive", "critical");
+      if (pools.poolFor(file31) != pools.pool("critical") ||
+          pools.poolFor(report) != pools.pool("reports") ||
+          pools.poolName("test.31.archive.2") != "critical" ||
+          pools.poolName("test.310") != BufferPools::DEFAULT_POOL ||
+          pools.names().size() != 3) {
+        PRINT_ERROR("ERROR :: FILE WAS ASSIGNED TO THE WRONG POOL");
+      }
+      bool thrown = false;
+      try {
+        pools.assignFile(report_name, "missing");
+      } catch (const PoolNotFoundException &) {
+        thrown = true;
+      }
+      if (!thrown || pools.poolFor(report) != pools.pool("reports")) {
+        PRINT_ERROR("ERROR :: FILE WAS ASSIGNED TO A MISSING POOL");
+      }
+      thrown = false;
+      try {
+        pools.addPool("reports", 8);
+      } catch (const PoolExistsException &) {
+        thrown = true;
+      }
+      if (!thrown || pools.pool("reports")->numFrames() != 4) {
+        PRINT_ERROR("ERROR :: POOL WAS ADDED TWICE");
+      }
+
+      // A file with cached pages keeps its pool until it is flushed.
+      BufMgr *reports = pools.pool("reports");
+      PageId cached;
+      reports->allocPage(report, cached, page);
+      reports->unPinPage(report, cached, true);
+      int refused = 0;
+      try {
+        pools.assignFile(report_name, "critical");
+      } catch (const FileCachedException &e) {
+        refused += e.filename() == report_name && e.pool() == "reports";
+      }
+      try {
+        pools.assignPrefix("test.31.rep", BufferPools::DEFAULT_POOL);
+      } catch (const FileCachedException &e) {
+        refused++;
+      }
+      if (refused != 2 || pools.poolFor(report) != reports) {
+        PRINT_ERROR("ERROR :: CACHED FILE WAS MOVED TO ANOTHER POOL");
+      }
+      reports->flushFile(report);
+      pools.assignFile(report_name, "critical");
+      if (pools.poolFor(report) != pools.pool("critical")) {
+        PRINT_ERROR("ERROR :: FLUSHED FILE WAS NOT MOVED");
+      }
+      pools.pool("critical")->disposePage(report, cached);
+    }
+
+    // Sixteen hot pages and three hundred report pages.
+    std::vector<PageId> hot_pages, report_pages;
+    {
+      BufMgr setupMgr(32);
+      for (i = 0; i < 16; i++) {
+        setupMgr.allocPage(file31, pid[i], page);
+        page->insertRecord("test.31 hot");
+        setupMgr.unPinPage(file31, pid[i], true);
+        hot_pages.push_back(pid[i]);
+      }
+      for (i = 0; i < 300; i++) {
+        PageId page_number;
+        setupMgr.allocPage(report, page_number, page);
+        page->insertRecord("test.31 report");
+        setupMgr.unPinPage(report, page_number, true);
+        report_pages.push_back(page_number);
+      }
+      setupMgr.flushFile(file31);
+      setupMgr.flushFile(report);
+    }
+
+    // In one shared pool of 64 frames, every scan of 120 report pages pushes
+    // the hot pages out.
+    const int rounds = 20;
+    int shared_misses;
+    int isolated_misses;
+    double shared_seconds;
+    double isolated_seconds;
+    {
+      BufferPools pools(64);
+      shared_seconds = mixedWorkload(pools, file31, hot_pages, report,
+                                     report_pages, 120, rounds, &shared_misses);
+    }
+
+    // With the same 64 frames split, the hot pages keep a pool of their own.
+    {
+      BufferPools pools(8);
+      pools.addPool("critical", 16);
+      pools.addPool("reports", 40);
+      pools.assignFile(file31.filename(), "critical");
+      pools.assignPrefix("test.31.", "reports");
+      isolated_seconds =
+          mixedWorkload(pools, file31, hot_pages, report, report_pages, 120,
+                        rounds, &isolated_misses);
+      if (pools.pool(BufferPools::DEFAULT_POOL)->getBufStats().accesses != 0 ||
+          pools.pool("reports")->getBufStats().diskreads != 120 * rounds) {
+        PRINT_ERROR("ERROR :: POOL COUNTERS WERE WRONG");
+      }
+    }
+    if (isolated_misses != (int)hot_pages.size() ||
+        shared_misses <= isolated_misses) {
+      PRINT_ERROR("ERROR :: CRITICAL FILE WAS NOT ISOLATED");
+    }
+    const double lookups = double(rounds * hot_pages.size());
+    std::cout << "Hot lookups missing the pool: " << shared_misses << " of "
+              << lookups << " shared, " << isolated_misses << " isolated; "
+              << shared_seconds / lookups * 1e6 << " us vs "
+              << isolated_seconds / lookups * 1e6 << " us per lookup\n";
+  }
+  File::remove(report_name);
+
+  std::cout << "Test 31 passed"
+            << "\n";
+}
+
+void test32(File &file32) {
+  const int num_pages = 64;
+  const int num_threads = 8;
+  {
+    BufMgr setupMgr(num_pages);
+    for (i = 0; i < num_pages; i++) {
+      setupMgr.allocPage(file32, pid[i], page);
+      sprintf((char *)tmpbuf, "test.32 Page %u %7.1f", pid[i], (float)pid[i]);
+      rid[i] = page->insertRecord(tmpbuf);
+      setupMgr.unPinPage(file32, pid[i], true);
+    }
+    setupMgr.flushFile(file32);
+  }
+
+  // Threads missing the same pages at once wait for the one reading each
+  // page instead of reading it again.
+  {
+    BufMgr sharedMgr(num_pages + 16);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_threads; t++) {
+      workers.emplace_back([&]() {
+        for (int p = 0; p < num_pages; p++) {
+          Page *shared_page;
+          char expected[100];
+          sprintf(expected, "test.32 Page %u %7.1f", pid[p], (float)pid[p]);
+          sharedMgr.readPage(file32, pid[p], shared_page, LatchMode::SHARED);
+          if (strncmp(shared_page->getRecord(rid[p]).c_str(), expected,
+                      strlen(expected)) != 0) {
+            PRINT_ERROR("ERROR :: CONCURRENT READ RETURNED A WRONG PAGE");
+          }
+          sharedMgr.unPinPage(file32, pid[p], false, LatchMode::SHARED);
+        }
+      });
+    }
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+    if (sharedMgr.getBufStats().diskreads != num_pages ||
+        sharedMgr.getBufStats().accesses != num_pages * num_threads) {
+      PRINT_ERROR("ERROR :: CONCURRENT MISSES READ A PAGE TWICE");
+    }
+    sharedMgr.flushFile(file32);
+  }
+
+  // Dirty pages evicted by one thread are written back while the others
+  // keep reading and writing through the pool.
+  {
+    BufMgr smallMgr(16);
+    const int rounds = 20;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_threads; t++) {
+      workers.emplace_back([&, t]() {
+        for (int r = 0; r < rounds; r++) {
+          for (int p = t; p < num_pages; p += num_threads) {
+            Page *own_page;
+            smallMgr.readPage(file32, pid[p], own_page, LatchMode::EXCLUSIVE);
+            char record[100];
+            sprintf(record, "test.32 Page %u round %d", pid[p], r);
+            own_page->updateRecord(rid[p], record);
+            smallMgr.unPinPage(file32, pid[p], true, LatchMode::EXCLUSIVE);
+          }
+        }
+      });
+    }
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+    smallMgr.flushFile(file32);
+    if (smallMgr.getBufStats().diskwrites < num_pages) {
+      PRINT_ERROR("ERROR :: DIRTY PAGES WERE NOT WRITTEN BACK");
+    }
+    for (i = 0; i < num_pages; i++) {
+      char expected[100];
+      sprintf(expected, "test.32 Page %u round %d", pid[i], rounds - 1);
+      if (file32.readPage(pid[i]).getRecord(rid[i]) != expected) {
+        PRINT_ERROR("ERROR :: UPDATE WAS LOST ON WRITE-BACK");
+      }
+    }
+  }
+
+  std::cout << "Test 32 passed"
+            << "\n";
+}
+
+void test33(File &file33) {
+  // Records of 400 bytes fill 20 to a page, so a default batch of 1024
+  // records spans 52 pages, more than the pool holds.
+  const PageId num_frames = 16;
+  const int num_records = 10000;
+  BufMgr sortMgr(num_frames);
+  TempFileManager tempFiles(&sortMgr);
+  {
+    RecordWriter writer(&sortMgr, &file33);
+    const std::string padding(400 - 8, '.');
+    for (int r = 0; r < num_records; r++) {
+      sprintf(tmpbuf, "%08ld", random() % 100000000);
+      writer.append(tmpbuf + padding);
+    }
+  }
+  sortMgr.flushFile(file33);
+
+  File sorted = tempFiles.create();
+  ExternalSort sorter(&sortMgr, &tempFiles, 0.5);
+  const auto start = std::chrono::steady_clock::now();
+  sorter.sort(file33, sorted);
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  if (sorter.num_runs() < 2 || sorter.num_merge_passes() < 2) {
+    PRINT_ERROR("ERROR :: SORT DID NOT SPILL");
+  }
+
+  RecordBatch batch;
+  BatchScanner scanner(&sortMgr, &sorted, num_frames);
+  std::string previous;
+  int found = 0;
+  while (scanner.next(batch)) {
+    for (const RecordView &view : batch) {
+      const std::string record(view.data, view.length);
+      if (record < previous) {
+        PRINT_ERROR("ERROR :: SORT OUTPUT IS OUT OF ORDER");
+      }
+      previous = record;
+      found++;
+    }
+  }
+  scanner.close();
+  if (found != num_records) {
+    PRINT_ERROR("ERROR :: SORT LOST RECORDS");
+  }
+  tempFiles.drop(sorted);
+  sortMgr.flushFile(file33);
+
+  std::cout << "Sorted " << num_records << " records through "
+            << num_frames << " frames: " << sorter.num_runs() << " runs, "
+            << sorter.num_merge_passes() << " merge passes, "
+            << (long)(num_records / seconds) << " records/s"
+            << "\n";
+  std::cout << "Test 33 passed"
+            << "\n";
+}
+
+// Aggregates <file34> by the key at <key_offset> and returns records per
+// second.
+static double aggregateRate(BufMgr &aggMgr, TempFileManager &tempFiles,
+                            File &file34, const std::size_t key_offset,
+                            const std::size_t threads,
+                            const std::int32_t num_records,
+                            const std::int32_t num_groups) {
+  const std::vector<Aggregate> aggregates = {
+      {AggregateFunction::COUNT, FieldType::INT64, 0},
+      {AggregateFunction::SUM, FieldType::INT64, 8}};
+  HashAggregate aggregate(&aggMgr, &tempFiles,
+                          GroupKey{key_offset, sizeof(std::int32_t)},
+                          aggregates, 1 << 26);
+  aggregate.setThreads(threads);
+  std::int32_t groups = 0;
+  std::int64_t count = 0;
+  const auto start = std::chrono::steady_clock::now();
+  aggregate.aggregate(file34, [&](const char *, const std::int64_t *values) {
+    groups++;
+    count += values[0];
+  });
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  if (groups != num_groups || count != num_records) {
+    PRINT_ERROR("ERROR :: AGGREGATE LOST GROUPS OR RECORDS");
+  }
+  return num_records / seconds;
+}
+
+void test34(File &file34) {
+  // Records are a low-cardinality key, a high-cardinality key and a value.
+  // The pool is smaller than one parallel batch of 4 * 4096 records.
+  const std::int32_t num_records = 100000;
+  const std::int32_t low_groups = 16;
+  BufMgr aggMgr(40);
+  TempFileManager tempFiles(&aggMgr);
+  {
+    RecordWriter writer(&aggMgr, &file34);
+    for (std::int32_t r = 0; r < num_records; r++) {
+      const std::int32_t low = r % low_groups;
+      const std::int64_t value = r;
+      std::string record(reinterpret_cast<const char *>(&low), sizeof(low));
+      record.append(reinterpret_cast<const char *>(&r), sizeof(r));
+      record.append(reinterpret_cast<const char *>(&value), sizeof(value));
+      writer.append(record);
+    }
+  }
+  aggMgr.flushFile(file34);
+
+  const char *names[] = {"Low", "High"};
+  const std::int32_t groups[] = {low_groups, num_records};
+  for (int k = 0; k < 2; k++) {
+    const double single = aggregateRate(aggMgr, tempFiles, file34, 4 * k, 1,
+                                        num_records, groups[k]);
+    const double parallel = aggregateRate(aggMgr, tempFiles, file34, 4 * k,
+                                          4, num_records, groups[k]);
+    std::cout << names[k] << "-cardinality aggregate of " << num_records
+              << " records into " << groups[k] << " groups: "
+              << (long)single << " records/s on one thread, "
+              << (long)parallel << " on four"
+              << "\n";
+  }
+  aggMgr.flushFile(file34);
+
+  std::cout << "Test 34 passed"
+            << "\n";
+}
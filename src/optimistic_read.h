@@ -0,0 +1,137 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Reads one page optimistically, restarting on conflicts.
+ *
+ * Keeps a PageHandle for the page so that repeated reads, e.g. of an index
+ * root by one thread, neither pin nor latch it and write no memory shared
+ * with other threads.  A read that fails validation is retried with a fresh
+ * handle; after MAX_RESTARTS failed attempts the page is read under a shared
+ * latch instead, so writers cannot starve a reader.
+ *
+ * @warning This class is not threadsafe; use one reader per thread.
+ */
+class OptimisticReader {
+ public:
+  /**
+   * Number of failed optimistic attempts before falling back to a shared
+   * latch.
+   */
+  static const std::size_t MAX_RESTARTS = 8;
+
+  /**
+   * Constructs a reader for page <page_number> of <file>.  No page is
+   * accessed until the first read.
+   */
+  OptimisticReader(BufMgr *bufMgr, File *file, const PageId page_number)
+      : bufMgr_(bufMgr),
+        file_(file),
+        page_number_(page_number),
+        has_handle_(false),
+        restarts_(0) {}
+
+  /**
+   * Calls <fn> with the page and returns its result, computed from a
+   * consistent version of the page.  <fn> may be called more than once and
+   * may see torn data on attempts that are discarded; exceptions it throws
+   * on such attempts are swallowed.
+   */
+  template <typename Fn>
+  auto read(Fn fn) -> decltype(fn(std::declval<const Page &>()));
+
+  /**
+   * Returns the handle of the last successful optimistic read, e.g. to
+   * validate this page again after reading one of its children.
+   */
+  const PageHandle &handle() const { return handle_; }
+
+  /**
+   * Returns the number of optimistic attempts that failed validation.
+   */
+  std::size_t restarts() const { return restarts_; }
+
+ private:
+  /**
+   * Buffer manager holding the page.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * File holding the page.
+   */
+  File *file_;
+
+  /**
+   * Number of the page read.
+   */
+  PageId page_number_;
+
+  /**
+   * Handle of the page; only meaningful if has_handle_ is set.
+   */
+  PageHandle handle_;
+
+  /**
+   * Whether handle_ was obtained and has not failed validation since.
+   */
+  bool has_handle_;
+
+  /**
+   * Number of optimistic attempts that failed validation.
+   */
+  std::size_t restarts_;
+};
+
+template <typename Fn>
+auto OptimisticReader::read(Fn fn)
+    -> decltype(fn(std::declval<const Page &>())) {
+  for (std::size_t attempt = 0; attempt < MAX_RESTARTS; ++attempt) {
+    if (!has_handle_ || !bufMgr_->validate(handle_)) {
+      handle_ = bufMgr_->readHandle(*file_, page_number_);
+      has_handle_ = true;
+    }
+    try {
+      auto result = fn(*bufMgr_->optimisticPage(handle_));
+      if (bufMgr_->validate(handle_)) {
+        return result;
+      }
+    } catch (...) {
+      if (bufMgr_->validate(handle_)) {
+        throw;
+      }
+    }
+    has_handle_ = false;
+    ++restarts_;
+  }
+
+  // Too much contention: wait for the writers instead.
+  Page *page;
+  bufMgr_->readPage(*file_, page_number_, page, LatchMode::SHARED);
+  try {
+    auto result = fn(*page);
+    bufMgr_->unPinPage(*file_, page_number_, false, LatchMode::SHARED);
+    return result;
+  } catch (...) {
+    bufMgr_->unPinPage(*file_, page_number_, false, LatchMode::SHARED);
+    throw;
+  }
+}
+
+}  // namespace badgerdb
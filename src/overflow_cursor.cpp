@@ -0,0 +1,165 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "overflow_cursor.h"
+
+#include <limits.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include "overflow_page.h"
+
+namespace badgerdb {
+
+OverflowCursor::OverflowCursor(BufMgr *bufMgr, File *file,
+                               const OverflowPointer &pointer, Executor *io,
+                               const std::size_t window)
+    : bufMgr_(bufMgr),
+      file_(file),
+      window_(std::min<std::size_t>(window, IOV_MAX)),
+      prefetcher_(bufMgr, file, io, window),
+      consumed_(0),
+      offset_(0),
+      next_page_(pointer.first_page),
+      remaining_(pointer.length) {
+  assert(bufMgr_ != NULL);
+  assert(file_ != NULL);
+  assert(window_ > 0);
+}
+
+OverflowCursor::~OverflowCursor() {
+  for (const Held &held : held_) {
+    bufMgr_->unPinPage(*file_, held.page_number, false);
+  }
+}
+
+bool OverflowCursor::next(ChunkView *chunk) {
+  release();
+  if (remaining_ == 0 || (held_.empty() && !pinNext())) {
+    return false;
+  }
+  *chunk = view(0);
+  remaining_ -= chunk->length;
+  consumed_ = 1;
+  offset_ = 0;
+  return true;
+}
+
+std::size_t OverflowCursor::next(std::vector<ChunkView> *chunks) {
+  release();
+  chunks->clear();
+  while (held_.size() < window_ && pinNext()) {
+  }
+  for (std::size_t i = 0; i < held_.size() && remaining_ > 0; ++i) {
+    chunks->push_back(view(i));
+    remaining_ -= chunks->back().length;
+  }
+  consumed_ = chunks->size();
+  offset_ = 0;
+  return chunks->size();
+}
+
+std::size_t OverflowCursor::read(const struct iovec *iov, const int iovcnt) {
+  release();
+  std::size_t total = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    char *out = static_cast<char *>(iov[i].iov_base);
+    std::size_t length = iov[i].iov_len;
+    while (length > 0 && remaining_ > 0) {
+      if (held_.empty() && !pinNext()) {
+        return total;
+      }
+      const ChunkView chunk = view(0);
+      const std::size_t copied = std::min(length, chunk.length);
+      std::memcpy(out, chunk.data, copied);
+      consume(copied);
+      out += copied;
+      length -= copied;
+      total += copied;
+    }
+  }
+  return total;
+}
+
+std::uint64_t OverflowCursor::writeTo(const int fd) {
+  release();
+  std::uint64_t total = 0;
+  std::vector<struct iovec> iov;
+  while (remaining_ > 0) {
+    while (held_.size() < window_ && pinNext()) {
+    }
+    iov.clear();
+    std::uint64_t left = remaining_;
+    for (std::size_t i = 0; i < held_.size() && left > 0; ++i) {
+      const ChunkView chunk = view(i);
+      iov.push_back({const_cast<char *>(chunk.data), chunk.length});
+      left -= chunk.length;
+    }
+    if (iov.empty()) {
+      break;
+    }
+    const ssize_t written = ::writev(fd, iov.data(), iov.size());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    consume(written);
+    total += written;
+  }
+  return total;
+}
+
+void OverflowCursor::release() {
+  for (; consumed_ > 0; --consumed_) {
+    bufMgr_->unPinPage(*file_, held_.front().page_number, false);
+    held_.pop_front();
+  }
+}
+
+bool OverflowCursor::pinNext() {
+  if (next_page_ == Page::INVALID_NUMBER) {
+    return false;
+  }
+  Held held = {next_page_, NULL};
+  bufMgr_->readPage(*file_, held.page_number, held.page);
+  held_.push_back(held);
+  next_page_ = OverflowPage(held.page).next_page();
+  prefetcher_.start(next_page_);
+  return true;
+}
+
+ChunkView OverflowCursor::view(const std::size_t index) const {
+  const OverflowPage chunk(held_[index].page);
+  const std::size_t offset = index == 0 ? offset_ : 0;
+  ChunkView result = {chunk.data() + offset, chunk.length() - offset};
+  result.length = std::min<std::uint64_t>(result.length, remaining_);
+  return result;
+}
+
+void OverflowCursor::consume(std::size_t length) {
+  remaining_ -= length;
+  while (length > 0) {
+    const std::size_t chunk_length = OverflowPage(held_.front().page).length();
+    const std::size_t taken = std::min(length, chunk_length - offset_);
+    offset_ += taken;
+    length -= taken;
+    if (offset_ == chunk_length) {
+      bufMgr_->unPinPage(*file_, held_.front().page_number, false);
+      held_.pop_front();
+      offset_ = 0;
+    }
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,202 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "buffer.h"
+#include "executor.h"
+#include "file.h"
+#include "overflow_record.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Non-owning reference to bytes of an overflow record inside a pinned
+ * buffer frame.
+ */
+struct ChunkView {
+  /**
+   * Pointer to the first byte.
+   */
+  const char *data;
+
+  /**
+   * Number of bytes.
+   */
+  std::size_t length;
+};
+
+/**
+ * @brief Streams an overflow record straight out of the buffer pool.
+ *
+ * Unlike OverflowReader, which copies into a caller buffer, the cursor hands
+ * out views of the chunks in their pinned frames, and can write them to a
+ * file descriptor with writev() or scatter them into caller buffers like
+ * readv(), so a value is never assembled in memory.  Up to <window> chunk
+ * pages are pinned at a time; with an I/O executor the pages after them are
+ * read into the pool in the background.
+ *
+ * Views returned by next() stay valid until the next call on the cursor.
+ *
+ * @warning This class is not threadsafe.
+ */
+class OverflowCursor {
+ public:
+  /**
+   * Number of chunk pages pinned at a time unless given otherwise.
+   */
+  static const std::size_t DEFAULT_WINDOW = 8;
+
+  /**
+   * Constructs a cursor at the start of the record <pointer> refers to.
+   *
+   * @param bufMgr  Buffer manager to read pages through.
+   * @param file    File holding the record.
+   * @param pointer Pointer to the record.
+   * @param io      Executor reading ahead, or NULL for no read-ahead.
+   * @param window  Number of chunk pages pinned at a time; also the number
+   *                read ahead.  Must be below the number of buffer frames.
+   */
+  OverflowCursor(BufMgr *bufMgr, File *file, const OverflowPointer &pointer,
+                 Executor *io = NULL,
+                 const std::size_t window = DEFAULT_WINDOW);
+
+  /**
+   * Unpins all pages held by the cursor.
+   */
+  ~OverflowCursor();
+
+  OverflowCursor(const OverflowCursor &) = delete;
+  OverflowCursor &operator=(const OverflowCursor &) = delete;
+
+  /**
+   * Sets <chunk> to the rest of the next chunk and moves past it.
+   *
+   * @return  False once the whole record has been consumed.
+   */
+  bool next(ChunkView *chunk);
+
+  /**
+   * Replaces the contents of <chunks> with views of the rest of the next
+   * chunks, up to a window's worth, and moves past them.
+   *
+   * @return  Number of views; 0 once the whole record has been consumed.
+   */
+  std::size_t next(std::vector<ChunkView> *chunks);
+
+  /**
+   * Copies the next bytes of the record into the <iovcnt> buffers of
+   * <iov> in order, like readv(), until they are full or the record ends.
+   *
+   * @return  Number of bytes copied.
+   */
+  std::size_t read(const struct iovec *iov, const int iovcnt);
+
+  /**
+   * Writes the rest of the record to <fd> with writev(), a window of chunks
+   * per call, directly from the buffer frames.
+   *
+   * @return  Number of bytes written.  If that is less than remaining()
+   *          was before the call, a write failed and errno tells why.
+   */
+  std::uint64_t writeTo(const int fd);
+
+  /**
+   * Returns the number of bytes not consumed yet.
+   */
+  std::uint64_t remaining() const { return remaining_; }
+
+ private:
+  /**
+   * A pinned chunk page.
+   */
+  struct Held {
+    PageId page_number;
+    Page *page;
+  };
+
+  /**
+   * Unpins the pages whose chunks were fully consumed.
+   */
+  void release();
+
+  /**
+   * Pins the next page of the chain.
+   *
+   * @return  False at the end of the chain.
+   */
+  bool pinNext();
+
+  /**
+   * Returns the unconsumed part of the held chunk at <index>.
+   */
+  ChunkView view(const std::size_t index) const;
+
+  /**
+   * Consumes <length> bytes from the front of the held chunks, unpinning
+   * the pages fully consumed.
+   */
+  void consume(std::size_t length);
+
+  /**
+   * Buffer manager to read pages through.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * File holding the record.
+   */
+  File *file_;
+
+  /**
+   * Number of chunk pages pinned at a time.
+   */
+  std::size_t window_;
+
+  /**
+   * Reads the pages after the held ones ahead.
+   */
+  OverflowPrefetcher prefetcher_;
+
+  /**
+   * Pinned chunk pages, in chain order.
+   */
+  std::deque<Held> held_;
+
+  /**
+   * Number of held pages at the front whose chunks were handed out in full
+   * by next() and are unpinned by the following call.
+   */
+  std::size_t consumed_;
+
+  /**
+   * Offset of the first unconsumed byte in the first held chunk.
+   */
+  std::size_t offset_;
+
+  /**
+   * Page after the last held one, or Page::INVALID_NUMBER.
+   */
+  PageId next_page_;
+
+  /**
+   * Number of bytes not consumed yet.
+   */
+  std::uint64_t remaining_;
+};
+
+}  // namespace badgerdb
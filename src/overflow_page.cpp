@@ -0,0 +1,45 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "overflow_page.h"
+
+#include <cassert>
+
+#include "exceptions/invalid_page_type_exception.h"
+
+namespace badgerdb {
+
+OverflowPage OverflowPage::format(Page *page) {
+  assert(page != NULL);
+  page->header_.free_space_lower_bound = 0;
+  page->header_.free_space_upper_bound = 0;
+  page->header_.num_slots = 0;
+  page->header_.num_free_slots = 0;
+  page->header_.page_type = static_cast<std::uint16_t>(PageType::OVERFLOW);
+  page->data_.assign(Page::DATA_SIZE, char());
+
+  OverflowPage overflow(page);
+  overflow.set_next_page(Page::INVALID_NUMBER);
+  overflow.set_length(0);
+  return overflow;
+}
+
+OverflowPage::OverflowPage(Page *page) : page_(page) {
+  assert(page_ != NULL);
+  if (page_->page_type() != PageType::OVERFLOW) {
+    throw InvalidPageTypeException(page_->page_number(),
+                                   page_->header_.page_type);
+  }
+}
+
+void OverflowPage::set_length(const std::size_t length) {
+  assert(length <= CHUNK_SIZE);
+  header()->length = static_cast<std::uint32_t>(length);
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,117 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Header at the start of the data area of an overflow page.
+ */
+struct OverflowPageHeader {
+  /**
+   * Page holding the next chunk, or Page::INVALID_NUMBER for the last one.
+   */
+  PageId next_page;
+
+  /**
+   * Number of bytes of the chunk stored on this page.
+   */
+  std::uint32_t length;
+};
+
+/**
+ * @brief Accessor for pages holding one chunk of an overflow record.
+ *
+ * The chunks of a record are chained through their headers, in the order of
+ * the record rather than of the file's list of used pages, which holds them
+ * like any other page.  File::compact() forwards these links when it moves
+ * chunks.  Like FixedPage, an OverflowPage does not own the page it wraps.
+ *
+ * @warning This class is not threadsafe.
+ */
+class OverflowPage {
+ public:
+  /**
+   * Number of record bytes an overflow page holds.
+   */
+  static const std::size_t CHUNK_SIZE =
+      Page::DATA_SIZE - sizeof(OverflowPageHeader);
+
+  /**
+   * Erases <page> and formats it to hold an empty chunk with no successor.
+   *
+   * @param page  Page to format; keeps its page number.
+   * @return  Accessor for the formatted page.
+   */
+  static OverflowPage format(Page *page);
+
+  /**
+   * Wraps a page previously formatted with format().
+   *
+   * @param page  Page to wrap.
+   * @throws  InvalidPageTypeException  If the page is not an overflow page.
+   */
+  explicit OverflowPage(Page *page);
+
+  /**
+   * Returns the page holding the next chunk, or Page::INVALID_NUMBER.
+   */
+  PageId next_page() const { return header()->next_page; }
+
+  /**
+   * Sets the page holding the next chunk.
+   */
+  void set_next_page(const PageId next_page) {
+    header()->next_page = next_page;
+  }
+
+  /**
+   * Returns the number of bytes of the chunk.
+   */
+  std::size_t length() const { return header()->length; }
+
+  /**
+   * Sets the number of bytes of the chunk; at most CHUNK_SIZE.
+   */
+  void set_length(const std::size_t length);
+
+  /**
+   * Returns the bytes of the chunk.
+   */
+  const char *data() const {
+    return &page_->data_[0] + sizeof(OverflowPageHeader);
+  }
+
+  /**
+   * Returns the bytes of the chunk for writing.
+   */
+  char *data() { return &page_->data_[0] + sizeof(OverflowPageHeader); }
+
+ private:
+  const OverflowPageHeader *header() const {
+    return reinterpret_cast<const OverflowPageHeader *>(&page_->data_[0]);
+  }
+
+  OverflowPageHeader *header() {
+    return reinterpret_cast<OverflowPageHeader *>(&page_->data_[0]);
+  }
+
+  /**
+   * Page wrapped.
+   */
+  Page *page_;
+};
+
+}  // namespace badgerdb
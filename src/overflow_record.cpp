@@ -0,0 +1,215 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "overflow_record.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#include "exceptions/badgerdb_exception.h"
+#include "overflow_page.h"
+
+namespace badgerdb {
+
+std::string OverflowPointer::encode() const {
+  std::string record(ENCODED_SIZE, char());
+  std::memcpy(&record[0], &length, sizeof(length));
+  std::memcpy(&record[sizeof(length)], &first_page, sizeof(first_page));
+  return record;
+}
+
+RecordId OverflowPointer::insertInto(Page *page) const {
+  return page->insertRecord(encode(), PageSlot::OVERFLOW_POINTER);
+}
+
+void OverflowPointer::updateIn(Page *page, const RecordId &record_id) const {
+  page->updateRecord(record_id, encode(), PageSlot::OVERFLOW_POINTER);
+}
+
+bool OverflowPointer::read(const Page &page, const RecordId &record_id,
+                           OverflowPointer *pointer) {
+  if ((page.getRecordFlags(record_id) & PageSlot::OVERFLOW_POINTER) == 0) {
+    return false;
+  }
+  const std::string record = page.getRecord(record_id);
+  assert(record.size() == ENCODED_SIZE);
+  std::memcpy(&pointer->length, &record[0], sizeof(pointer->length));
+  std::memcpy(&pointer->first_page, &record[sizeof(pointer->length)],
+              sizeof(pointer->first_page));
+  return true;
+}
+
+bool OverflowPointer::forward(const std::map<PageId, PageId> &moved) {
+  const std::map<PageId, PageId>::const_iterator it = moved.find(first_page);
+  if (it == moved.end()) {
+    return false;
+  }
+  first_page = it->second;
+  return true;
+}
+
+OverflowWriter::OverflowWriter(BufMgr *bufMgr, File *file)
+    : bufMgr_(bufMgr),
+      file_(file),
+      current_number_(Page::INVALID_NUMBER),
+      current_(NULL) {
+  assert(bufMgr_ != NULL);
+  assert(file_ != NULL);
+  pointer_.length = 0;
+  pointer_.first_page = Page::INVALID_NUMBER;
+}
+
+OverflowWriter::~OverflowWriter() {
+  if (current_ != NULL) {
+    bufMgr_->unPinPage(*file_, current_number_, true);
+  }
+}
+
+void OverflowWriter::write(const char *data, std::size_t length) {
+  while (length > 0) {
+    if (current_ == NULL ||
+        OverflowPage(current_).length() == OverflowPage::CHUNK_SIZE) {
+      PageId next_number;
+      Page *next;
+      bufMgr_->allocPage(*file_, next_number, next);
+      OverflowPage::format(next);
+      if (current_ == NULL) {
+        pointer_.first_page = next_number;
+      } else {
+        OverflowPage(current_).set_next_page(next_number);
+        bufMgr_->unPinPage(*file_, current_number_, true);
+      }
+      current_number_ = next_number;
+      current_ = next;
+    }
+    OverflowPage chunk(current_);
+    const std::size_t copied =
+        std::min(length, OverflowPage::CHUNK_SIZE - chunk.length());
+    std::memcpy(chunk.data() + chunk.length(), data, copied);
+    chunk.set_length(chunk.length() + copied);
+    pointer_.length += copied;
+    data += copied;
+    length -= copied;
+  }
+}
+
+OverflowPointer OverflowWriter::finish() {
+  if (current_ != NULL) {
+    bufMgr_->unPinPage(*file_, current_number_, true);
+    current_ = NULL;
+  }
+  return pointer_;
+}
+
+OverflowPrefetcher::~OverflowPrefetcher() {
+  if (pending_.valid()) {
+    pending_.wait();
+  }
+}
+
+void OverflowPrefetcher::start(const PageId page_number) {
+  if (io_ == NULL || pages_ == 0 || page_number == Page::INVALID_NUMBER) {
+    return;
+  }
+  if (pending_.valid() && pending_.wait_for(std::chrono::seconds(0)) !=
+                              std::future_status::ready) {
+    return;
+  }
+  BufMgr *bufMgr = bufMgr_;
+  File *file = file_;
+  const std::size_t count = pages_;
+  std::shared_ptr<std::packaged_task<void()>> task(
+      new std::packaged_task<void()>([bufMgr, file, page_number, count]() {
+        // Advisory only: a page that cannot be read now is read on demand.
+        try {
+          PageId next = page_number;
+          for (std::size_t i = 0; i < count && next != Page::INVALID_NUMBER;
+               ++i) {
+            Page *page;
+            bufMgr->readPage(*file, next, page);
+            const PageId following = OverflowPage(page).next_page();
+            bufMgr->unPinPage(*file, next, false);
+            next = following;
+          }
+        } catch (const BadgerDbException &) {
+        }
+      }));
+  pending_ = task->get_future();
+  io_->post([task]() { (*task)(); });
+}
+
+OverflowReader::OverflowReader(BufMgr *bufMgr, File *file,
+                               const OverflowPointer &pointer, Executor *io,
+                               const std::size_t read_ahead)
+    : bufMgr_(bufMgr),
+      file_(file),
+      prefetcher_(bufMgr, file, io, read_ahead),
+      remaining_(pointer.length),
+      current_number_(Page::INVALID_NUMBER),
+      current_(NULL),
+      offset_(0) {
+  assert(bufMgr_ != NULL);
+  assert(file_ != NULL);
+  if (pointer.first_page != Page::INVALID_NUMBER) {
+    moveTo(pointer.first_page);
+  }
+}
+
+OverflowReader::~OverflowReader() {
+  if (current_ != NULL) {
+    bufMgr_->unPinPage(*file_, current_number_, false);
+  }
+}
+
+std::size_t OverflowReader::read(char *data, std::size_t length) {
+  std::size_t total = 0;
+  while (length > 0 && remaining_ > 0) {
+    OverflowPage chunk(current_);
+    if (offset_ == chunk.length()) {
+      moveTo(chunk.next_page());
+      continue;
+    }
+    const std::size_t copied = std::min(length, chunk.length() - offset_);
+    std::memcpy(data, chunk.data() + offset_, copied);
+    offset_ += copied;
+    remaining_ -= copied;
+    data += copied;
+    length -= copied;
+    total += copied;
+  }
+  return total;
+}
+
+void OverflowReader::moveTo(const PageId page_number) {
+  if (current_ != NULL) {
+    bufMgr_->unPinPage(*file_, current_number_, false);
+    current_ = NULL;
+  }
+  bufMgr_->readPage(*file_, page_number, current_);
+  current_number_ = page_number;
+  offset_ = 0;
+  prefetcher_.start(OverflowPage(current_).next_page());
+}
+
+void disposeOverflow(BufMgr *bufMgr, File *file,
+                     const OverflowPointer &pointer) {
+  PageId page_number = pointer.first_page;
+  while (page_number != Page::INVALID_NUMBER) {
+    Page *page;
+    bufMgr->readPage(*file, page_number, page);
+    const PageId next = OverflowPage(page).next_page();
+    bufMgr->unPinPage(*file, page_number, false);
+    bufMgr->disposePage(*file, page_number);
+    page_number = next;
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,325 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <string>
+
+#include "buffer.h"
+#include "executor.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Reference to a record stored in a chain of overflow pages.
+ *
+ * Records too large for a page are written with an OverflowWriter; the
+ * slotted page then holds only the encoded pointer, a few bytes long, in a
+ * slot flagged PageSlot::OVERFLOW_POINTER.  The flag, not the bytes, tells
+ * pointers from data, so code moving records between pages must carry the
+ * slot flags along.
+ */
+struct OverflowPointer {
+  /**
+   * Number of bytes of an encoded pointer.
+   */
+  static const std::size_t ENCODED_SIZE =
+      sizeof(std::uint64_t) + sizeof(PageId);
+
+  /**
+   * Length of the record in bytes.
+   */
+  std::uint64_t length;
+
+  /**
+   * Page holding the first chunk, or Page::INVALID_NUMBER if the record is
+   * empty.
+   */
+  PageId first_page;
+
+  /**
+   * Returns the pointer encoded for storing in a record.
+   */
+  std::string encode() const;
+
+  /**
+   * Inserts the pointer into <page> as a new flagged record.
+   *
+   * @return  ID of the new record.
+   * @throws  InsufficientSpaceException  If the page is full.
+   */
+  RecordId insertInto(Page *page) const;
+
+  /**
+   * Replaces the record <record_id> of <page> by the pointer, flagging it.
+   *
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  void updateIn(Page *page, const RecordId &record_id) const;
+
+  /**
+   * Reads the pointer stored in the record <record_id> of <page>.
+   *
+   * @param page       Page holding the record.
+   * @param record_id  ID of the record.
+   * @param pointer    Set to the stored pointer.
+   * @return  False if the record is not flagged as an overflow pointer.
+   * @throws  InvalidRecordException  If the ID does not refer to a record.
+   */
+  static bool read(const Page &page, const RecordId &record_id,
+                   OverflowPointer *pointer);
+
+  /**
+   * Points to the new number of the first page if it was moved by
+   * File::compact() or BufMgr::compactFile().
+   *
+   * @param moved  Forwarding map returned by the compaction.
+   * @return  True if the pointer changed and must be stored again.
+   */
+  bool forward(const std::map<PageId, PageId> &moved);
+};
+
+/**
+ * @brief Writes a record of any size into a new chain of overflow pages,
+ * piece by piece.
+ *
+ * Pages are allocated through the buffer manager as the record grows; only
+ * the page being filled is pinned.  A writer destroyed without finish()
+ * leaves the pages written so far allocated.
+ *
+ * @warning This class is not threadsafe.
+ */
+class OverflowWriter {
+ public:
+  /**
+   * Constructs a writer appending a new record to <file>.
+   */
+  OverflowWriter(BufMgr *bufMgr, File *file);
+
+  /**
+   * Unpins the page being filled, if any.
+   */
+  ~OverflowWriter();
+
+  OverflowWriter(const OverflowWriter &) = delete;
+  OverflowWriter &operator=(const OverflowWriter &) = delete;
+
+  /**
+   * Appends <length> bytes at <data> to the record.
+   */
+  void write(const char *data, std::size_t length);
+
+  /**
+   * Appends <data> to the record.
+   */
+  void write(const std::string &data) { write(data.data(), data.size()); }
+
+  /**
+   * Completes the record and returns the pointer to store in its slot.
+   */
+  OverflowPointer finish();
+
+ private:
+  /**
+   * Buffer manager to allocate pages through.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * File to write the record to.
+   */
+  File *file_;
+
+  /**
+   * Pointer to the record written so far.
+   */
+  OverflowPointer pointer_;
+
+  /**
+   * Number of the page being filled.
+   */
+  PageId current_number_;
+
+  /**
+   * Page being filled, pinned, or NULL.
+   */
+  Page *current_;
+};
+
+/**
+ * @brief Reads the pages of an overflow chain into the buffer pool in the
+ * background.
+ *
+ * Each call to start() walks up to a fixed number of pages down the chain on
+ * an I/O executor, pinning each page just long enough to find the next one,
+ * so that a reader following the chain finds its pages resident.  Reading
+ * ahead is advisory: errors are ignored and a call made while the previous
+ * walk is still running does nothing.
+ *
+ * @warning This class is not threadsafe.
+ */
+class OverflowPrefetcher {
+ public:
+  /**
+   * Constructs a prefetcher.
+   *
+   * @param bufMgr  Buffer manager to read pages through.
+   * @param file    File holding the chain.
+   * @param io      Executor reading ahead, or NULL to never read ahead.
+   * @param pages   Number of pages to read per walk.
+   */
+  OverflowPrefetcher(BufMgr *bufMgr, File *file, Executor *io,
+                     const std::size_t pages)
+      : bufMgr_(bufMgr), file_(file), io_(io), pages_(pages) {}
+
+  /**
+   * Waits for the running walk, if any.
+   */
+  ~OverflowPrefetcher();
+
+  OverflowPrefetcher(const OverflowPrefetcher &) = delete;
+  OverflowPrefetcher &operator=(const OverflowPrefetcher &) = delete;
+
+  /**
+   * Starts walking the chain from <page_number> unless a walk is running.
+   */
+  void start(const PageId page_number);
+
+ private:
+  /**
+   * Buffer manager to read pages through.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * File holding the chain.
+   */
+  File *file_;
+
+  /**
+   * Executor reading ahead, or NULL.
+   */
+  Executor *io_;
+
+  /**
+   * Number of pages to read per walk.
+   */
+  std::size_t pages_;
+
+  /**
+   * Completion of the running walk, if any.
+   */
+  std::future<void> pending_;
+};
+
+/**
+ * @brief Reads a record from its chain of overflow pages, piece by piece.
+ *
+ * Only the page being read is pinned.  With an I/O executor, the next
+ * <read_ahead> pages of the chain are read into the buffer pool in the
+ * background while the current one is consumed.
+ *
+ * @warning This class is not threadsafe.
+ */
+class OverflowReader {
+ public:
+  /**
+   * Number of pages read ahead unless given otherwise.
+   */
+  static const std::size_t DEFAULT_READ_AHEAD = 4;
+
+  /**
+   * Constructs a reader for the record <pointer> refers to.
+   *
+   * @param bufMgr      Buffer manager to read pages through.
+   * @param file        File holding the record.
+   * @param pointer     Pointer to the record.
+   * @param io          Executor reading ahead, or NULL for no read-ahead.
+   * @param read_ahead  Number of pages to read ahead.
+   */
+  OverflowReader(BufMgr *bufMgr, File *file, const OverflowPointer &pointer,
+                 Executor *io = NULL,
+                 const std::size_t read_ahead = DEFAULT_READ_AHEAD);
+
+  /**
+   * Unpins the page being read and waits for the read-ahead to finish.
+   */
+  ~OverflowReader();
+
+  OverflowReader(const OverflowReader &) = delete;
+  OverflowReader &operator=(const OverflowReader &) = delete;
+
+  /**
+   * Copies up to <length> of the next bytes of the record to <data>.
+   *
+   * @return  Number of bytes copied; 0 once the whole record has been read.
+   */
+  std::size_t read(char *data, std::size_t length);
+
+  /**
+   * Returns the number of bytes not read yet.
+   */
+  std::uint64_t remaining() const { return remaining_; }
+
+ private:
+  /**
+   * Unpins the current page and pins <page_number> in its place.
+   */
+  void moveTo(const PageId page_number);
+
+  /**
+   * Buffer manager to read pages through.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * File holding the record.
+   */
+  File *file_;
+
+  /**
+   * Reads the pages after the current one ahead.
+   */
+  OverflowPrefetcher prefetcher_;
+
+  /**
+   * Number of bytes not read yet.
+   */
+  std::uint64_t remaining_;
+
+  /**
+   * Number of the page being read.
+   */
+  PageId current_number_;
+
+  /**
+   * Page being read, pinned, or NULL.
+   */
+  Page *current_;
+
+  /**
+   * Offset of the next byte to read in the current chunk.
+   */
+  std::size_t offset_;
+};
+
+/**
+ * Frees all overflow pages of the record <pointer> refers to.  The pages
+ * must not be pinned.
+ */
+void disposeOverflow(BufMgr *bufMgr, File *file,
+                     const OverflowPointer &pointer);
+
+}  // namespace badgerdb
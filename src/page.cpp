@@ -9,16 +9,43 @@
 #include "page.h"
 
 #include <cassert>
+#include <utility>
 
 #include "exceptions/insufficient_space_exception.h"
 #include "exceptions/invalid_record_exception.h"
 #include "exceptions/invalid_slot_exception.h"
 #include "exceptions/slot_in_use_exception.h"
+#include "page_buffer_pool.h"
 #include "page_iterator.h"
+#include "record_batch.h"
 
 namespace badgerdb {
 
-Page::Page() { initialize(); }
+Page::Page() : data_(PageBufferPool::acquire()) { initialize(); }
+
+Page::Page(Uninitialized) : header_(), data_(PageBufferPool::acquire()) {}
+
+Page::Page(const Page &other)
+    : header_(other.header_), data_(PageBufferPool::acquire()) {
+  data_ = other.data_;
+}
+
+Page::Page(Page &&other) noexcept
+    : header_(other.header_), data_(std::move(other.data_)) {}
+
+Page &Page::operator=(const Page &other) {
+  header_ = other.header_;
+  data_ = other.data_;
+  return *this;
+}
+
+Page &Page::operator=(Page &&other) noexcept {
+  std::swap(header_, other.header_);
+  data_.swap(other.data_);
+  return *this;
+}
+
+Page::~Page() { PageBufferPool::release(std::move(data_)); }
 
 void Page::initialize() {
   header_.free_space_lower_bound = 0;
@@ -27,16 +54,18 @@ void Page::initialize() {
   header_.num_free_slots = 0;
   header_.current_page_number = INVALID_NUMBER;
   header_.next_page_number = INVALID_NUMBER;
+  header_.page_type = static_cast<std::uint16_t>(PageType::SLOTTED);
   data_.assign(DATA_SIZE, char());
 }
 
-RecordId Page::insertRecord(const std::string &record_data) {
+RecordId Page::insertRecord(const std::string &record_data,
+                            const std::uint8_t flags) {
   if (!hasSpaceForRecord(record_data)) {
     throw InsufficientSpaceException(page_number(), record_data.length(),
                                      getFreeSpace());
   }
   const SlotId slot_number = getAvailableSlot();
-  insertRecordInSlot(slot_number, record_data);
+  insertRecordInSlot(slot_number, record_data, flags);
   return {page_number(), slot_number};
 }
 
@@ -47,7 +76,8 @@ std::string Page::getRecord(const RecordId &record_id) const {
 }
 
 void Page::updateRecord(const RecordId &record_id,
-                        const std::string &record_data) {
+                        const std::string &record_data,
+                        const std::uint8_t flags) {
   validateRecordId(record_id);
   const PageSlot *slot = getSlot(record_id.slot_number);
   const std::size_t free_space_after_delete =
@@ -60,7 +90,12 @@ void Page::updateRecord(const RecordId &record_id,
   // record data in the same slot, and compaction might delete the slot if we
   // permit it.
   deleteRecord(record_id, false /* allow_slot_compaction */);
-  insertRecordInSlot(record_id.slot_number, record_data);
+  insertRecordInSlot(record_id.slot_number, record_data, flags);
+}
+
+std::uint8_t Page::getRecordFlags(const RecordId &record_id) const {
+  validateRecordId(record_id);
+  return getSlot(record_id.slot_number)->flags;
 }
 
 void Page::deleteRecord(const RecordId &record_id) {
@@ -97,6 +132,7 @@ void Page::deleteRecord(const RecordId &record_id,
 
   // Mark slot as unused.
   slot->used = false;
+  slot->flags = 0;
   slot->item_offset = 0;
   slot->item_length = 0;
   ++header_.num_free_slots;
@@ -165,7 +201,8 @@ SlotId Page::getAvailableSlot() {
 }
 
 void Page::insertRecordInSlot(const SlotId slot_number,
-                              const std::string &record_data) {
+                              const std::string &record_data,
+                              const std::uint8_t flags) {
   if (slot_number > header_.num_slots || slot_number == INVALID_SLOT) {
     throw InvalidSlotException(page_number(), slot_number);
   }
@@ -175,6 +212,7 @@ void Page::insertRecordInSlot(const SlotId slot_number,
   }
   const int record_length = record_data.length();
   slot->used = true;
+  slot->flags = flags;
   slot->item_length = record_length;
   slot->item_offset = header_.free_space_upper_bound - record_length;
   header_.free_space_upper_bound = slot->item_offset;
@@ -183,7 +221,8 @@ void Page::insertRecordInSlot(const SlotId slot_number,
 }
 
 void Page::validateRecordId(const RecordId &record_id) const {
-  if (record_id.page_number != page_number()) {
+  if (record_id.page_number != page_number() ||
+      page_type() != PageType::SLOTTED) {
     throw InvalidRecordException(record_id, page_number());
   }
   const PageSlot *slot = getSlot(record_id.slot_number);
@@ -192,6 +231,23 @@ void Page::validateRecordId(const RecordId &record_id) const {
   }
 }
 
+SlotId Page::appendRecordViews(const SlotId start_after,
+                               RecordBatch &batch) const {
+  for (SlotId i = start_after + 1; i <= header_.num_slots; ++i) {
+    const PageSlot *slot = getSlot(i);
+    if (!slot->used) {
+      continue;
+    }
+    if (batch.full()) {
+      return i - 1;
+    }
+    batch.append({{page_number(), i},
+                  data_.data() + slot->item_offset,
+                  slot->item_length});
+  }
+  return INVALID_SLOT;
+}
+
 PageIterator Page::begin() { return PageIterator(this); }
 
 PageIterator Page::end() {
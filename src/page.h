@@ -18,6 +18,31 @@
 
 namespace badgerdb {
 
+/**
+ * @brief Format of the data area of a page.
+ */
+enum class PageType : std::uint16_t {
+  /**
+   * Variable-length records addressed through a slot directory.
+   */
+  SLOTTED = 0,
+
+  /**
+   * Fixed-width records stored row by row.
+   */
+  FIXED_ROW = 1,
+
+  /**
+   * Fixed-width records stored as one contiguous minipage per column (PAX).
+   */
+  FIXED_PAX = 2,
+
+  /**
+   * One chunk of a record too large for a page.
+   */
+  OVERFLOW = 3
+};
+
 /**
  * @brief Header metadata in a page.
  *
@@ -59,6 +84,11 @@ struct PageHeader {
    */
   PageId next_page_number;
 
+  /**
+   * Format of the data area; one of the PageType values.
+   */
+  std::uint16_t page_type;
+
   /**
    * Returns true if this page header is equal to the other.
    *
@@ -68,7 +98,8 @@ struct PageHeader {
   bool operator==(const PageHeader &rhs) const {
     return num_slots == rhs.num_slots && num_free_slots == rhs.num_free_slots &&
            current_page_number == rhs.current_page_number &&
-           next_page_number == rhs.next_page_number;
+           next_page_number == rhs.next_page_number &&
+           page_type == rhs.page_type;
   }
 };
 
@@ -76,12 +107,23 @@ struct PageHeader {
  * @brief Slot metadata that tracks where a record is in the data space.
  */
 struct PageSlot {
+  /**
+   * Flag marking a record that holds an OverflowPointer rather than data.
+   */
+  static const std::uint8_t OVERFLOW_POINTER = 0x1;
+
   /**
    * Whether the slot currently holds data.  May be false if this slot's
    * record has been deleted after insertion.
    */
   bool used;
 
+  /**
+   * Flags describing the record, e.g. OVERFLOW_POINTER; 0 for plain data.
+   * Occupies what used to be padding, so the slot size is unchanged.
+   */
+  std::uint8_t flags;
+
   /**
    * Offset of the data item in the page.
    */
@@ -93,7 +135,9 @@ struct PageSlot {
   std::uint16_t item_length;
 };
 
+class BufMgr;
 class PageIterator;
+class RecordBatch;
 
 /**
  * @brief Class which represents a fixed-size database page containing records.
@@ -129,17 +173,59 @@ class Page {
   static const SlotId INVALID_SLOT = 0;
 
   /**
-   * Constructs a new, uninitialized page.
+   * Tag selecting the constructor that leaves a page's contents unset.
+   */
+  struct Uninitialized {};
+
+  /**
+   * Constructs a new, empty page.
    */
   Page();
 
+  /**
+   * Constructs a page with a zeroed header and unset data, for callers about
+   * to overwrite the whole page, e.g. by reading it from disk.  Saves
+   * clearing the data area.  The page must be fully overwritten before any
+   * other use.
+   */
+  explicit Page(Uninitialized);
+
+  /**
+   * Constructs a copy of <other>.  Like all pages, the copy takes its data
+   * buffer from the PageBufferPool.
+   */
+  Page(const Page &other);
+
+  /**
+   * Constructs a page taking over the contents of <other>, which is left
+   * without data and may only be destroyed or assigned to.
+   */
+  Page(Page &&other) noexcept;
+
+  /**
+   * Copies <other> into this page's existing data buffer.
+   */
+  Page &operator=(const Page &other);
+
+  /**
+   * Exchanges the contents of this page and <other>.
+   */
+  Page &operator=(Page &&other) noexcept;
+
+  /**
+   * Returns the data buffer to the PageBufferPool.
+   */
+  ~Page();
+
   /**
    * Inserts a new record into the page.
    *
    * @param record_data  Bytes that compose the record.
+   * @param flags        PageSlot flags to store with the record.
    * @return  ID of the newly inserted record.
    */
-  RecordId insertRecord(const std::string &record_data);
+  RecordId insertRecord(const std::string &record_data,
+                        const std::uint8_t flags = 0);
 
   /**
    * Returns the record with the given ID.  Returned data is a copy of what is
@@ -158,8 +244,18 @@ class Page {
    *
    * @param record_id   ID of record to update.
    * @param record_data Updated bytes that compose the record.
+   * @param flags       PageSlot flags to store with the new version.
    */
-  void updateRecord(const RecordId &record_id, const std::string &record_data);
+  void updateRecord(const RecordId &record_id, const std::string &record_data,
+                    const std::uint8_t flags = 0);
+
+  /**
+   * Returns the PageSlot flags stored with the record with the given ID.
+   *
+   * @param record_id  ID of the record.
+   * @return  The flags.
+   */
+  std::uint8_t getRecordFlags(const RecordId &record_id) const;
 
   /**
    * Deletes the record with the given ID.  Page is compacted upon delete to
@@ -201,6 +297,29 @@ class Page {
    */
   PageId next_page_number() const { return header_.next_page_number; }
 
+  /**
+   * Returns the format of this page's data area.
+   *
+   * @return  Page type.
+   */
+  PageType page_type() const {
+    return static_cast<PageType>(header_.page_type);
+  }
+
+  /**
+   * Appends views of the used records after slot <start_after> to <batch>,
+   * stopping when either the page or the batch is exhausted.  The views point
+   * into this page and remain valid only while it is neither modified nor
+   * evicted.
+   *
+   * @param start_after Slot to start after; Page::INVALID_SLOT starts at the
+   *                    first slot.
+   * @param batch       Batch to append views to.
+   * @return  Slot to resume after if the batch filled up before the page ran
+   *          out of records; Page::INVALID_SLOT once the page is exhausted.
+   */
+  SlotId appendRecordViews(const SlotId start_after, RecordBatch &batch) const;
+
   /**
    * Returns an iterator at the first record in the page.
    *
@@ -298,16 +417,19 @@ class Page {
    *
    * @param slot_number   Number of slot to insert record into.
    * @param record_data   Bytes that compose the record.
+   * @param flags         PageSlot flags to store with the record.
    * @throws  InvalidSlotException  Thrown when given slot number refers to an
    *                                unallocated slot.
    * @throws  SlotInUseException  Thrown when given slot is in use.
    */
   void insertRecordInSlot(const SlotId slot_number,
-                          const std::string &record_data);
+                          const std::string &record_data,
+                          const std::uint8_t flags);
 
   /**
    * Throws an exception if the given record ID is not valid for this page
-   * (i.e., it has the right page number and the slot it references is in use).
+   * (i.e., it has the right page number, the page is a slotted page and the
+   * slot it references is in use).
    *
    * @param record_id   Record ID to validate.
    * @throws  InvalidRecordException  Thrown if the ID has a bad page or slot
@@ -334,12 +456,27 @@ class Page {
 
   std::string data_;
 
+  /**
+   * Buffer manager whose pool holds this page as a frame, or NULL.  Set once
+   * for every frame and never copied, so that accessors can restore swizzled
+   * swips from the page alone.
+   */
+  BufMgr *pool_ = NULL;
+
+  friend class BufMgr;
+  friend class CompressedCache;
   friend class File;
+  friend class FixedPage;
+  friend class OverflowPage;
   friend class PageIterator;
+  friend class SsdCache;
   friend class PageTest;
   friend class BufferTest;
 };
 
+static_assert(sizeof(PageSlot) == 6,
+              "Slot flags must fit in the slot's padding.");
+
 static_assert(Page::SIZE > sizeof(PageHeader),
               "Page size must be large enough to hold header and data.");
 static_assert(Page::DATA_SIZE > 0, "Page must have some space to hold data.");
@@ -0,0 +1,69 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "page_buffer_pool.h"
+
+#include <utility>
+#include <vector>
+
+#include "page.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Set once the calling thread's cache has been destroyed.  Pages destroyed
+ * after that, e.g. by static destructors, free their buffers instead.
+ */
+thread_local bool cache_destroyed = false;
+
+/**
+ * Number of buffers allocated by the calling thread.
+ */
+thread_local std::size_t num_allocations = 0;
+
+/**
+ * Buffers kept for reuse by the calling thread.
+ */
+struct BufferCache {
+  BufferCache() { buffers.reserve(PageBufferPool::MAX_CACHED); }
+  ~BufferCache() { cache_destroyed = true; }
+
+  std::vector<std::string> buffers;
+};
+
+thread_local BufferCache cache;
+
+}  // namespace
+
+std::string PageBufferPool::acquire() {
+  if (!cache_destroyed && !cache.buffers.empty()) {
+    std::string buffer = std::move(cache.buffers.back());
+    cache.buffers.pop_back();
+    return buffer;
+  }
+  ++num_allocations;
+  return std::string(Page::DATA_SIZE, char());
+}
+
+void PageBufferPool::release(std::string &&buffer) {
+  if (cache_destroyed || buffer.size() != Page::DATA_SIZE ||
+      cache.buffers.size() >= MAX_CACHED) {
+    return;
+  }
+  cache.buffers.push_back(std::move(buffer));
+}
+
+std::size_t PageBufferPool::cached() {
+  return cache_destroyed ? 0 : cache.buffers.size();
+}
+
+std::size_t PageBufferPool::allocations() { return num_allocations; }
+
+}  // namespace badgerdb
@@ -0,0 +1,59 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace badgerdb {
+
+/**
+ * @brief Recycles the data buffers of Page objects.
+ *
+ * Every Page owns a buffer of Page::DATA_SIZE bytes.  Pages outside the
+ * buffer pool are mostly short-lived copies, such as the ones returned by
+ * File::readPage() and FileIterator, so instead of freeing a buffer when its
+ * page is destroyed it is kept for the next page constructed on the same
+ * thread.  Each thread keeps up to MAX_CACHED buffers; further ones are
+ * freed.
+ *
+ * All methods are threadsafe; no state is shared between threads.
+ */
+class PageBufferPool {
+ public:
+  /**
+   * Maximum number of buffers kept per thread.
+   */
+  static const std::size_t MAX_CACHED = 64;
+
+  /**
+   * Returns a buffer of Page::DATA_SIZE bytes with unspecified contents,
+   * recycled if one is available.
+   */
+  static std::string acquire();
+
+  /**
+   * Takes back <buffer> for reuse.  Buffers of the wrong size, such as ones
+   * moved from, are ignored.
+   */
+  static void release(std::string &&buffer);
+
+  /**
+   * Returns the number of buffers the calling thread keeps for reuse.
+   */
+  static std::size_t cached();
+
+  /**
+   * Returns the number of buffers the calling thread had to allocate
+   * because none was available for reuse.
+   */
+  static std::size_t allocations();
+};
+
+}  // namespace badgerdb
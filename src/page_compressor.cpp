@@ -0,0 +1,174 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "page_compressor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Log2 of the number of hash table entries.
+ */
+const int HASH_BITS = 12;
+
+/**
+ * Farthest back reference.
+ */
+const std::size_t MAX_OFFSET = 65535;
+
+/**
+ * Value of a token nibble meaning that length bytes follow.
+ */
+const std::size_t NIBBLE_MAX = 15;
+
+std::uint32_t load32(const char *p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::uint32_t hash32(const std::uint32_t value) {
+  return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void appendLength(std::size_t length, std::string *out) {
+  for (; length >= 255; length -= 255) {
+    out->push_back(static_cast<char>(255));
+  }
+  out->push_back(static_cast<char>(length));
+}
+
+bool readLength(const unsigned char *data, const std::size_t length,
+                std::size_t *ip, std::size_t *value) {
+  unsigned char byte;
+  do {
+    if (*ip >= length) {
+      return false;
+    }
+    byte = data[(*ip)++];
+    *value += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * Appends a token with the literals in [<literals>, <literals> +
+ * <num_literals>) followed by a match of <match_length> bytes <offset> back,
+ * or by no match if <match_length> is 0.
+ */
+void appendSequence(const char *literals, const std::size_t num_literals,
+                    const std::size_t offset, const std::size_t match_length,
+                    std::string *out) {
+  const std::size_t match_code =
+      match_length == 0 ? 0 : match_length - PageCompressor::MIN_MATCH;
+  out->push_back(static_cast<char>((std::min(num_literals, NIBBLE_MAX) << 4) |
+                                   std::min(match_code, NIBBLE_MAX)));
+  if (num_literals >= NIBBLE_MAX) {
+    appendLength(num_literals - NIBBLE_MAX, out);
+  }
+  out->append(literals, num_literals);
+  if (match_length == 0) {
+    return;
+  }
+  out->push_back(static_cast<char>(offset & 0xff));
+  out->push_back(static_cast<char>(offset >> 8));
+  if (match_code >= NIBBLE_MAX) {
+    appendLength(match_code - NIBBLE_MAX, out);
+  }
+}
+
+}  // namespace
+
+void PageCompressor::compress(const char *data, const std::size_t length,
+                              std::string *out) {
+  std::int32_t table[1 << HASH_BITS];
+  std::fill(table, table + (1 << HASH_BITS), -1);
+  std::size_t anchor = 0;
+  std::size_t pos = 0;
+  while (pos + MIN_MATCH <= length) {
+    const std::uint32_t prefix = load32(data + pos);
+    std::int32_t &slot = table[hash32(prefix)];
+    const std::int32_t candidate = slot;
+    slot = static_cast<std::int32_t>(pos);
+    if (candidate < 0 || pos - candidate > MAX_OFFSET ||
+        load32(data + candidate) != prefix) {
+      pos++;
+      continue;
+    }
+    std::size_t match_length = MIN_MATCH;
+    while (pos + match_length < length &&
+           data[candidate + match_length] == data[pos + match_length]) {
+      match_length++;
+    }
+    appendSequence(data + anchor, pos - anchor, pos - candidate, match_length,
+                   out);
+    pos += match_length;
+    anchor = pos;
+  }
+  if (anchor < length) {
+    appendSequence(data + anchor, length - anchor, 0, 0, out);
+  }
+}
+
+bool PageCompressor::decompress(const char *data, const std::size_t length,
+                                char *out, const std::size_t out_length) {
+  const unsigned char *in = reinterpret_cast<const unsigned char *>(data);
+  std::size_t ip = 0;
+  std::size_t op = 0;
+  while (ip < length) {
+    const unsigned char token = in[ip++];
+    std::size_t num_literals = token >> 4;
+    if (num_literals == NIBBLE_MAX &&
+        !readLength(in, length, &ip, &num_literals)) {
+      return false;
+    }
+    if (num_literals > length - ip || num_literals > out_length - op) {
+      return false;
+    }
+    std::memcpy(out + op, data + ip, num_literals);
+    ip += num_literals;
+    op += num_literals;
+    if (ip == length) {
+      break;
+    }
+
+    if (length - ip < 2) {
+      return false;
+    }
+    const std::size_t offset = in[ip] | (std::size_t(in[ip + 1]) << 8);
+    ip += 2;
+    std::size_t match_length = token & NIBBLE_MAX;
+    if (match_length == NIBBLE_MAX &&
+        !readLength(in, length, &ip, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > op || match_length > out_length - op) {
+      return false;
+    }
+    if (offset == 1) {
+      std::memset(out + op, out[op - 1], match_length);
+    } else if (offset >= match_length) {
+      std::memcpy(out + op, out + op - offset, match_length);
+    } else {
+      // Overlapping reference: repeats the last <offset> bytes.
+      for (std::size_t i = 0; i < match_length; ++i) {
+        out[op + i] = out[op + i - offset];
+      }
+    }
+    op += match_length;
+  }
+  return op == out_length;
+}
+
+}  // namespace badgerdb
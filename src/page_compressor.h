@@ -0,0 +1,49 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace badgerdb {
+
+/**
+ * @brief Fast byte-oriented LZ77 codec for page contents.
+ *
+ * The format follows LZ4 blocks: a sequence of tokens, each holding a run of
+ * literals and a back reference of at least MIN_MATCH bytes up to 64 KiB
+ * back.  Matches are found through a small hash table of 4-byte prefixes, so
+ * runs of equal bytes such as the free space in the middle of a slotted page
+ * shrink to a few bytes.  Compression speed matters more than ratio here.
+ */
+class PageCompressor {
+ public:
+  /**
+   * Shortest back reference.
+   */
+  static const std::size_t MIN_MATCH = 4;
+
+  /**
+   * Compresses the <length> bytes at <data>, appending the result to <out>.
+   */
+  static void compress(const char *data, const std::size_t length,
+                       std::string *out);
+
+  /**
+   * Decompresses the <length> bytes at <data> into the <out_length> bytes at
+   * <out>.
+   *
+   * @return  False if the input is malformed or does not expand to exactly
+   *          <out_length> bytes.
+   */
+  static bool decompress(const char *data, const std::size_t length, char *out,
+                         const std::size_t out_length);
+};
+
+}  // namespace badgerdb
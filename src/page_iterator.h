@@ -99,6 +99,13 @@ class PageIterator {
     return page_->getRecord(current_record_);
   }
 
+  /**
+   * Returns the ID of the current record.
+   *
+   * @return  Record ID.
+   */
+  const RecordId &current_record() const { return current_record_; }
+
   /**
    * Returns the next used slot in the page after the given slot or
    * Page::INVALID_SLOT if no slots are used after the given slot.
@@ -0,0 +1,151 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+
+namespace badgerdb {
+
+/**
+ * @brief How a pinned page is latched.
+ */
+enum class LatchMode {
+  /**
+   * No latch; the caller synchronizes access to the page itself.
+   */
+  NONE,
+
+  /**
+   * Shared latch; any number of readers may hold it at once.
+   */
+  SHARED,
+
+  /**
+   * Exclusive latch; excludes all other latch holders.
+   */
+  EXCLUSIVE
+};
+
+/**
+ * @brief Reader-writer latch guarding one buffer frame, with a version
+ * counter for optimistic reads.
+ *
+ * The version is odd while the latch is held exclusively or the frame is
+ * being refilled, and is incremented whenever either begins or ends and
+ * whenever the frame gives up its page.  A reader that wants to avoid
+ * latching reads the version, reads the page and then calls validate(); if
+ * validation fails, a writer may have changed the page in between and the
+ * read must be retried.
+ *
+ * Each latch fills its own cache line so that latching one frame does not
+ * slow down accesses to its neighbours.  All operations are threadsafe.
+ */
+class alignas(64) FrameLatch {
+ public:
+  FrameLatch() : version_(0) {}
+
+  FrameLatch(const FrameLatch &) = delete;
+  FrameLatch &operator=(const FrameLatch &) = delete;
+
+  /**
+   * Blocks until the latch can be held in shared mode.
+   */
+  void lockShared() { mutex_.lock_shared(); }
+
+  /**
+   * Takes the latch in shared mode if that is possible without blocking.
+   *
+   * @return  True if the latch was taken.
+   */
+  bool tryLockShared() { return mutex_.try_lock_shared(); }
+
+  /**
+   * Releases a shared hold.
+   */
+  void unlockShared() { mutex_.unlock_shared(); }
+
+  /**
+   * Blocks until the latch can be held exclusively, waiting for current
+   * shared holders to leave.
+   */
+  void lockExclusive() {
+    mutex_.lock();
+    version_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  /**
+   * Takes the latch exclusively if that is possible without blocking.
+   *
+   * @return  True if the latch was taken.
+   */
+  bool tryLockExclusive() {
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+    version_.fetch_add(1, std::memory_order_acq_rel);
+    return true;
+  }
+
+  /**
+   * Releases an exclusive hold.
+   */
+  void unlockExclusive() {
+    version_.fetch_add(1, std::memory_order_release);
+    mutex_.unlock();
+  }
+
+  /**
+   * Marks the start of replacing the frame's contents with another page.
+   * The caller must make sure nobody holds or waits for the latch.
+   */
+  void beginRewrite() { version_.fetch_add(1, std::memory_order_acq_rel); }
+
+  /**
+   * Marks the end of replacing the frame's contents.
+   */
+  void endRewrite() { version_.fetch_add(1, std::memory_order_release); }
+
+  /**
+   * Records that the frame no longer holds its page, failing all optimistic
+   * reads that started before.
+   */
+  void retire() { version_.fetch_add(2, std::memory_order_release); }
+
+  /**
+   * Returns the current version; odd if a writer holds the latch.
+   */
+  std::uint64_t version() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Returns true if no writer held the latch since version() returned
+   * <version>.  Only reads the latch.
+   */
+  bool validate(const std::uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (version & 1) == 0 &&
+           version_.load(std::memory_order_relaxed) == version;
+  }
+
+ private:
+  /**
+   * Reader-writer lock behind the shared and exclusive modes.
+   */
+  std::shared_mutex mutex_;
+
+  /**
+   * Version counter; odd while held exclusively.
+   */
+  std::atomic<std::uint64_t> version_;
+};
+
+}  // namespace badgerdb
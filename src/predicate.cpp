@@ -0,0 +1,127 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "predicate.h"
+
+#include <cstring>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Evaluates a field comparison on a single record.
+ */
+template <typename T>
+bool matchField(const RecordView &view, const std::size_t offset,
+                const CompareOp op, const std::int64_t constant) {
+  if (offset + sizeof(T) > view.length) {
+    return false;
+  }
+  T value;
+  std::memcpy(&value, view.data + offset, sizeof(T));
+  const std::uint8_t present = 1;
+  std::uint32_t selected;
+  return kernels::selectCompare(&value, &present, 1, op,
+                                static_cast<T>(constant), &selected) == 1;
+}
+
+}  // namespace
+
+Predicate Predicate::compareField(const FieldType type,
+                                  const std::size_t offset, const CompareOp op,
+                                  const std::int64_t constant) {
+  Predicate predicate(Kind::FIELD);
+  predicate.type_ = type;
+  predicate.offset_ = offset;
+  predicate.op_ = op;
+  predicate.constant_ = constant;
+  return predicate;
+}
+
+Predicate Predicate::hasPrefix(const std::string &prefix) {
+  Predicate predicate(Kind::PREFIX);
+  predicate.prefix_ = prefix;
+  return predicate;
+}
+
+Predicate Predicate::matching(const Functor &functor) {
+  Predicate predicate(Kind::FUNCTOR);
+  predicate.functor_ = functor;
+  return predicate;
+}
+
+bool Predicate::matches(const RecordView &view) const {
+  switch (kind_) {
+    case Kind::FIELD:
+      switch (type_) {
+        case FieldType::INT32:
+          return matchField<std::int32_t>(view, offset_, op_, constant_);
+        case FieldType::UINT32:
+          return matchField<std::uint32_t>(view, offset_, op_, constant_);
+        case FieldType::INT64:
+          return matchField<std::int64_t>(view, offset_, op_, constant_);
+        case FieldType::UINT64:
+          return matchField<std::uint64_t>(view, offset_, op_, constant_);
+      }
+      return false;
+    case Kind::PREFIX:
+      return prefix_.length() <= view.length &&
+             std::memcmp(view.data, prefix_.data(), prefix_.length()) == 0;
+    case Kind::FUNCTOR:
+      return functor_(view.data, view.length);
+  }
+  return false;
+}
+
+std::size_t Predicate::filter(const RecordBatch &in, RecordBatch &out) const {
+  FilterScratch scratch;
+  return filter(in, out, scratch);
+}
+
+std::size_t Predicate::filter(const RecordBatch &in, RecordBatch &out,
+                              FilterScratch &scratch) const {
+  if (kind_ == Kind::FIELD) {
+    switch (type_) {
+      case FieldType::INT32:
+        return filterField<std::int32_t>(in, out, scratch);
+      case FieldType::UINT32:
+        return filterField<std::uint32_t>(in, out, scratch);
+      case FieldType::INT64:
+        return filterField<std::int64_t>(in, out, scratch);
+      case FieldType::UINT64:
+        return filterField<std::uint64_t>(in, out, scratch);
+    }
+  }
+  std::size_t count = 0;
+  for (const RecordView &view : in) {
+    if (matches(view)) {
+      out.append(view);
+      ++count;
+    }
+  }
+  return count;
+}
+
+template <typename T>
+std::size_t Predicate::filterField(const RecordBatch &in, RecordBatch &out,
+                                   FilterScratch &scratch) const {
+  const std::size_t n = in.size();
+  T *values = scratch.values<T>(n);
+  std::uint8_t *present = scratch.present(n);
+  std::uint32_t *selection = scratch.selection(n);
+  kernels::gatherField(in, offset_, values, present);
+  const std::size_t count = kernels::selectCompare(
+      values, present, n, op_, static_cast<T>(constant_), selection);
+  for (std::size_t i = 0; i < count; ++i) {
+    out.append(in[selection[i]]);
+  }
+  return count;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,198 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "filter_kernels.h"
+#include "record_batch.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Buffers that Predicate::filter() evaluates field comparisons in,
+ * kept by the caller so that they are reused across batches.
+ */
+class FilterScratch {
+ public:
+  /**
+   * Returns room for <n> values of type <T>.
+   */
+  template <typename T>
+  T *values(const std::size_t n) {
+    static_assert(sizeof(T) <= sizeof(std::uint64_t),
+                  "Fields are at most 8 bytes wide.");
+    values_.resize(n);
+    return reinterpret_cast<T *>(values_.data());
+  }
+
+  /**
+   * Returns room for <n> presence flags.
+   */
+  std::uint8_t *present(const std::size_t n) {
+    present_.resize(n);
+    return present_.data();
+  }
+
+  /**
+   * Returns room for <n> selected positions.
+   */
+  std::uint32_t *selection(const std::size_t n) {
+    selection_.resize(n);
+    return selection_.data();
+  }
+
+ private:
+  /**
+   * Field values; 8-byte words, so every field type is aligned.
+   */
+  std::vector<std::uint64_t> values_;
+
+  /**
+   * Flags telling which records hold the field.
+   */
+  std::vector<std::uint8_t> present_;
+
+  /**
+   * Positions of the matching records.
+   */
+  std::vector<std::uint32_t> selection_;
+};
+
+/**
+ * @brief Type of a fixed-width integer field compared by a Predicate.
+ */
+enum class FieldType { INT32, UINT32, INT64, UINT64 };
+
+/**
+ * @brief Filter evaluated directly on record bytes in a page.
+ *
+ * A predicate is one of:
+ * <ul>
+ *   <li>a comparison of a fixed-width integer field at a byte offset against
+ *       a constant,
+ *   <li>a byte-prefix match, or
+ *   <li>an arbitrary functor over the record bytes.
+ * </ul>
+ * Field comparisons over a batch are evaluated with the column kernels in
+ * filter_kernels.h.  Records too short to contain the field do not match.
+ */
+class Predicate {
+ public:
+  /**
+   * Functor called with the bytes of a record.
+   */
+  typedef std::function<bool(const char *data, std::uint16_t length)> Functor;
+
+  /**
+   * Returns a predicate comparing the field at <offset> with <constant>.
+   *
+   * @param type      Type of the field.
+   * @param offset    Byte offset of the field within the record.
+   * @param op        Comparison to apply (field op constant).
+   * @param constant  Constant to compare against; converted to <type>.
+   */
+  static Predicate compareField(const FieldType type, const std::size_t offset,
+                                const CompareOp op, const std::int64_t constant);
+
+  /**
+   * Returns a predicate matching records starting with <prefix>.
+   */
+  static Predicate hasPrefix(const std::string &prefix);
+
+  /**
+   * Returns a predicate calling <functor> on each record.
+   */
+  static Predicate matching(const Functor &functor);
+
+  /**
+   * Returns true if the record matches the predicate.
+   *
+   * @param view  Record to test.
+   */
+  bool matches(const RecordView &view) const;
+
+  /**
+   * Appends the views of <in> that match the predicate to <out>.  <out> must
+   * have room for all of <in>.
+   *
+   * @param in  Records to test.
+   * @param out Batch receiving the matching records.
+   * @return  Number of records appended.
+   */
+  std::size_t filter(const RecordBatch &in, RecordBatch &out) const;
+
+  /**
+   * Like filter(in, out), but evaluates field comparisons in <scratch>, so
+   * that scans filtering batch after batch allocate nothing per batch.
+   */
+  std::size_t filter(const RecordBatch &in, RecordBatch &out,
+                     FilterScratch &scratch) const;
+
+ private:
+  /**
+   * Kinds of predicate.
+   */
+  enum class Kind { FIELD, PREFIX, FUNCTOR };
+
+  explicit Predicate(const Kind kind)
+      : kind_(kind),
+        type_(FieldType::INT32),
+        offset_(0),
+        op_(CompareOp::EQ),
+        constant_(0) {}
+
+  /**
+   * Evaluates a field comparison over <in> with the column kernels.
+   */
+  template <typename T>
+  std::size_t filterField(const RecordBatch &in, RecordBatch &out,
+                          FilterScratch &scratch) const;
+
+  /**
+   * Kind of this predicate.
+   */
+  Kind kind_;
+
+  /**
+   * Field type for FIELD predicates.
+   */
+  FieldType type_;
+
+  /**
+   * Field offset for FIELD predicates.
+   */
+  std::size_t offset_;
+
+  /**
+   * Comparison for FIELD predicates.
+   */
+  CompareOp op_;
+
+  /**
+   * Constant for FIELD predicates.
+   */
+  std::int64_t constant_;
+
+  /**
+   * Prefix for PREFIX predicates.
+   */
+  std::string prefix_;
+
+  /**
+   * Functor for FUNCTOR predicates.
+   */
+  Functor functor_;
+};
+
+}  // namespace badgerdb
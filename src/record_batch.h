@@ -0,0 +1,132 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Non-owning reference to the bytes of a record on a page.
+ *
+ * A view is only valid while the page it points into stays pinned in the
+ * buffer pool and is not modified.
+ */
+struct RecordView {
+  /**
+   * ID of the record.
+   */
+  RecordId rid;
+
+  /**
+   * Pointer to the first byte of the record on the page.
+   */
+  const char *data;
+
+  /**
+   * Length of the record in bytes.
+   */
+  std::uint16_t length;
+};
+
+/**
+ * @brief Fixed-capacity array of record views filled by batch scans.
+ *
+ * A batch may span several pages.  Its storage is allocated once and reused
+ * across calls, so consumers can loop over the views without per-record
+ * allocations.
+ */
+class RecordBatch {
+ public:
+  /**
+   * Number of records in a batch unless a different capacity is requested.
+   */
+  static const std::size_t DEFAULT_CAPACITY = 1024;
+
+  /**
+   * Constructs an empty batch holding at most <capacity> records.
+   *
+   * @param capacity  Maximum number of records in the batch.
+   */
+  explicit RecordBatch(const std::size_t capacity = DEFAULT_CAPACITY)
+      : capacity_(capacity) {
+    assert(capacity_ > 0);
+    views_.reserve(capacity_);
+  }
+
+  /**
+   * Appends a view to the batch.  The batch must not be full.
+   *
+   * @param view  View to append.
+   */
+  void append(const RecordView &view) {
+    assert(!full());
+    views_.push_back(view);
+  }
+
+  /**
+   * Removes all views from the batch, keeping its storage.
+   */
+  void clear() { views_.clear(); }
+
+  /**
+   * Returns the number of views in the batch.
+   */
+  std::size_t size() const { return views_.size(); }
+
+  /**
+   * Returns the maximum number of views in the batch.
+   */
+  std::size_t capacity() const { return capacity_; }
+
+  /**
+   * Returns true if the batch holds no views.
+   */
+  bool empty() const { return views_.empty(); }
+
+  /**
+   * Returns true if no more views can be appended.
+   */
+  bool full() const { return views_.size() >= capacity_; }
+
+  /**
+   * Returns the view at the given position.
+   */
+  const RecordView &operator[](const std::size_t index) const {
+    return views_[index];
+  }
+
+  /**
+   * Returns a pointer to the first view in the batch.
+   */
+  const RecordView *begin() const { return views_.data(); }
+
+  /**
+   * Returns a pointer past the last view in the batch.
+   */
+  const RecordView *end() const { return views_.data() + views_.size(); }
+
+ private:
+  /**
+   * Maximum number of views in the batch.
+   */
+  std::size_t capacity_;
+
+  /**
+   * Views currently in the batch.
+   */
+  std::vector<RecordView> views_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,48 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "record_writer.h"
+
+#include <cassert>
+
+namespace badgerdb {
+
+RecordWriter::RecordWriter(BufMgr *bufMgr, File *file)
+    : bufMgr_(bufMgr),
+      file_(file),
+      page_(NULL),
+      page_number_(Page::INVALID_NUMBER),
+      num_records_(0),
+      num_pages_(0) {
+  assert(bufMgr_ != NULL);
+}
+
+RecordWriter::~RecordWriter() { close(); }
+
+RecordId RecordWriter::append(const char *data, const std::size_t length) {
+  scratch_.assign(data, length);
+  if (page_ != NULL && !page_->hasSpaceForRecord(scratch_)) {
+    close();
+  }
+  if (page_ == NULL) {
+    bufMgr_->allocPage(*file_, page_number_, page_);
+    ++num_pages_;
+  }
+  const RecordId record_id = page_->insertRecord(scratch_);
+  ++num_records_;
+  return record_id;
+}
+
+void RecordWriter::close() {
+  if (page_ != NULL) {
+    bufMgr_->unPinPage(*file_, page_number_, true /* dirty */);
+    page_ = NULL;
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,121 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Appends records to a file, packing them into pages allocated through
+ * the buffer manager.
+ *
+ * At most one page of the file is pinned at a time.  A new page is allocated
+ * whenever the current one cannot hold the next record.
+ *
+ * @warning This class is not threadsafe.
+ */
+class RecordWriter {
+ public:
+  /**
+   * Constructs a writer appending to <file>.
+   *
+   * @param bufMgr  Buffer manager used to allocate pages.
+   * @param file    File to append to.
+   */
+  RecordWriter(BufMgr *bufMgr, File *file);
+
+  /**
+   * Unpins the page being filled.
+   */
+  ~RecordWriter();
+
+  RecordWriter(const RecordWriter &) = delete;
+  RecordWriter &operator=(const RecordWriter &) = delete;
+
+  /**
+   * Appends a record.
+   *
+   * @param data    Bytes of the record.
+   * @param length  Number of bytes.
+   * @return  ID of the new record.
+   * @throws  InsufficientSpaceException  If the record does not fit on an
+   *                                      empty page.
+   */
+  RecordId append(const char *data, const std::size_t length);
+
+  /**
+   * Appends a record.
+   *
+   * @param record_data Bytes of the record.
+   * @return  ID of the new record.
+   */
+  RecordId append(const std::string &record_data) {
+    return append(record_data.data(), record_data.length());
+  }
+
+  /**
+   * Unpins the page being filled.  Further appends start a new page.
+   */
+  void close();
+
+  /**
+   * Returns the number of records appended.
+   */
+  std::uint64_t num_records() const { return num_records_; }
+
+  /**
+   * Returns the number of pages allocated.
+   */
+  PageId num_pages() const { return num_pages_; }
+
+ private:
+  /**
+   * Buffer manager pages are allocated through.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * File being appended to.
+   */
+  File *file_;
+
+  /**
+   * Page being filled; pinned if not NULL.
+   */
+  Page *page_;
+
+  /**
+   * Number of the page being filled.
+   */
+  PageId page_number_;
+
+  /**
+   * Reused buffer holding the record being inserted.
+   */
+  std::string scratch_;
+
+  /**
+   * Number of records appended.
+   */
+  std::uint64_t num_records_;
+
+  /**
+   * Number of pages allocated.
+   */
+  PageId num_pages_;
+};
+
+}  // namespace badgerdb
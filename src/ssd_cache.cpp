@@ -0,0 +1,127 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "ssd_cache.h"
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cassert>
+
+#include "exceptions/file_not_found_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+off_t slotOffset(const std::size_t slot) {
+  return static_cast<off_t>(slot) * Page::SIZE;
+}
+
+}  // namespace
+
+SsdCache::SsdCache(const std::string &path, const std::size_t capacity)
+    : fd_(::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600)),
+      tail_(0),
+      owners_(capacity),
+      versions_(capacity) {
+  assert(capacity > 0);
+  if (fd_ < 0) {
+    throw FileNotFoundException(path);
+  }
+  ::unlink(path.c_str());
+}
+
+SsdCache::~SsdCache() { ::close(fd_); }
+
+bool SsdCache::read(const File &file, const PageId page_number, Page *page) {
+  const Key key(file.filename(), page_number);
+  std::size_t slot;
+  std::uint64_t version;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::map<Key, std::size_t>::iterator it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+    slot = it->second;
+    version = versions_[slot];
+  }
+  struct iovec iov[] = {{&page->header_, sizeof(page->header_)},
+                        {&page->data_[0], Page::DATA_SIZE}};
+  const bool complete = ::preadv(fd_, iov, 2, slotOffset(slot)) ==
+                        static_cast<ssize_t>(Page::SIZE);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (versions_[slot] != version) {
+    // The slot was given to another page while it was read.
+    return false;
+  }
+  if (!complete) {
+    // Treat an unreadable slot as a miss; the file still has the page.
+    index_.erase(owners_[slot]);
+    owners_[slot] = Key();
+    return false;
+  }
+  return true;
+}
+
+bool SsdCache::write(const File &file, const Page &page) {
+  Key key(file.filename(), page.page_number());
+  std::size_t slot;
+  std::uint64_t version;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(key) > 0) {
+      return false;
+    }
+    slot = tail_;
+    tail_ = (tail_ + 1) % owners_.size();
+    if (!owners_[slot].first.empty()) {
+      index_.erase(owners_[slot]);
+      owners_[slot] = Key();
+    }
+    version = ++versions_[slot];
+  }
+  struct iovec iov[] = {
+      {const_cast<PageHeader *>(&page.header_), sizeof(page.header_)},
+      {const_cast<char *>(page.data_.data()), Page::DATA_SIZE}};
+  const bool complete = ::pwritev(fd_, iov, 2, slotOffset(slot)) ==
+                        static_cast<ssize_t>(Page::SIZE);
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Out of space on the cache device, the slot was reassigned, or the page
+  // was cached by another thread meanwhile; the page is only in the file.
+  if (!complete || versions_[slot] != version || index_.count(key) > 0) {
+    return false;
+  }
+  index_[key] = slot;
+  owners_[slot] = std::move(key);
+  return true;
+}
+
+void SsdCache::invalidate(const File &file, const PageId page_number) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::map<Key, std::size_t>::iterator it =
+      index_.find(Key(file.filename(), page_number));
+  if (it != index_.end()) {
+    owners_[it->second] = Key();
+    index_.erase(it);
+  }
+}
+
+void SsdCache::invalidateFile(const File &file) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<Key, std::size_t>::iterator it =
+      index_.lower_bound(Key(file.filename(), 0));
+  while (it != index_.end() && it->first.first == file.filename()) {
+    owners_[it->second] = Key();
+    it = index_.erase(it);
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,137 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "file.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Second-level page cache in a local file, meant for a fast SSD below
+ * the buffer pool.
+ *
+ * Pages are appended to a circular log of <capacity> page slots, so every
+ * write is sequential; when the log wraps, the oldest slot is overwritten and
+ * its page is forgotten.  Which slot holds which page is kept in memory only,
+ * so the cache starts empty and its file is unlinked as soon as it is opened.
+ *
+ * The cache holds clean copies of pages: a copy must be invalidated before
+ * the page changes in the file or in the buffer pool.  BufMgr does this for
+ * pages changed through it; files must be invalidated before they are
+ * removed, since a new file of the same name would otherwise see old pages.
+ *
+ * All methods are threadsafe.  The slot index is updated under a lock, but
+ * pages are read and written without it: a read checks afterwards that its
+ * slot was not reassigned meanwhile and counts as a miss otherwise.
+ */
+class SsdCache {
+ public:
+  /**
+   * Creates the cache file.
+   *
+   * @param path      Name of the cache file, e.g. on a local NVMe drive.
+   * @param capacity  Number of pages the cache holds.
+   * @throws  FileNotFoundException  If the file could not be created.
+   */
+  SsdCache(const std::string &path, const std::size_t capacity);
+
+  /**
+   * Closes the cache file, releasing its space.
+   */
+  ~SsdCache();
+
+  SsdCache(const SsdCache &) = delete;
+  SsdCache &operator=(const SsdCache &) = delete;
+
+  /**
+   * Reads page <page_number> of <file> into <page> if it is cached.
+   *
+   * @return  True on a hit.
+   */
+  bool read(const File &file, const PageId page_number, Page *page);
+
+  /**
+   * Appends <page> of <file> to the log unless it is cached already.
+   *
+   * @return  True if the page was written.
+   */
+  bool write(const File &file, const Page &page);
+
+  /**
+   * Forgets page <page_number> of <file>, if cached.
+   */
+  void invalidate(const File &file, const PageId page_number);
+
+  /**
+   * Forgets all pages of <file>.
+   */
+  void invalidateFile(const File &file);
+
+  /**
+   * Returns the number of pages the cache holds at most.
+   */
+  std::size_t capacity() const { return owners_.size(); }
+
+  /**
+   * Returns the number of pages cached.
+   */
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+  }
+
+ private:
+  /**
+   * File name and page number of a cached page.
+   */
+  typedef std::pair<std::string, PageId> Key;
+
+  /**
+   * Protects tail_, index_, owners_ and versions_.
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * Descriptor of the cache file.
+   */
+  int fd_;
+
+  /**
+   * Slot written next.
+   */
+  std::size_t tail_;
+
+  /**
+   * Slot of every cached page.
+   */
+  std::map<Key, std::size_t> index_;
+
+  /**
+   * Page held by every slot; an empty file name marks a free slot.
+   */
+  std::vector<Key> owners_;
+
+  /**
+   * Number of times every slot was reassigned; lets a read tell whether its
+   * slot was overwritten while the lock was not held.
+   */
+  std::vector<std::uint64_t> versions_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,100 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Page reference stored inside a page that can be swizzled into a
+ * direct reference to the buffer frame holding the target page.
+ *
+ * A swip has the size and on-disk format of a PageId, so any PageId field in
+ * a page can be used as a swip.  While the target is resident, the buffer
+ * manager may replace the page number by the number of its frame, tagged
+ * with SWIZZLED_BIT; following the swip then needs no hash table lookup.
+ * The buffer manager restores the page number before the target leaves its
+ * frame and before the page holding the swip is written, so swizzled values
+ * never reach disk.  Page numbers must therefore be below SWIZZLED_BIT.
+ *
+ * The word is read and written atomically, so a swip may be inspected while
+ * the buffer manager swizzles or unswizzles it.  It must be 4-byte aligned.
+ */
+class Swip {
+ public:
+  /**
+   * Marks a swizzled swip.
+   */
+  static const std::uint32_t SWIZZLED_BIT = 0x80000000u;
+
+  /**
+   * Constructs a swip referring to page <page_number>.
+   */
+  explicit Swip(const PageId page_number) : word_(page_number) {
+    assert((page_number & SWIZZLED_BIT) == 0);
+  }
+
+  /**
+   * Returns true if the swip holds a frame reference.
+   */
+  bool isSwizzled() const { return (load() & SWIZZLED_BIT) != 0; }
+
+  /**
+   * Returns the page number; the swip must not be swizzled.
+   */
+  PageId page_number() const {
+    const std::uint32_t word = load();
+    assert((word & SWIZZLED_BIT) == 0);
+    return word;
+  }
+
+  /**
+   * Returns the frame referenced; the swip must be swizzled.
+   */
+  FrameId frame() const {
+    const std::uint32_t word = load();
+    assert((word & SWIZZLED_BIT) != 0);
+    return word & ~SWIZZLED_BIT;
+  }
+
+ private:
+  friend class BufMgr;
+
+  /**
+   * Makes the swip refer to page <page_number>.
+   */
+  void unswizzle(const PageId page_number) { store(page_number); }
+
+  /**
+   * Makes the swip refer to frame <frame>.
+   */
+  void swizzle(const FrameId frame) { store(frame | SWIZZLED_BIT); }
+
+  std::uint32_t load() const {
+    return __atomic_load_n(&word_, __ATOMIC_ACQUIRE);
+  }
+
+  void store(const std::uint32_t word) {
+    __atomic_store_n(&word_, word, __ATOMIC_RELEASE);
+  }
+
+  /**
+   * Page number, or frame number with SWIZZLED_BIT set.
+   */
+  std::uint32_t word_;
+};
+
+static_assert(sizeof(Swip) == sizeof(PageId),
+              "A swip must have the size of a page number.");
+
+}  // namespace badgerdb
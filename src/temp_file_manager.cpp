@@ -0,0 +1,65 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "temp_file_manager.h"
+
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+#include "exceptions/badgerdb_exception.h"
+#include "exceptions/file_not_found_exception.h"
+
+namespace badgerdb {
+
+TempFileManager::TempFileManager(BufMgr *bufMgr, const std::string &parent_dir)
+    : bufMgr_(bufMgr), counter_(0) {
+  assert(bufMgr_ != NULL);
+  std::string parent = parent_dir;
+  if (parent.empty()) {
+    const char *tmpdir = std::getenv("TMPDIR");
+    parent = tmpdir != NULL && *tmpdir != '\0' ? tmpdir : "/tmp";
+  }
+  std::vector<char> path(parent.begin(), parent.end());
+  const std::string pattern = "/badgerdb-XXXXXX";
+  path.insert(path.end(), pattern.begin(), pattern.end());
+  path.push_back('\0');
+  if (::mkdtemp(path.data()) == NULL) {
+    throw FileNotFoundException(parent);
+  }
+  directory_ = path.data();
+}
+
+TempFileManager::~TempFileManager() {
+  for (std::map<std::string, File>::iterator it = files_.begin();
+       it != files_.end(); ++it) {
+    try {
+      bufMgr_->invalidateFile(it->second);
+    } catch (const BadgerDbException &) {
+      // A page is still pinned; its frames stay until the pin is released.
+    }
+  }
+  files_.clear();
+  ::rmdir(directory_.c_str());
+}
+
+File TempFileManager::create() {
+  const std::string name = directory_ + "/" + std::to_string(counter_++);
+  File file = File::createAnonymous(name);
+  files_.insert(std::make_pair(name, file));
+  return file;
+}
+
+void TempFileManager::drop(File &file) {
+  bufMgr_->invalidateFile(file);
+  files_.erase(file.filename());
+}
+
+}  // namespace badgerdb
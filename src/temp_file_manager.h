@@ -0,0 +1,102 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+#include "buffer.h"
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Creates and drops short-lived files, such as the runs and partitions
+ * that operators spill to.
+ *
+ * All temporary files live in a private directory created with the manager.
+ * A file is unlinked from that directory as soon as it is created, so
+ * creating one needs no existence check and the disk space is returned once
+ * the last File object referring to it goes away, even after a crash.
+ * Dropping a file discards its pages from the buffer pool without writing
+ * them back.  Files still alive when the manager is destroyed are dropped
+ * and the directory is removed.
+ *
+ * @warning This class is not threadsafe.
+ */
+class TempFileManager {
+ public:
+  /**
+   * Creates the temporary directory.
+   *
+   * @param bufMgr      Buffer manager caching pages of the temporary files.
+   * @param parent_dir  Directory to create the temporary directory in; if
+   *                    empty, $TMPDIR or /tmp.
+   * @throws  FileNotFoundException  If the directory could not be created.
+   */
+  explicit TempFileManager(BufMgr *bufMgr,
+                           const std::string &parent_dir = std::string());
+
+  /**
+   * Drops all remaining files and removes the temporary directory.
+   */
+  ~TempFileManager();
+
+  TempFileManager(const TempFileManager &) = delete;
+  TempFileManager &operator=(const TempFileManager &) = delete;
+
+  /**
+   * Creates a new, empty temporary file.
+   */
+  File create();
+
+  /**
+   * Discards the pages of <file> from the buffer pool without writing them
+   * back and forgets the file.  Its storage is released once no File object
+   * refers to it any more.
+   *
+   * @param file  File returned by create().
+   * @throws  PagePinnedException  If a page of the file is pinned.
+   */
+  void drop(File &file);
+
+  /**
+   * Returns the path of the temporary directory.
+   */
+  const std::string &directory() const { return directory_; }
+
+  /**
+   * Returns the number of files created and not yet dropped.
+   */
+  std::size_t num_open() const { return files_.size(); }
+
+ private:
+  /**
+   * Buffer manager caching pages of the temporary files.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * Path of the temporary directory.
+   */
+  std::string directory_;
+
+  /**
+   * Number of files created so far; used to name them.
+   */
+  std::size_t counter_;
+
+  /**
+   * Files created and not yet dropped, by name.
+   */
+  std::map<std::string, File> files_;
+};
+
+}  // namespace badgerdb
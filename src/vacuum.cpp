@@ -0,0 +1,146 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "vacuum.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "exceptions/page_pinned_exception.h"
+#include "file_iterator.h"
+#include "page.h"
+#include "page_iterator.h"
+
+namespace badgerdb {
+
+Vacuum::Vacuum(BufMgr *bufMgr, File *file, RelocationCallback relocate,
+               const double max_fill)
+    : bufMgr_(bufMgr),
+      file_(file),
+      relocate_(std::move(relocate)),
+      max_fill_(max_fill) {
+  assert(bufMgr_ != NULL);
+  assert(file_ != NULL);
+}
+
+VacuumReport Vacuum::run() {
+  VacuumReport report = VacuumReport();
+
+  // Measure through the buffer manager, which may hold newer versions of
+  // the pages than the file.
+  std::vector<std::pair<std::size_t, PageId>> sparse;
+  std::vector<PageId> page_numbers;
+  for (FileIterator iter = file_->begin(); iter != file_->end(); ++iter) {
+    page_numbers.push_back(iter.page_number());
+  }
+  for (const PageId page_number : page_numbers) {
+    Page *page;
+    bufMgr_->readPage(*file_, page_number, page, LatchMode::SHARED);
+    const bool slotted = page->page_type() == PageType::SLOTTED;
+    const std::size_t used = Page::DATA_SIZE - page->getFreeSpace();
+    bufMgr_->unPinPage(*file_, page_number, false, LatchMode::SHARED);
+    if (!slotted) {
+      continue;
+    }
+    ++report.pages_scanned;
+    if (used < max_fill_ * Page::DATA_SIZE) {
+      sparse.push_back(std::make_pair(used, page_number));
+    }
+  }
+  report.sparse_pages = sparse.size();
+
+  // Fullest pages first: they take records from the emptiest ones.
+  std::sort(sparse.begin(), sparse.end(),
+            [](const std::pair<std::size_t, PageId> &a,
+               const std::pair<std::size_t, PageId> &b) {
+              return a.first > b.first ||
+                     (a.first == b.first && a.second < b.second);
+            });
+  std::vector<PageId> targets;
+  for (const std::pair<std::size_t, PageId> &entry : sparse) {
+    targets.push_back(entry.second);
+  }
+
+  std::size_t first = 0;
+  for (std::size_t last = targets.size(); last > first + 1; --last) {
+    const PageId source = targets[last - 1];
+    if (!drain(source, targets, &first, last - 1, &report)) {
+      continue;
+    }
+    // A reader may have pinned the emptied page since drain() released it;
+    // it stays in the file, empty, rather than being freed under the reader.
+    try {
+      bufMgr_->disposePage(*file_, source);
+      ++report.pages_freed;
+    } catch (const PagePinnedException &) {
+    }
+  }
+  report.bytes_reclaimed = report.pages_freed * Page::SIZE;
+  return report;
+}
+
+bool Vacuum::drain(const PageId source, const std::vector<PageId> &targets,
+                   std::size_t *first, const std::size_t end,
+                   VacuumReport *report) {
+  Page *source_page;
+  bufMgr_->readPage(*file_, source, source_page, LatchMode::EXCLUSIVE);
+  Page *target_page = NULL;
+  bool source_dirty = false;
+  bool target_dirty = false;
+  bool emptied = true;
+
+  for (PageIterator iter = source_page->begin(); iter != source_page->end();
+       ++iter) {
+    const RecordId from = iter.current_record();
+    const std::string record = source_page->getRecord(from);
+    while (*first < end &&
+           (target_page == NULL || !target_page->hasSpaceForRecord(record))) {
+      if (target_page != NULL) {
+        bufMgr_->unPinPage(*file_, targets[*first], target_dirty,
+                           LatchMode::EXCLUSIVE);
+        target_page = NULL;
+        target_dirty = false;
+        ++*first;
+        continue;
+      }
+      bufMgr_->readPage(*file_, targets[*first], target_page,
+                        LatchMode::EXCLUSIVE);
+    }
+    if (target_page == NULL) {
+      // Every target is full.
+      emptied = false;
+      break;
+    }
+
+    // Slot flags travel with the record, e.g. to keep overflow pointers.
+    const RecordId to = target_page->insertRecord(
+        record, source_page->getRecordFlags(from));
+    if (relocate_(from, to)) {
+      source_page->deleteRecord(from);
+      source_dirty = true;
+      target_dirty = true;
+      ++report->records_moved;
+    } else {
+      target_page->deleteRecord(to);
+      ++report->records_kept;
+      emptied = false;
+    }
+  }
+
+  if (target_page != NULL) {
+    bufMgr_->unPinPage(*file_, targets[*first], target_dirty,
+                       LatchMode::EXCLUSIVE);
+  }
+  bufMgr_->unPinPage(*file_, source, source_dirty, LatchMode::EXCLUSIVE);
+  return emptied;
+}
+
+}  // namespace badgerdb
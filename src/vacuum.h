@@ -0,0 +1,140 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "buffer.h"
+#include "file.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Outcome of a Vacuum run.
+ */
+struct VacuumReport {
+  /**
+   * Number of slotted pages examined.
+   */
+  std::size_t pages_scanned;
+
+  /**
+   * Number of pages filled below the threshold.
+   */
+  std::size_t sparse_pages;
+
+  /**
+   * Number of records moved to another page.
+   */
+  std::size_t records_moved;
+
+  /**
+   * Number of records the relocation callback kept in place.
+   */
+  std::size_t records_kept;
+
+  /**
+   * Number of emptied pages released with BufMgr::disposePage().
+   */
+  std::size_t pages_freed;
+
+  /**
+   * Bytes of the file released for reuse: pages_freed whole pages.
+   */
+  std::size_t bytes_reclaimed;
+};
+
+/**
+ * @brief Merges the records of sparsely filled slotted pages into fewer pages
+ * and frees the pages emptied that way.
+ *
+ * Pages whose records take up less than a given fraction of the data area
+ * are sparse.  Records of the emptiest sparse pages are moved into the
+ * fullest sparse pages that still have room, through the buffer manager and
+ * under exclusive latches on both pages, so concurrent readers see every
+ * record on exactly one of them.  Each move asks a relocation callback
+ * first, which is where references to the record, e.g. index entries, are
+ * redirected; a record the callback refuses stays where it is, and so does
+ * its page, as does an emptied page a reader pinned before it could be
+ * freed.  Freed pages go on the file's free list; BufMgr::compactFile()
+ * returns them to the filesystem.
+ *
+ * A vacuum can run on a background thread, e.g. posted to an Executor,
+ * while other threads read the file through the same buffer manager.  Run
+ * at most one vacuum per file at a time.
+ */
+class Vacuum {
+ public:
+  /**
+   * Called after a record has been copied from <from> to <to> and before it
+   * is deleted at <from>, with both pages latched exclusively.  Returns
+   * false to keep the record at <from>, in which case the copy is deleted.
+   * Must not access either page through the buffer manager.
+   */
+  typedef std::function<bool(const RecordId &from, const RecordId &to)>
+      RelocationCallback;
+
+  /**
+   * Fill fraction below which pages are compacted unless given otherwise.
+   */
+  static constexpr double DEFAULT_MAX_FILL = 0.5;
+
+  /**
+   * Constructs a vacuum for <file>.
+   *
+   * @param bufMgr    Buffer manager to access the file through.
+   * @param file      File to compact.
+   * @param relocate  Callback approving and announcing record moves.
+   * @param max_fill  Pages with records taking up less than this fraction of
+   *                  Page::DATA_SIZE are compacted.
+   */
+  Vacuum(BufMgr *bufMgr, File *file, RelocationCallback relocate,
+         const double max_fill = DEFAULT_MAX_FILL);
+
+  /**
+   * Compacts the sparse pages of the file once and reports what was done.
+   */
+  VacuumReport run();
+
+ private:
+  /**
+   * Moves the records of page <source> into the pages of <targets> from
+   * index <*first> on, advancing <*first> past pages that are full.
+   *
+   * @return  True if the source page was emptied.
+   */
+  bool drain(const PageId source, const std::vector<PageId> &targets,
+             std::size_t *first, const std::size_t end,
+             VacuumReport *report);
+
+  /**
+   * Buffer manager to access the file through.
+   */
+  BufMgr *bufMgr_;
+
+  /**
+   * File to compact.
+   */
+  File *file_;
+
+  /**
+   * Callback approving and announcing record moves.
+   */
+  RelocationCallback relocate_;
+
+  /**
+   * Fill fraction below which pages are compacted.
+   */
+  double max_fill_;
+};
+
+}  // namespace badgerdb